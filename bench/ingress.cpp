@@ -0,0 +1,259 @@
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <agent/connection.hpp>
+#include <agent/distributor.hpp>
+#include <agent/environment.hpp>
+#include <agent/ingress.hpp>
+#include <agent/session.hpp>
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+using tcp = net::ip::tcp;
+
+namespace agent = ngx::agent;
+
+/**
+ * @brief 进程累计 CPU 时间（用户态 + 内核态）
+ * @return 秒
+ */
+double process_cpu_seconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    const auto to_seconds = [](const FILETIME &ft)
+    {
+        ULARGE_INTEGER value;
+        value.LowPart = ft.dwLowDateTime;
+        value.HighPart = ft.dwHighDateTime;
+        return static_cast<double>(value.QuadPart) / 1e7;
+    };
+    return to_seconds(kernel) + to_seconds(user);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto to_seconds = [](const timeval &tv)
+    {
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+    };
+    return to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+#endif
+}
+
+/**
+ * @brief 上游数据源：每接受一个连接就写出 `each` 字节再关闭
+ */
+net::awaitable<void> upstream_producer(tcp::acceptor &acceptor, const std::size_t streams, const std::uint64_t each)
+{
+    for (std::size_t i = 0; i < streams; ++i)
+    {
+        tcp::socket socket = co_await acceptor.async_accept(net::use_awaitable);
+        net::co_spawn(acceptor.get_executor(), [socket = std::move(socket), each]() mutable -> net::awaitable<void>
+        {
+            std::vector<char> chunk(64 * 1024, 'x');
+            std::uint64_t sent = 0;
+            while (sent < each)
+            {
+                const auto n = static_cast<std::size_t>(std::min<std::uint64_t>(chunk.size(), each - sent));
+                co_await net::async_write(socket, net::buffer(chunk.data(), n), net::use_awaitable);
+                sent += n;
+            }
+            boost::system::error_code ec;
+            socket.shutdown(tcp::socket::shutdown_both, ec);
+        }, net::detached);
+    }
+}
+
+/**
+ * @brief 远端 ForwardEngine：每个连接交给 `session`（obscura 多路复用）
+ */
+net::awaitable<void> remote_accept(tcp::acceptor &acceptor, net::io_context &ioc, agent::distributor &dist,
+    std::shared_ptr<ssl::context> ssl_ctx, const agent::environment &env)
+{
+    while (true)
+    {
+        tcp::socket socket = co_await acceptor.async_accept(net::use_awaitable);
+        std::make_shared<agent::session<tcp::socket>>(ioc, std::move(socket), dist, ssl_ctx, env)->start();
+    }
+}
+
+/**
+ * @brief 客户端：经本地 ingress 的 CONNECT 隧道下载到 EOF
+ * @return 实际收到的隧道字节数
+ */
+net::awaitable<std::uint64_t> client_download(const tcp::endpoint ingress_ep, const tcp::endpoint upstream_ep)
+{
+    tcp::socket socket(co_await net::this_coro::executor);
+    co_await socket.async_connect(ingress_ep, net::use_awaitable);
+
+    const std::string request = std::format("CONNECT {}:{} HTTP/1.1\r\nHost: {}:{}\r\n\r\n",
+        upstream_ep.address().to_string(), upstream_ep.port(), upstream_ep.address().to_string(), upstream_ep.port());
+    co_await net::async_write(socket, net::buffer(request), net::use_awaitable);
+
+    std::vector<char> buf(64 * 1024);
+    std::string head;
+    bool established = false;
+    std::uint64_t received = 0;
+    while (true)
+    {
+        boost::system::error_code ec;
+        const std::size_t n = co_await socket.async_read_some(net::buffer(buf), net::redirect_error(net::use_awaitable, ec));
+        if (ec || n == 0)
+        {
+            break;
+        }
+
+        if (established)
+        {
+            received += n;
+            continue;
+        }
+
+        // 跳过 CONNECT 响应头，同一次读到的剩余部分计入隧道数据
+        head.append(buf.data(), n);
+        if (const auto pos = head.find("\r\n\r\n"); pos != std::string::npos)
+        {
+            established = true;
+            received += head.size() - (pos + 4);
+        }
+    }
+    co_return received;
+}
+
+/**
+ * @brief 取一个当前空闲的本地端口
+ */
+unsigned short free_port(net::io_context &ioc)
+{
+    tcp::acceptor probe(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+    return probe.local_endpoint().port();
+}
+
+int main(int argc, char *argv[])
+{
+    // 用法：ingress_bench <cert.pem> <key.pem> [MiB] [streams] [connections]
+    if (argc < 3)
+    {
+        std::cerr << "usage: ingress_bench <cert.pem> <key.pem> [MiB] [streams] [connections]" << std::endl;
+        return 1;
+    }
+    const std::uint64_t mebibytes = argc > 3 ? std::stoull(argv[3]) : 1024;
+    const std::size_t streams = argc > 4 ? std::max<std::size_t>(std::stoul(argv[4]), 1) : 1;
+    const std::size_t connections = argc > 5 ? std::max<std::size_t>(std::stoul(argv[5]), 1) : 1;
+    const std::uint64_t each = mebibytes * 1024 * 1024 / streams;
+    const std::uint64_t total = each * streams;
+
+    try
+    {
+        net::io_context ioc;
+        agent::source pool(ioc);
+        agent::distributor dist(pool, ioc);
+
+        // 远端：obscura 服务端，开启多路复用
+        agent::option remote_option;
+        remote_option.multiplex.path = "/mux";
+        agent::environment env;
+        env.config = &remote_option;
+
+        auto ssl_ctx = std::make_shared<ssl::context>(ssl::context::tls_server);
+        agent::modernize(*ssl_ctx);
+        ssl_ctx->use_certificate_chain_file(argv[1]);
+        ssl_ctx->use_private_key_file(argv[2], ssl::context::pem);
+
+        tcp::acceptor upstream_acceptor(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+        tcp::acceptor remote_acceptor(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+        const auto upstream_ep = upstream_acceptor.local_endpoint();
+        const auto remote_ep = remote_acceptor.local_endpoint();
+
+        // 本地：ingress 独占一个线程
+        agent::option local_option;
+        local_option.ingress.host = "127.0.0.1";
+        local_option.ingress.port = remote_ep.port();
+        local_option.ingress.path = "/mux";
+        local_option.ingress.verify = false;
+        local_option.ingress.min = connections;
+        local_option.ingress.max = connections;
+        local_option.ingress.local = free_port(ioc);
+        const tcp::endpoint ingress_ep(net::ip::make_address("127.0.0.1"), local_option.ingress.local);
+
+        agent::ingress entry(local_option);
+        std::jthread entry_thread([&entry]
+        {
+            entry.run();
+        });
+
+        net::co_spawn(ioc, upstream_producer(upstream_acceptor, streams, each), net::detached);
+        net::co_spawn(ioc, remote_accept(remote_acceptor, ioc, dist, ssl_ctx, env), net::detached);
+
+        // 等常驻连接建立后再计时，只测稳态转发
+        std::jthread server_thread([&ioc]
+        {
+            auto guard = net::make_work_guard(ioc);
+            ioc.run();
+        });
+        const auto wait_begin = std::chrono::steady_clock::now();
+        while (entry.established() < connections)
+        {
+            if (std::chrono::steady_clock::now() - wait_begin > std::chrono::seconds(10))
+            {
+                throw std::runtime_error("ingress connections not established");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        net::io_context clients;
+        std::atomic<std::uint64_t> received{0};
+        for (std::size_t i = 0; i < streams; ++i)
+        {
+            net::co_spawn(clients, client_download(ingress_ep, upstream_ep), [&received](const std::exception_ptr &ep, const std::uint64_t n)
+            {
+                if (ep)
+                {
+                    std::rethrow_exception(ep);
+                }
+                received += n;
+            });
+        }
+
+        const double cpu_begin = process_cpu_seconds();
+        const auto wall_begin = std::chrono::steady_clock::now();
+        clients.run();
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_begin).count();
+        const double cpu = process_cpu_seconds() - cpu_begin;
+
+        entry.stop();
+        ioc.stop();
+
+        const double gigabytes = static_cast<double>(received) / (1024.0 * 1024.0 * 1024.0);
+        std::cout << std::format("streams         : {} over {} connection(s)\n", streams, connections);
+        std::cout << std::format("bytes           : {} / {}\n", received.load(), total);
+        std::cout << std::format("wall            : {:.3f} s ({:.2f} Gbit/s)\n", wall, gigabytes * 8.0 / wall);
+        std::cout << std::format("cpu             : {:.3f} s ({:.3f} s/GB, both ends)\n", cpu, cpu / gigabytes);
+
+        if (received != total)
+        {
+            std::cerr << "ingress_bench: short transfer" << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << std::format("ingress_bench failed: {}", e.what()) << std::endl;
+        return 1;
+    }
+    return 0;
+}
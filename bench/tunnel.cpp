@@ -0,0 +1,397 @@
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <agent/connection.hpp>
+#include <agent/distributor.hpp>
+#include <agent/environment.hpp>
+#include <agent/reservoir.hpp>
+#include <agent/session.hpp>
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#ifdef __linux__
+    #include <atomic>
+    #include <fstream>
+    #include <dlfcn.h>
+    #include <unistd.h>
+    #include <sys/epoll.h>
+    #include <sys/ioctl.h>
+    #include <sys/socket.h>
+    #include <sys/syscall.h>
+    #include <sys/timerfd.h>
+    #include <linux/perf_event.h>
+#endif
+
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+using tcp = net::ip::tcp;
+
+namespace agent = ngx::agent;
+
+/**
+ * @brief 进程累计 CPU 时间（用户态 + 内核态）
+ * @return 秒
+ */
+double process_cpu_seconds()
+{
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    const auto to_seconds = [](const FILETIME &ft)
+    {
+        ULARGE_INTEGER value;
+        value.LowPart = ft.dwLowDateTime;
+        value.HighPart = ft.dwHighDateTime;
+        return static_cast<double>(value.QuadPart) / 1e7;
+    };
+    return to_seconds(kernel) + to_seconds(user);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto to_seconds = [](const timeval &tv)
+    {
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+    };
+    return to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+#endif
+}
+
+#ifdef __linux__
+namespace
+{
+    /**
+     * @brief 经 libc 包装函数发起的、事件循环与收发路径上的系统调用次数
+     * @details 基准程序自身定义同名函数，进程内对它们的调用先到这里计数，再转给 libc 的实现。
+     */
+    std::atomic<std::uint64_t> wrapped_syscalls{0};
+
+    template <typename Function>
+    Function next_symbol(const char *name)
+    {
+        return reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+    }
+}
+
+extern "C"
+{
+    ssize_t recv(int fd, void *buf, size_t n, int flags)
+    {
+        static const auto real = next_symbol<ssize_t (*)(int, void *, size_t, int)>("recv");
+        wrapped_syscalls.fetch_add(1, std::memory_order_relaxed);
+        return real(fd, buf, n, flags);
+    }
+
+    ssize_t send(int fd, const void *buf, size_t n, int flags)
+    {
+        static const auto real = next_symbol<ssize_t (*)(int, const void *, size_t, int)>("send");
+        wrapped_syscalls.fetch_add(1, std::memory_order_relaxed);
+        return real(fd, buf, n, flags);
+    }
+
+    ssize_t recvmsg(int fd, msghdr *message, int flags)
+    {
+        static const auto real = next_symbol<ssize_t (*)(int, msghdr *, int)>("recvmsg");
+        wrapped_syscalls.fetch_add(1, std::memory_order_relaxed);
+        return real(fd, message, flags);
+    }
+
+    ssize_t sendmsg(int fd, const msghdr *message, int flags)
+    {
+        static const auto real = next_symbol<ssize_t (*)(int, const msghdr *, int)>("sendmsg");
+        wrapped_syscalls.fetch_add(1, std::memory_order_relaxed);
+        return real(fd, message, flags);
+    }
+
+    int epoll_wait(int epfd, epoll_event *events, int maxevents, int timeout)
+    {
+        static const auto real = next_symbol<int (*)(int, epoll_event *, int, int)>("epoll_wait");
+        wrapped_syscalls.fetch_add(1, std::memory_order_relaxed);
+        return real(epfd, events, maxevents, timeout);
+    }
+
+    int epoll_ctl(int epfd, int op, int fd, epoll_event *event) noexcept
+    {
+        static const auto real = next_symbol<int (*)(int, int, int, epoll_event *)>("epoll_ctl");
+        wrapped_syscalls.fetch_add(1, std::memory_order_relaxed);
+        return real(epfd, op, fd, event);
+    }
+
+    int timerfd_settime(int fd, int flags, const itimerspec *value, itimerspec *old) noexcept
+    {
+        static const auto real = next_symbol<int (*)(int, int, const itimerspec *, itimerspec *)>("timerfd_settime");
+        wrapped_syscalls.fetch_add(1, std::memory_order_relaxed);
+        return real(fd, flags, value, old);
+    }
+}
+#endif
+
+/**
+ * @brief 系统调用计数器
+ * @details 优先使用 `raw_syscalls:sys_enter` 跟踪点（精确统计本进程的全部系统调用，包括 `io_uring_enter`），
+ * 没有 tracefs 或权限不足时退回 libc 包装函数计数（只覆盖 epoll 后端事件循环与收发路径上的调用）。
+ */
+class syscall_counter
+{
+public:
+    syscall_counter()
+    {
+#ifdef __linux__
+        for (const char *path : {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+                 "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"})
+        {
+            std::ifstream file(path);
+            std::uint64_t id = 0;
+            if (!(file >> id))
+            {
+                continue;
+            }
+
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_TRACEPOINT;
+            attr.size = sizeof(attr);
+            attr.config = id;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fd_ >= 0)
+            {
+                break;
+            }
+        }
+#endif
+    }
+
+    syscall_counter(const syscall_counter &) = delete;
+    syscall_counter &operator=(const syscall_counter &) = delete;
+
+    ~syscall_counter()
+    {
+#ifdef __linux__
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+#endif
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        if (fd_ >= 0)
+        {
+            ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            return;
+        }
+        begin_ = wrapped_syscalls.load(std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @brief 自 `start` 以来的系统调用次数
+     */
+    [[nodiscard]] std::uint64_t stop()
+    {
+#ifdef __linux__
+        if (fd_ >= 0)
+        {
+            ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            std::uint64_t count = 0;
+            if (::read(fd_, &count, sizeof(count)) != sizeof(count))
+            {
+                return 0;
+            }
+            return count;
+        }
+        return wrapped_syscalls.load(std::memory_order_relaxed) - begin_;
+#else
+        return 0;
+#endif
+    }
+
+    [[nodiscard]] std::string_view source() const noexcept
+    {
+#ifdef __linux__
+        return fd_ >= 0 ? "raw_syscalls tracepoint" : "libc wrappers, epoll path only";
+#else
+        return "unavailable";
+#endif
+    }
+
+private:
+    int fd_ = -1;
+    std::uint64_t begin_ = 0;
+}; // class syscall_counter
+
+/**
+ * @brief 上下文切换次数（自愿 + 非自愿）
+ */
+std::uint64_t context_switches()
+{
+#ifdef _WIN32
+    return 0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<std::uint64_t>(usage.ru_nvcsw) + static_cast<std::uint64_t>(usage.ru_nivcsw);
+#endif
+}
+
+/**
+ * @brief 上游数据源：接受一个连接后持续写出 `total` 字节再关闭
+ * @param acceptor 监听 acceptor (按值传递以接管所有权)
+ * @param total 需要写出的总字节数
+ */
+net::awaitable<void> upstream_producer(tcp::acceptor acceptor, const std::uint64_t total)
+{
+    tcp::socket socket = co_await acceptor.async_accept(net::use_awaitable);
+    std::vector<char> chunk(64 * 1024, 'x');
+
+    std::uint64_t sent = 0;
+    while (sent < total)
+    {
+        const auto n = static_cast<std::size_t>(std::min<std::uint64_t>(chunk.size(), total - sent));
+        co_await net::async_write(socket, net::buffer(chunk.data(), n), net::use_awaitable);
+        sent += n;
+    }
+
+    boost::system::error_code ec;
+    socket.shutdown(tcp::socket::shutdown_both, ec);
+    socket.close(ec);
+}
+
+/**
+ * @brief 代理服务器接受一个连接并交给 `session`
+ */
+net::awaitable<void> proxy_accept_one(tcp::acceptor acceptor, net::io_context &ioc, agent::distributor &dist,
+    const agent::environment &env)
+{
+    tcp::socket socket = co_await acceptor.async_accept(net::use_awaitable);
+    std::make_shared<agent::session<tcp::socket>>(ioc, std::move(socket), dist, nullptr, env)->start();
+}
+
+/**
+ * @brief 客户端：通过 CONNECT 建立隧道后读到 EOF
+ * @return 实际收到的隧道字节数
+ */
+net::awaitable<std::uint64_t> client_download(const tcp::endpoint proxy_ep, const tcp::endpoint upstream_ep)
+{
+    tcp::socket socket(co_await net::this_coro::executor);
+    co_await socket.async_connect(proxy_ep, net::use_awaitable);
+
+    const std::string request = std::format("CONNECT {}:{} HTTP/1.1\r\nHost: {}:{}\r\n\r\n",
+        upstream_ep.address().to_string(), upstream_ep.port(), upstream_ep.address().to_string(), upstream_ep.port());
+    co_await net::async_write(socket, net::buffer(request), net::use_awaitable);
+
+    std::vector<char> buf(64 * 1024);
+    std::string head;
+    bool established = false;
+    std::uint64_t received = 0;
+    while (true)
+    {
+        boost::system::error_code ec;
+        const std::size_t n = co_await socket.async_read_some(net::buffer(buf), net::redirect_error(net::use_awaitable, ec));
+        if (ec || n == 0)
+        {
+            break;
+        }
+
+        if (established)
+        {
+            received += n;
+            continue;
+        }
+
+        // 跳过 CONNECT 响应头，同一次读到的剩余部分计入隧道数据
+        head.append(buf.data(), n);
+        if (const auto pos = head.find("\r\n\r\n"); pos != std::string::npos)
+        {
+            established = true;
+            received += head.size() - (pos + 4);
+        }
+    }
+    co_return received;
+}
+
+int main(int argc, char *argv[])
+{
+    // 用法：tunnel_bench [MiB] [reservoir_slots]
+    const std::uint64_t mebibytes = argc > 1 ? std::stoull(argv[1]) : 1024;
+    const std::size_t slots = argc > 2 ? std::stoul(argv[2]) : 0;
+    const std::uint64_t total = mebibytes * 1024 * 1024;
+
+    try
+    {
+        net::io_context ioc;
+        agent::source pool(ioc);
+        agent::distributor dist(pool, ioc);
+
+        agent::reservoir buffers(ioc, slots);
+        agent::environment env;
+        if (slots != 0)
+        {
+            env.buffers = &buffers;
+        }
+
+        tcp::acceptor upstream_acceptor(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+        tcp::acceptor proxy_acceptor(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+        const auto upstream_ep = upstream_acceptor.local_endpoint();
+        const auto proxy_ep = proxy_acceptor.local_endpoint();
+
+        std::uint64_t received = 0;
+        net::co_spawn(ioc, upstream_producer(std::move(upstream_acceptor), total), net::detached);
+        net::co_spawn(ioc, proxy_accept_one(std::move(proxy_acceptor), ioc, dist, env), net::detached);
+        net::co_spawn(ioc, client_download(proxy_ep, upstream_ep), [&received](const std::exception_ptr &ep, const std::uint64_t n)
+        {
+            if (ep)
+            {
+                std::rethrow_exception(ep);
+            }
+            received = n;
+        });
+
+        syscall_counter syscalls;
+        const std::uint64_t switches_begin = context_switches();
+        const double cpu_begin = process_cpu_seconds();
+        const auto wall_begin = std::chrono::steady_clock::now();
+        syscalls.start();
+        ioc.run();
+        const std::uint64_t calls = syscalls.stop();
+        const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_begin).count();
+        const double cpu = process_cpu_seconds() - cpu_begin;
+        const std::uint64_t switches = context_switches() - switches_begin;
+
+        const double gigabytes = static_cast<double>(received) / (1024.0 * 1024.0 * 1024.0);
+        std::cout << std::format("backend         : {}\n", agent::reactor_backend());
+        std::cout << std::format("registered bufs : {}\n", buffers.registered() ? "yes" : "no");
+        std::cout << std::format("bytes           : {} / {}\n", received, total);
+        std::cout << std::format("wall            : {:.3f} s ({:.2f} Gbit/s)\n", wall, gigabytes * 8.0 / wall);
+        std::cout << std::format("cpu             : {:.3f} s ({:.3f} s/GB)\n", cpu, cpu / gigabytes);
+        std::cout << std::format("syscalls        : {} ({:.0f} /GB, {})\n", calls,
+            static_cast<double>(calls) / gigabytes, syscalls.source());
+        std::cout << std::format("ctx switches    : {} ({:.0f} /GB)\n", switches, static_cast<double>(switches) / gigabytes);
+
+        if (received != total)
+        {
+            std::cerr << "tunnel_bench: short transfer" << std::endl;
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << std::format("tunnel_bench failed: {}", e.what()) << std::endl;
+        return 1;
+    }
+    return 0;
+}
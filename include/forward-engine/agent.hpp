@@ -1,11 +1,28 @@
 #pragma once
 
 #include <agent/frame.hpp>
+#include <agent/option.hpp>
+#include <agent/zerocopy.hpp>
+#include <agent/reservoir.hpp>
+#include <agent/wheel.hpp>
+#include <agent/admission.hpp>
+#include <agent/quota.hpp>
+#include <agent/shaper.hpp>
+#include <agent/multiplex.hpp>
+#include <agent/ticket.hpp>
+#include <agent/offload.hpp>
+#include <agent/environment.hpp>
 #include <agent/connection.hpp>
+#include <agent/balancer.hpp>
+#include <agent/health.hpp>
+#include <agent/router.hpp>
+#include <agent/snapshot.hpp>
 #include <agent/distributor.hpp>
 #include <agent/session.hpp>
 #include <agent/obscura.hpp>
 #include <agent/adaptation.hpp>
 #include <agent/positive.hpp>
 #include <agent/reverse.hpp>
-#include <agent/worker.hpp>
\ No newline at end of file
+#include <agent/worker.hpp>
+#include <agent/standby.hpp>
+#include <agent/ingress.hpp>
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <boost/asio.hpp>
+#include "option.hpp"
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @brief 准入控制
+     * @details 每个 `worker` 一份，统计存活会话数、会话缓冲内存和事件循环延迟（周期定时器的实际唤醒滞后，取指数滑动平均）。
+     * `worker` 在接入时调用 `judge` 决定放行、快速拒绝还是暂停接入；会话持有 `ticket`，析构时自动归还计数。
+     * @note 计数全部是原子量，多线程运行同一个 `io_context` 时无需加锁。
+     */
+    class admission
+    {
+    public:
+        /**
+         * @brief 准入结论
+         */
+        enum class verdict
+        {
+            admit, // 放行
+            shed,  // 超过软上限：快速拒绝
+            pause  // 超过硬上限：暂停接入
+        };
+
+        /**
+         * @brief 准入凭证
+         * @details 由会话持有，记录会话数与其占用的缓冲内存，析构时归还。
+         */
+        class ticket
+        {
+        public:
+            ticket() = default;
+            ticket(admission *owner, std::size_t bytes) noexcept;
+            ticket(ticket &&other) noexcept;
+            ticket &operator=(ticket &&other) noexcept;
+            ticket(const ticket &) = delete;
+            ticket &operator=(const ticket &) = delete;
+            ~ticket();
+
+            /**
+             * @brief 追加计入缓冲内存（例如会话启用零拷贝发送块后）
+             */
+            void charge(std::size_t bytes) noexcept;
+
+            /**
+             * @brief 归还此前追加的缓冲内存（例如多路复用的流关闭后）
+             */
+            void refund(std::size_t bytes) noexcept;
+
+        private:
+            void reset() noexcept;
+
+            admission *owner_ = nullptr;
+            std::size_t bytes_ = 0;
+        }; // class ticket
+
+        admission(net::io_context &ioc, const option::admission_option &opt);
+
+        void start();
+        void stop();
+
+        [[nodiscard]] verdict judge() const noexcept;
+        [[nodiscard]] ticket admit(std::size_t bytes) noexcept;
+
+        /**
+         * @brief 按配置的方式拒绝一个已接入的连接
+         * @details 只做一次非阻塞发送再关闭，不创建协程，开销与接入本身相当。
+         */
+        void refuse(tcp::socket &socket) const noexcept;
+
+        [[nodiscard]] std::size_t sessions() const noexcept
+        {
+            return sessions_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::size_t memory() const noexcept
+        {
+            return memory_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::chrono::microseconds lag() const noexcept
+        {
+            return std::chrono::microseconds(lag_.load(std::memory_order_relaxed));
+        }
+
+        [[nodiscard]] std::chrono::milliseconds interval() const noexcept
+        {
+            return option_.interval;
+        }
+
+    private:
+        void sample();
+
+        const option::admission_option &option_;
+        net::steady_timer timer_;
+        std::chrono::steady_clock::time_point expected_;
+
+        std::atomic<std::size_t> sessions_{0};
+        std::atomic<std::size_t> memory_{0};
+        std::atomic<std::int64_t> lag_{0}; // 微秒
+    }; // class admission
+}
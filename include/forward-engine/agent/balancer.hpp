@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <boost/asio.hpp>
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @brief 后端的运行时状态
+     * @details 以共享指针持有，连接可以安全地比所属分组活得更久。
+     * `up` 由 `health` 根据主动探测结果与被动驱逐状态维护，选择时只读这一个原子量。
+     */
+    struct backend_state
+    {
+        std::atomic<std::uint32_t> outstanding{0};  // 在途连接数：选中时加一，连接（经 `deleter`）释放时减一
+        std::atomic<bool> up{true};                 // 是否参与选择
+        std::atomic<bool> sick{false};              // 主动探测判定不健康
+        std::atomic<std::uint32_t> failures{0};     // 连续连接失败次数（被动）
+        std::atomic<std::int64_t> ejected_until{0}; // 被动驱逐截止时刻（`steady_clock` 纳秒），0 表示未驱逐
+        std::uint32_t streak = 0;                   // 主动探测连续与当前判定相反的次数（仅探测协程访问）
+    }; // struct backend_state
+
+    /**
+     * @brief 反向代理后端
+     */
+    struct backend
+    {
+        tcp::endpoint endpoint;
+        std::uint32_t weight = 1;
+        std::shared_ptr<backend_state> state = std::make_shared<backend_state>();
+
+        [[nodiscard]] bool usable() const noexcept
+        {
+            return state->up.load(std::memory_order_relaxed);
+        }
+    }; // struct backend
+
+    /**
+     * @brief 请求的亲和键来源，供一致性哈希使用
+     */
+    struct affinity
+    {
+        net::ip::address client; // 客户端地址
+        std::string_view path;   // 请求路径
+    }; // struct affinity
+
+    /**
+     * @brief 负载均衡器
+     * @details 一个反向代理主机对应一个均衡器，持有该主机的全部后端。选择在多个线程上并发调用，实现不得加锁：
+     * - `swrr`：平滑加权轮询，调度序列在构造时预先展开，选择为一次原子自增加取模；
+     * - `least`：在途连接数 / 权重最小者，逐个比较，适合后端数量很少的分组；
+     * - `p2c`：随机取两个后端，选在途连接数 / 权重较小者；
+     * - `maglev`：Maglev 一致性哈希，按客户端地址或请求路径查 65537 项的查找表，后端增减时大部分键映射不变。
+     *
+     * 不可用（`usable` 为假）的后端被跳过；全部不可用时不再跳过，照常选择，避免整组拒绝服务。
+     */
+    class balancer
+    {
+    public:
+        /**
+         * @brief 均衡策略
+         */
+        enum class strategy
+        {
+            swrr,
+            least,
+            p2c,
+            maglev
+        };
+
+        /**
+         * @brief 一致性哈希的键
+         */
+        enum class hash_key
+        {
+            client, // 客户端地址
+            path    // 请求路径
+        };
+
+        virtual ~balancer() = default;
+
+        /**
+         * @brief 为一次请求选择后端
+         * @param hint 请求的亲和键，只有一致性哈希使用
+         */
+        [[nodiscard]] virtual const backend &select(const affinity &hint) noexcept = 0;
+
+        [[nodiscard]] const std::vector<backend> &backends() const noexcept
+        {
+            return backends_;
+        }
+
+        [[nodiscard]] static std::unique_ptr<balancer> make(strategy kind, std::vector<backend> backends,
+            hash_key key = hash_key::client);
+
+    protected:
+        explicit balancer(std::vector<backend> backends);
+
+        [[nodiscard]] const backend &fallback(const backend &chosen) const noexcept;
+
+        std::vector<backend> backends_; // 构造后不再变化，至少一个
+    }; // class balancer
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace ngx::agent
+{
+    /**
+     * @brief 标准 base64 编解码（RFC 4648，带填充）
+     * @note 用于 obscura 在升级请求头里携带首包，与具体协议类型无关，因此不放在模板里。
+     */
+    struct base64
+    {
+        [[nodiscard]] static std::string encode(std::string_view data);
+        [[nodiscard]] static bool decode(std::string_view text, std::string &data);
+    }; // struct base64
+} // namespace ngx::agent
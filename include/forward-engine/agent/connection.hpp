@@ -2,6 +2,8 @@
 
 #pragma once
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <unordered_map>
@@ -46,12 +48,14 @@ namespace ngx::agent
 
     /**
      * @brief 连接缓存删除器
+     * @details `outstanding` 非空时是连接所属反向代理后端的在途计数，释放连接时减一。
      */
     struct deleter
     {
         source *pool = nullptr;
         tcp::endpoint endpoint{};
         bool has_endpoint = false;
+        std::shared_ptr<std::atomic<std::uint32_t>> outstanding{};
         void operator()(tcp::socket *ptr) const;
     }; // class deleter
 
@@ -1,15 +1,23 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <functional>
 #include <string>
 #include <string_view>
+#include <vector>
 #include <memory_resource>
 #include <memory/container.hpp>
 #include <boost/asio.hpp>
 #include "obscura.hpp"
 #include "connection.hpp"
+#include "balancer.hpp"
+#include "health.hpp"
+#include "router.hpp"
+#include "snapshot.hpp"
 #include <rule/blacklist.hpp>
+#include <rule/policy.hpp>
+#include <rule/acl.hpp>
 
 namespace ngx::agent
 {
@@ -17,7 +25,9 @@ namespace ngx::agent
 
     /**
      * @brief 分发容器
-     * @note 容器负责将数据分发到对应的会话中实现代理功能
+     * @note 容器负责将数据分发到对应的会话中实现代理功能。
+     * 路由表与黑名单保存在不可变快照里，`load_reverse_map` 可在运行期间从任意线程调用，
+     * 新快照构造完成后原子发布，正在路由的请求不受影响；加载失败时保留原快照。
      */
     class distributor
     {
@@ -64,18 +74,68 @@ namespace ngx::agent
         template <typename Key, typename Value>
         using unordered_map = memory::unordered_map<Key, Value, transparent_string_hash, transparent_string_equal>;
 
+        /**
+         * @brief 反向代理分组：均衡器与它的健康检查参数
+         */
+        struct upstream
+        {
+            std::shared_ptr<balancer> balance;
+            health_option check;
+        }; // struct upstream
+
+        /**
+         * @brief 上级代理，出站策略命中时经它的 HTTP `CONNECT` 建立隧道
+         */
+        struct parent_proxy
+        {
+            std::string host;
+            std::string port;
+        }; // struct parent_proxy
+
+        /**
+         * @brief 路由快照：反向代理表、黑名单、出站策略与客户端访问控制
+         * @details 由 `load_reverse_map` 整体构造后发布，发布后只读。
+         * `table` 把（主机，路径前缀）编译为 `upstreams` 的下标，`names` 以配置中的路由键索引同一批分组，供重新加载时沿用后端状态。
+         */
+        struct routing
+        {
+            explicit routing(std::pmr::memory_resource *mr)
+                : upstreams(mr), names(mr)
+            {
+            }
+
+            memory::vector<upstream> upstreams;
+            unordered_map<memory::string, std::uint32_t> names;
+            router table;
+            limit::blacklist blacklist;
+            rule::policy policy;
+            std::vector<parent_proxy> parents; // 下标即 `policy` 中的上级代理序号
+            rule::acl clients;                 // 接入时检查的客户端地址
+        }; // struct routing
+
     public:
         explicit distributor(source &pool, net::io_context &ioc, std::pmr::memory_resource *mr = std::pmr::new_delete_resource());
         void load_reverse_map(const std::string &file_path);
-        [[nodiscard]] net::awaitable<internal_ptr> route_reverse(std::string_view host);
+        [[nodiscard]] net::awaitable<internal_ptr> route_reverse(std::string_view host, affinity hint = {});
         [[nodiscard]] net::awaitable<internal_ptr> route_direct(tcp::endpoint ep) const;
         [[nodiscard]] net::awaitable<internal_ptr> route_forward(std::string_view host, std::string_view port);
+
+        /**
+         * @brief 客户端地址是否允许接入
+         * @note 读取当前快照，不分配内存，在接入循环中直接调用
+         */
+        [[nodiscard]] bool admit(const net::ip::address &client) const
+        {
+            return routing_.load().clients.permit(client);
+        }
     private:
+        [[nodiscard]] net::awaitable<internal_ptr> route_parent(parent_proxy parent, std::string_view host, std::string_view port);
 
         source &pool_;
         tcp::resolver resolver_;
-        limit::blacklist blacklist_;
         std::pmr::memory_resource *mr_;
-        unordered_map<memory::string, tcp::endpoint> reverse_map_;
+        snapshot<routing> routing_;
+        std::mutex reload_mutex_; // 串行化多个同时发生的重新加载
+        health health_;
     }; // class distributor
 }
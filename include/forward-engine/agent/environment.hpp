@@ -0,0 +1,37 @@
+#pragma once
+
+#include "option.hpp"
+#include "reservoir.hpp"
+#include "wheel.hpp"
+#include "admission.hpp"
+#include "offload.hpp"
+#include "shaper.hpp"
+
+namespace ngx::agent
+{
+    /**
+     * @brief 会话运行环境
+     * @details 汇总由 `worker` 持有、所有 `session` 共享的参数与资源，避免会话构造参数不断膨胀。
+     * 指针成员为空表示对应能力未启用，会话需要自行退化。
+     * @note 环境本身及其指向的对象都由 `worker` 持有，生命周期覆盖其下所有会话。
+     */
+    struct environment
+    {
+        const option *config = &option::defaults(); // 运行参数
+        reservoir *buffers = nullptr;                // 隧道缓冲池
+        wheel *timer = nullptr;                      // 会话超时时间轮
+        admission *gate = nullptr;                   // 准入控制
+        offload *handshake = nullptr;                // TLS 握手线程池
+        shaper *shaping = nullptr;                   // 隧道带宽整形
+        shaper::level bandwidth{};                   // 进程级全局带宽层级，多个 `worker` 共享时由调用方持有
+
+        /**
+         * @brief 默认环境：默认参数、不启用任何共享资源
+         */
+        [[nodiscard]] static const environment &defaults() noexcept
+        {
+            static const environment instance{};
+            return instance;
+        }
+    }; // struct environment
+}
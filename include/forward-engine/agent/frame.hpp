@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <cstdint>
 #include <string_view>
@@ -19,6 +20,7 @@ namespace ngx::agent
             data = 0x02,
             close = 0x03,
             udp = 0x04,
+            window = 0x05, // 流量控制：负载为 4 字节大端的窗口增量，流 0 上表示初始窗口
             keepalive = 0xFF
         };
 
@@ -34,7 +36,27 @@ namespace ngx::agent
         std::string data_;
     }; // class frame
 
+    /**
+     * @brief 帧头：4 字节大端流 ID + 1 字节类型
+     */
+    using frame_header = std::array<char, 5>;
+
+    /**
+     * @brief 帧的非拥有视图
+     * @note `data` 直接指向被解析的缓冲区，缓冲区被复用或释放前必须用完。
+     */
+    struct frame_view
+    {
+        enum frame::type type = frame::type::keepalive;
+        std::uint32_t stream_id = 0;
+        std::string_view data;
+    }; // struct frame_view
+
     [[nodiscard]] std::string serialize(const frame &frame_instance);
 
     [[nodiscard]] bool deserialize(std::string_view string_value, frame &frame_instance);
+
+    [[nodiscard]] frame_header encode(enum frame::type type, std::uint32_t stream_id) noexcept;
+
+    [[nodiscard]] bool decode(std::string_view string_value, frame_view &view) noexcept;
 }
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <boost/asio.hpp>
+#include "balancer.hpp"
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @brief 反向代理分组的健康检查参数
+     * @details 来自 `reverse_map` 分组节点的 `health` 与 `eject` 子节点，例如：
+     * `{"health": {"type": "http", "path": "/healthz", "interval": 5, "timeout": 2, "rise": 2, "fall": 3},
+     *   "eject": {"failures": 5, "duration": 30}}`
+     */
+    struct health_option
+    {
+        /**
+         * @brief 主动探测方式
+         */
+        enum class probe_type
+        {
+            none, // 不主动探测
+            tcp,  // 能建立 TCP 连接即健康
+            http  // `GET path` 返回 2xx/3xx 即健康
+        };
+
+        probe_type type = probe_type::none;
+        std::string path = "/";                   // HTTP 探测路径
+        std::chrono::seconds interval{5};         // 探测周期
+        std::chrono::seconds timeout{2};          // 单次探测超时（含连接）
+        std::uint32_t rise = 2;                   // 连续成功多少次恢复
+        std::uint32_t fall = 3;                   // 连续失败多少次判定不健康
+        std::uint32_t failures = 5;               // 被动：连续连接失败多少次驱逐，0 表示关闭
+        std::chrono::seconds ejection{30};        // 被动驱逐时长
+    }; // struct health_option
+
+    /**
+     * @brief 反向代理后端的健康管理
+     * @details 每个 `distributor` 一份，协程运行在其 `io_context` 的一个 strand 上：
+     * - 主动：按分组的 `interval` 对每个后端做 TCP 或 HTTP 探测，连续 `fall` 次失败标记不健康，连续 `rise` 次成功恢复；
+     * - 被动：`route_reverse` 通过 `failed`/`succeeded` 上报连接结果，连续 `failures` 次失败即驱逐 `ejection` 时长，
+     *   到期后由巡检协程恢复，期间主动探测成功也会提前恢复。
+     * 后端是否参与选择只看 `backend_state::up`，由本类在两种状态任一变化时重新计算。
+     */
+    class health
+    {
+        /**
+         * @brief 受管的分组
+         */
+        struct group
+        {
+            std::shared_ptr<const balancer> balance;
+            health_option option;
+            std::chrono::steady_clock::time_point due{}; // 下次主动探测时刻
+        }; // struct group
+
+    public:
+        explicit health(net::io_context &ioc);
+
+        health(const health &) = delete;
+        health &operator=(const health &) = delete;
+
+        void assign(std::vector<std::pair<std::shared_ptr<const balancer>, health_option>> groups);
+        void stop();
+
+        static void failed(backend_state &state, std::uint32_t threshold, std::chrono::seconds ejection) noexcept;
+        static void succeeded(backend_state &state) noexcept;
+
+    private:
+        net::awaitable<void> patrol();
+        net::awaitable<void> probe(backend target, health_option opt);
+        net::awaitable<bool> attempt(const tcp::endpoint &endpoint, const health_option &opt);
+
+        static void refresh(backend_state &state) noexcept;
+
+        net::strand<net::io_context::executor_type> strand_;
+        net::steady_timer timer_;
+        std::vector<group> groups_;    // 仅在 strand_ 上访问
+        bool started_ = false;         // 巡检协程是否已启动（仅在 strand_ 上访问）
+        bool stopped_ = false;
+    }; // class health
+}
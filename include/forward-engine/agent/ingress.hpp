@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <boost/asio.hpp>
+#include "option.hpp"
+#include "standby.hpp"
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @brief 本地接入（客户端模式）
+     * @details 与 `worker` 对称的另一端：在本地接受 HTTP 代理（CONNECT 与绝对 URI 请求）和 SOCKS5 连接，
+     * 每个本地连接作为一条逻辑流，经预热连接池 `standby` 中的多路复用 obscura 连接转发到远端 ForwardEngine。
+     * 新流选择当前流数最少的可用连接，`connect` 帧之后立即发送首包，不等待远端确认。
+     * @note 远端需开启 `multiplex.path`，且与 `ingress_option::path` 一致。
+     * SOCKS5 只接受 IPv4 与域名地址，不支持 IPv6 字面量。可执行程序以 `--ingress` 参数启动时运行本端。
+     */
+    class ingress
+    {
+    public:
+        /**
+         * @brief 本地连接解析出的转发请求
+         */
+        struct request
+        {
+            std::string destination; // `host:port`
+            std::string first;       // 在 `connect` 帧之后立即发送的数据
+            bool connect = true;     // 需要先向本地回复建立结果（SOCKS5 与 HTTP CONNECT）
+        }; // struct request
+
+        explicit ingress(const option &opt = option::defaults());
+
+        ingress(const ingress &) = delete;
+        ingress &operator=(const ingress &) = delete;
+
+        void load_option(const std::string &file_path);
+
+        void run();
+        void run(std::size_t threads_count);
+        void stop();
+
+        /**
+         * @brief 连接池中可以承载新流的连接数
+         */
+        [[nodiscard]] std::size_t established();
+
+        static net::awaitable<bool> socks_request(tcp::socket &socket, request &result);
+        static net::awaitable<bool> proxy_request(tcp::socket &socket, request &result);
+
+    private:
+        void prepare();
+
+        net::awaitable<void> accept();
+        net::awaitable<void> serve(tcp::socket socket);
+
+        option option_;
+        net::io_context ioc_;
+        tcp::acceptor acceptor_;
+        standby pool_;
+    }; // class ingress
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string_view>
+#include <unordered_map>
+#include <boost/asio.hpp>
+#include "frame.hpp"
+#include "option.hpp"
+#include "obscura.hpp"
+#include "connection.hpp"
+#include "distributor.hpp"
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @brief obscura 多路复用会话
+     * @details 在一条已完成握手的 obscura 连接上承载多条逻辑流，每个 websocket 消息恰好是一个 `frame`：
+     * - `connect`：新建流，负载为 `host:port`，经 `distributor::route_forward` 独立路由；
+     * - `data`：流数据，每条流有独立的上游写协程和队列，慢上游只阻塞自己；
+     * - `window`：基于信用的流量控制，两个方向的初始窗口都是 `multiplex_option::window`，
+     *   服务端在会话开始时通过流 0 上的 `window` 帧告知客户端；
+     * - `close`：任一方向结束时发送，收到后关闭对应上游；
+     * - `keepalive`：原样回显。
+     * 发往客户端的帧由唯一的写协程发送：控制帧优先，数据帧在有待发数据的流之间轮转，每轮每条流一帧。
+     *
+     * 客户端角色（不带 `distributor` 构造）复用同一套流控与调度：流由本端通过 `relay` 发起，
+     * 流的"上游"是本地接入的 socket；不接受对端的 `connect`，窗口以服务端在流 0 上的通告为准，
+     * 收到通告之前 `available` 为 `false`。设置了 `heartbeat` 时客户端按周期在流 0 上发送 `keepalive`，
+     * 一个周期内没有收到回显即判定连接失效并中止，`run` 随之结束。
+     * @note `run` 及其派生的所有协程必须运行在同一个 strand 上，内部状态不加锁；
+     * `available`/`load` 只读原子量，可以在任意线程调用。
+     */
+    class multiplex : public std::enable_shared_from_this<multiplex>
+    {
+        /**
+         * @brief 待发送帧
+         * @details 帧头与负载分开保存，发送时聚集写入；数据帧的负载就是上游读入的那块内存，不再拼接复制。
+         */
+        struct message
+        {
+            message() = default;
+
+            explicit message(const frame_header &header) noexcept
+                : head(header)
+            {
+            }
+
+            frame_header head{};
+            std::unique_ptr<char[]> body;
+            std::size_t size = 0;
+
+            [[nodiscard]] std::array<net::const_buffer, 2> buffers() const noexcept
+            {
+                return {net::buffer(head), net::const_buffer(body.get(), size)};
+            }
+        }; // struct message
+
+        /**
+         * @brief 逻辑流
+         */
+        struct stream
+        {
+            stream(std::uint32_t identity, const net::any_io_executor &executor);
+
+            std::uint32_t id;
+            internal_ptr upstream;
+            bool closed = false;          // 已从流表移除
+
+            // 客户端 -> 上游
+            std::deque<std::string> inbound;
+            std::size_t inbound_bytes = 0; // 已收到、尚未写入上游的字节数，不得超过窗口
+            std::size_t consumed = 0;      // 已写入上游、尚未归还给客户端的信用
+            net::steady_timer arrival;     // 等待新数据
+
+            // 上游 -> 客户端
+            std::deque<message> outbound;
+            bool scheduled = false;        // 是否已在轮转队列中
+            std::int64_t credit = 0;       // 客户端剩余窗口
+            net::steady_timer replenish;   // 等待客户端归还信用
+        }; // struct stream
+
+    public:
+        multiplex(std::shared_ptr<obscura<tcp>> proto, distributor &dist, const option::multiplex_option &opt,
+            std::function<void()> activity = {});
+        multiplex(std::shared_ptr<obscura<tcp>> proto, const option::multiplex_option &opt,
+            std::function<void()> activity = {});
+
+        net::awaitable<void> run();
+        net::awaitable<void> relay(internal_ptr local, std::string destination, std::string first = {});
+
+        /**
+         * @brief 设置客户端保活探测周期，须在 `run` 之前调用
+         * @param interval 探测周期，0 表示不探测
+         */
+        void heartbeat(const std::chrono::milliseconds interval) noexcept
+        {
+            heartbeat_ = interval;
+        }
+
+        /**
+         * @brief 设置缓冲内存计量回调，须在 `run` 之前调用
+         * @param callback 流数变化时以字节增量调用（正数为新增占用，负数为归还），在 `run` 所在的 strand 上执行
+         * @details 每条流按两个方向各一个窗口计算：入站队列受窗口约束，出站队列受客户端信用约束。
+         */
+        void meter(std::function<void(std::ptrdiff_t)> callback)
+        {
+            meter_ = std::move(callback);
+        }
+
+        /**
+         * @brief 是否可以再发起一条流（仅客户端角色有意义）
+         */
+        [[nodiscard]] bool available() const noexcept
+        {
+            return ready_.load(std::memory_order_relaxed) && load() < option_.streams;
+        }
+
+        /**
+         * @brief 当前活跃的流数
+         */
+        [[nodiscard]] std::size_t load() const noexcept
+        {
+            return active_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        net::awaitable<void> reader();
+        net::awaitable<void> writer();
+        net::awaitable<void> keeper();
+        net::awaitable<void> open(std::shared_ptr<stream> target, std::string destination);
+        net::awaitable<void> sink(std::shared_ptr<stream> target);
+        net::awaitable<void> pump(std::shared_ptr<stream> target, std::string pending = {});
+
+        void accept(const std::shared_ptr<stream> &target, std::string_view data);
+        void grant(std::uint32_t id, std::string_view payload);
+        void enqueue(enum frame::type type, std::uint32_t id, std::string_view data = {});
+        void schedule(const std::shared_ptr<stream> &target, message item);
+        void release(std::shared_ptr<stream> target, bool notify);
+        void shutdown();
+        void touch() const;
+        void count() noexcept;
+
+        std::shared_ptr<obscura<tcp>> proto_;
+        distributor *distributor_;                        // 为空表示客户端角色
+        const option::multiplex_option &option_;
+        std::function<void()> activity_;
+        std::function<void(std::ptrdiff_t)> meter_;       // 缓冲内存计量回调
+        std::size_t metered_ = 0;                         // 已经计入的缓冲内存
+        std::size_t window_;                              // 每条流的初始窗口（客户端角色以服务端通告为准）
+        std::uint32_t next_id_ = 1;                       // 客户端角色下一条流的 ID
+        std::atomic<bool> ready_{false};
+        std::atomic<std::size_t> active_{0};
+        std::chrono::milliseconds heartbeat_{0};          // 客户端保活探测周期
+        bool answered_ = true;                            // 上一次探测是否已收到回显
+
+        net::any_io_executor executor_;
+        std::unique_ptr<net::steady_timer> wake_;         // 唤醒写协程
+        std::unique_ptr<net::steady_timer> pulse_;        // 保活探测周期
+        std::deque<message> control_;                     // 控制帧，优先发送
+        std::deque<std::shared_ptr<stream>> rotation_;    // 有待发数据帧的流，轮转发送
+        std::unordered_map<std::uint32_t, std::shared_ptr<stream>> streams_;
+        bool stopped_ = false;
+        std::exception_ptr error_;
+    }; // class multiplex
+}
@@ -3,6 +3,8 @@
 #include <http.hpp>
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
+#include "ticket.hpp"
+#include "base64.hpp"
 #include <boost/beast.hpp>
 #include <boost/beast/websocket/ssl.hpp>
 
@@ -125,22 +127,101 @@ namespace ngx::agent
         obscura(const obscura&) = delete;
         obscura& operator=(const obscura&) = delete;
 
-        net::awaitable<std::string> handshake(std::string_view host = "", std::string_view path = "/");
+        /**
+         * @brief 首包随升级请求携带时所用的请求头
+         * @details 服务端取走首包后在 101 响应中以同名响应头回显首包长度作为确认，
+         * 客户端没有收到确认时把首包作为第一条消息重发。
+         */
+        static constexpr char early_field[] = "X-Obscura-Early";
+
+        /**
+         * @brief 随升级请求携带的首包上限
+         * @details base64 编码后仍需落在 Beast 默认 8 KiB 的请求头上限内。
+         */
+        static constexpr std::size_t early_limit = 4096;
+
+        net::awaitable<std::string> handshake(std::string_view host = "", std::string_view path = "/",
+            std::string_view early = {});
+
+        net::awaitable<std::string> accept_request();
+        net::awaitable<void> accept_upgrade();
+
+        /**
+         * @brief 取出客户端随升级请求携带的首包
+         * @return 解码后的首包，没有或无法解码时为空
+         * @details 取出成功后 `accept_upgrade` 会在 101 响应中确认，客户端不再重发；
+         * 调用方因此必须转发取出的首包。
+         * @note 仅 Server 模式在 `accept_request` 之后、`accept_upgrade` 之前有效。
+         */
+        [[nodiscard]] std::string early();
 
         // 读取数据到外部缓冲区，返回读取字节数
         net::awaitable<std::size_t> async_read(beast::flat_buffer& buffer);
+
+        /**
+         * @brief 读取当前消息的一部分到定长缓冲区
+         * @param buffer 接收缓冲区
+         * @return 读取字节数（可能为 0）
+         * @details 大消息按到达顺序分段返回，不在内存中拼装整条消息；消息边界可通过 `is_message_done` 判断。
+         */
+        net::awaitable<std::size_t> async_read_some(net::mutable_buffer buffer)
+        {
+            co_return co_await wsocket.async_read_some(buffer, net::use_awaitable);
+        }
+
+        [[nodiscard]] bool is_message_done() const noexcept
+        {
+            return wsocket.is_message_done();
+        }
         net::awaitable<void> async_write(std::string_view data);
 
+        /**
+         * @brief 聚集写入：多个缓冲区作为一条 websocket 消息发送
+         * @param buffers 缓冲区序列（例如帧头 + 负载），不做拼接复制
+         */
+        template <typename ConstBufferSequence>
+            requires net::is_const_buffer_sequence<ConstBufferSequence>::value
+        net::awaitable<void> async_write(const ConstBufferSequence &buffers)
+        {
+            co_await wsocket.async_write(buffers, net::use_awaitable);
+        }
+
         net::awaitable<void> close()
         {
             co_await wsocket.async_close(websocket::close_code::normal, net::use_awaitable);
         }
 
+        /**
+         * @brief 调整 websocket 读写参数
+         * @param write_buffer 写缓冲区大小
+         * @param message_max 单条消息上限
+         * @details 关闭自动分片后每次 `async_write` 只产生一个 websocket 帧，
+         * 合批后的大消息不会再被按写缓冲区大小切碎；客户端角色的掩码处理也按该缓冲区分块进行。
+         */
+        void tune(const std::size_t write_buffer, const std::size_t message_max)
+        {
+            wsocket.auto_fragment(false);
+            wsocket.write_buffer_bytes(write_buffer);
+            wsocket.read_message_max(message_max);
+        }
+
+        /**
+         * @brief 强制关闭底层 socket
+         * @details 用于超时等需要立即终止的场景，不发送 websocket 关闭帧，挂起的读写会以错误结束。
+         */
+        void abort() noexcept
+        {
+            boost::system::error_code ec;
+            ssl_stream.lowest_layer().close(ec);
+        }
+
     private:
         role role_;
         std::shared_ptr<ssl::context> ssl_context_;
         ssl::stream<socket_type> ssl_stream;
         websocket::stream<ssl::stream<socket_type>&> wsocket{ssl_stream};
+        beast::http::request<beast::http::string_body> request_; // Server 模式收到的升级请求
+        std::size_t early_taken_ = 0;                            // Server 模式已取走的首包长度，0 表示未取走
     }; // class obscura
 
     template <protocol_concept protocol>
@@ -154,24 +235,22 @@ namespace ngx::agent
      * @brief 握手
      * @param host 目标主机（仅 Client 模式需要，Server 模式忽略）
      * @param path 请求路径（仅 Client 模式需要，Server 模式忽略）
+     * @param early 首包（仅 Client 模式需要）
      * @return std::string 对于 Server 模式，返回请求的目标路径；对于 Client 模式，返回空串。
+     * @details Client 模式下不超过 `early_limit` 的首包随升级请求一起发出，服务端可以在
+     * 接受升级的同时连接上游，首包不必等待 101 响应往返；超出上限的首包在握手完成后作为普通消息发送。
+     * 101 响应没有回显首包长度（服务端不支持或未取走）时，同样把首包作为第一条消息补发。
+     * Server 模式等价于依次调用 `accept_request` 与 `accept_upgrade`。
      */
     template <protocol_concept protocol>
-    net::awaitable<std::string> obscura<protocol>::handshake(std::string_view host, std::string_view path)
+    net::awaitable<std::string> obscura<protocol>::handshake(std::string_view host, std::string_view path,
+        std::string_view early)
     {
         if (role_ == role::server)
         {
-            // Server 模式：SSL 握手 -> 接收 HTTP -> 升级 WebSocket
-            co_await ssl_stream.async_handshake(ssl::stream_base::server, net::use_awaitable);
-            
-            beast::flat_buffer buffer;
-            beast::http::request<beast::http::string_body> req;
-            co_await beast::http::async_read(ssl_stream, buffer, req, net::use_awaitable);
-
-            // 传递 buffer 以处理预读数据，Beast 会消耗掉它
-            co_await wsocket.async_accept(req, net::use_awaitable);
-            
-            co_return std::string(req.target());
+            auto target = co_await accept_request();
+            co_await accept_upgrade();
+            co_return target;
         }
         else
         {
@@ -187,15 +266,87 @@ namespace ngx::agent
                 }
             }
 
+            // 有缓存的会话票据时走会话恢复，省去完整密钥交换
+            resumption::resume(ssl_stream.native_handle(), host);
             co_await ssl_stream.async_handshake(ssl::stream_base::client, net::use_awaitable);
-            
+
+            const bool inline_early = !early.empty() && early.size() <= early_limit;
+            if (inline_early)
+            {
+                wsocket.set_option(websocket::stream_base::decorator(
+                    [encoded = base64::encode(early)](websocket::request_type &req)
+                    {
+                        req.set(early_field, encoded);
+                    }));
+            }
+
             std::string h = host.empty() ? "localhost" : std::string(host);
-            co_await wsocket.async_handshake(h, path, net::use_awaitable);
+            websocket::response_type response;
+            co_await wsocket.async_handshake(response, h, path, net::use_awaitable);
+
+            const bool acknowledged = inline_early && response[early_field] == std::to_string(early.size());
+            if (!early.empty() && !acknowledged)
+            {
+                co_await wsocket.async_write(net::buffer(early), net::use_awaitable);
+            }
             
             co_return "";
         }
     }
 
+    /**
+     * @brief 服务端握手第一步：SSL 握手并读取升级请求
+     * @return 请求的目标路径
+     * @details 此时尚未回复 101，调用方可以先根据目标发起上游连接，再与 `accept_upgrade` 并发进行。
+     */
+    template <protocol_concept protocol>
+    net::awaitable<std::string> obscura<protocol>::accept_request()
+    {
+        co_await ssl_stream.async_handshake(ssl::stream_base::server, net::use_awaitable);
+
+        // 客户端在收到 101 之前不会发送 websocket 帧，buffer 中不会残留升级请求之后的数据
+        beast::flat_buffer buffer;
+        co_await beast::http::async_read(ssl_stream, buffer, request_, net::use_awaitable);
+
+        co_return std::string(request_.target());
+    }
+
+    /**
+     * @brief 服务端握手第二步：接受 websocket 升级
+     */
+    template <protocol_concept protocol>
+    net::awaitable<void> obscura<protocol>::accept_upgrade()
+    {
+        if (early_taken_ != 0)
+        {   // 确认已取走首包，客户端据此不再重发
+            wsocket.set_option(websocket::stream_base::decorator(
+                [size = std::to_string(early_taken_)](websocket::response_type &res)
+                {
+                    res.set(early_field, size);
+                }));
+        }
+        co_await wsocket.async_accept(request_, net::use_awaitable);
+    }
+
+    template <protocol_concept protocol>
+    std::string obscura<protocol>::early()
+    {
+        const auto it = request_.find(early_field);
+        if (it == request_.end() || it->value().empty())
+        {
+            return {};
+        }
+
+        std::string result;
+        const auto encoded = it->value();
+        if (!base64::decode(std::string_view(encoded.data(), encoded.size()), result) || result.size() > early_limit)
+        {
+            return {};
+        }
+        early_taken_ = result.size();
+        return result;
+    }
+
     /**
      * @brief 读取数据
      * @param buffer 外部缓冲区
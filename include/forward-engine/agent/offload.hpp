@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <boost/asio.hpp>
+#include <abnormal.hpp>
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+
+    /**
+     * @brief 握手卸载线程池
+     * @details TLS 握手的密钥交换与签名计算开销远高于转发，握手风暴时会拖慢同一事件循环上所有会话的转发。
+     * `run` 把协程整体切换到独立线程池上执行：socket 仍归原 `io_context` 的反应器管理，
+     * 但异步操作的完成处理（包括 SSL 引擎里的握手计算）都在池线程上运行，结束后自动切回调用方的执行器。
+     * 池内所有线程共享一个就绪队列，空闲线程总是取下一个待处理的握手，不存在某个线程积压而其他线程空闲的情况。
+     * 每个握手运行在池上各自的 strand 里，调用方发出的取消经 `co_spawn` 转发到该 strand 上执行，不会与握手并发。
+     * @note 排队中的握手数有上限，超过时直接拒绝，避免无界积压把延迟转嫁给后来的连接。
+     */
+    class offload
+    {
+    public:
+        /**
+         * @param threads 线程数，至少为 1
+         * @param capacity 同时排队或执行的握手上限，至少为 1
+         */
+        offload(std::size_t threads, std::size_t capacity);
+        ~offload();
+
+        offload(const offload &) = delete;
+        offload &operator=(const offload &) = delete;
+
+        void stop();
+
+        /**
+         * @brief 在线程池上执行协程
+         * @param task 待执行的协程（通常是握手）
+         * @return 协程的结果，恢复时已回到调用方的执行器
+         * @throws abnormal::network_error 排队数已达上限
+         * @details 调用方协程的取消（如会话超时）会中止握手当前挂起的操作，握手随之以异常退出；
+         * 调用方不得在握手期间从其他线程直接关闭握手所用的 socket。
+         */
+        template <typename T>
+        net::awaitable<T> run(net::awaitable<T> task)
+        {
+            if (!enter())
+            {
+                throw abnormal::network_error("握手队列已满: {}", capacity_);
+            }
+
+            struct guard
+            {
+                offload *self;
+                ~guard()
+                {
+                    self->leave();
+                }
+            } leave_on_exit{this};
+
+            co_return co_await net::co_spawn(net::make_strand(pool_.get_executor()), std::move(task), net::use_awaitable);
+        }
+
+        /**
+         * @brief 当前排队或执行中的握手数
+         */
+        [[nodiscard]] std::size_t depth() const noexcept
+        {
+            return depth_.load(std::memory_order_relaxed);
+        }
+
+    private:
+        bool enter() noexcept;
+        void leave() noexcept;
+
+        net::thread_pool pool_;
+        std::size_t capacity_;
+        std::atomic<std::size_t> depth_{0};
+    }; // class offload
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <boost/property_tree/ptree.hpp>
+
+namespace ngx::agent
+{
+    /**
+     * @brief 运行参数
+     * @details 汇总 `worker` 与 `session` 的可调参数。除会话超时外，新增功能默认关闭，行为与引入参数前一致；
+     * 会话超时默认启用，见 `timeout_option`。可通过 `option::load` 从配置文件的 `agent.option` 节点覆盖。
+     * @note `worker` 持有唯一一份实例，`session` 只保存其引用，因此必须在 `run` 之前完成加载。
+     */
+    struct option
+    {
+        /**
+         * @brief 零拷贝发送参数
+         * @details 仅在 Linux 且内核支持 `SO_ZEROCOPY` 时生效，其余平台自动退化为普通写入。
+         */
+        struct zerocopy_option
+        {
+            bool enable = false;           // 是否启用（默认关闭，需显式开启）
+            std::size_t threshold = 16384; // 单次写入不小于该值时才走 `MSG_ZEROCOPY`
+            std::size_t block = 65536;     // 每个发送块的大小
+            std::size_t depth = 4;         // 同时在途（等待内核释放）的发送块数量
+        };
+
+        /**
+         * @brief 隧道缓冲池参数
+         * @details io_uring 后端下缓冲池会注册给内核；槽位数受 `RLIMIT_MEMLOCK` 与内核注册上限约束。
+         */
+        struct reservoir_option
+        {
+            std::size_t slots = 0; // 槽位数量（每个 16 KiB），0 表示会话使用自带缓冲区
+        };
+
+        /**
+         * @brief 会话超时参数
+         * @details 由 `worker` 的时间轮统一驱动，各阶段超时互不叠加；值为 0 表示不限制。
+         * @note 与引入前的行为不同：此前会话没有任何超时，现在默认限制读请求头 30 秒、连接上游 10 秒、
+         * 隧道空闲 300 秒，且时间轮总会创建。需要恢复原有行为时把这三项都设为 0。
+         */
+        struct timeout_option
+        {
+            std::chrono::seconds header{30};      // 读取首个请求头
+            std::chrono::seconds connect{10};     // 连接上游（含握手）
+            std::chrono::seconds idle{300};       // 隧道空闲（双向均无数据）
+            std::chrono::seconds lifetime{0};     // 会话总时长，默认不限制
+            std::chrono::milliseconds tick{100};  // 时间轮刻度
+        };
+
+        /**
+         * @brief 监听接入参数
+         * @details 每条接入链在监听 socket 可读时循环接入，直到积压清空或达到批量上限。
+         */
+        struct accept_option
+        {
+            std::size_t concurrency = 1;    // 同时挂起的接入链数量，多线程运行时可与线程数相同
+            std::size_t batch = 64;         // 单次可读事件最多接入的连接数，防止接入饿死其他会话
+            std::chrono::seconds defer{0};  // `TCP_DEFER_ACCEPT`：首包到达前不唤醒接入，0 表示关闭（仅 Linux）
+        };
+
+        /**
+         * @brief 准入控制参数
+         * @details 按存活会话数、会话缓冲内存与事件循环延迟三个维度判断负载，任一维度超限即生效，0 表示不检查该维度。
+         * 超过软上限时新连接被快速拒绝，超过硬上限时暂停接入，已接入的会话不受影响。
+         */
+        struct admission_option
+        {
+            /**
+             * @brief 软上限下的拒绝方式
+             */
+            enum class shed_mode
+            {
+                reply, // 回复 `503 Service Unavailable` 后关闭
+                reset  // `SO_LINGER(0)` 后关闭，直接发送 RST
+            };
+
+            std::size_t soft_sessions = 0;       // 存活会话数软上限
+            std::size_t hard_sessions = 0;       // 存活会话数硬上限
+            std::size_t soft_memory = 0;         // 会话缓冲内存软上限（字节）
+            std::size_t hard_memory = 0;         // 会话缓冲内存硬上限（字节）
+            std::chrono::milliseconds soft_lag{0}; // 事件循环延迟软上限
+            std::chrono::milliseconds hard_lag{0}; // 事件循环延迟硬上限
+            std::chrono::milliseconds interval{100}; // 延迟采样与暂停后复查的间隔
+            shed_mode shed = shed_mode::reply;
+        };
+
+        /**
+         * @brief 按客户端地址的配额参数
+         * @details 每个客户端地址独立计量，0 表示不限制该维度；超过连接速率或并发会话上限的连接在接入时直接复位，
+         * 超过带宽的会话在读取之间等待，不缓存数据。
+         */
+        struct quota_option
+        {
+            double rate = 0;            // 每秒新建连接数
+            std::size_t burst = 0;      // 连接突发数，0 按 1 处理
+            std::size_t sessions = 0;   // 并发会话数
+            std::size_t bandwidth = 0;  // 转发带宽（字节/秒，双向合计，同一地址的会话共享）
+            std::size_t clients = 65536; // 同时跟踪的客户端数上限，超出后淘汰最久未活动的
+        };
+
+        /**
+         * @brief 隧道带宽整形参数
+         * @details 全局 → 监听器 → 客户端地址（`quota.bandwidth`）→ 会话逐级限速，单位为字节/秒（双向合计），0 表示该级不限制。
+         * 超过任一级时暂停读取，由 TCP 流控反压对端，不缓存数据。
+         */
+        struct shaping_option
+        {
+            std::size_t global = 0;                 // 进程内全部隧道
+            std::size_t listener = 0;               // 本监听器的全部隧道
+            std::size_t session = 0;                // 单个会话
+            std::chrono::milliseconds burst{100};   // 桶深，按各级速率折算为字节（至少 16 KiB）
+            std::chrono::milliseconds tick{10};     // 等待令牌时唤醒时刻的对齐粒度
+        };
+
+        /**
+         * @brief obscura 多路复用参数
+         * @details 客户端以该路径完成握手后，同一条 TLS + WebSocket 连接上用 `frame` 承载多条逻辑流，
+         * 每条流由 `connect` 帧携带 `host:port` 独立路由。
+         */
+        struct multiplex_option
+        {
+            std::string path;             // 多路复用握手路径（如 `/mux`），为空表示关闭
+            std::size_t streams = 128;    // 单连接并发流上限
+            std::size_t window = 262144;  // 每条流每个方向的初始窗口（字节）
+        };
+
+        /**
+         * @brief obscura 写入合批参数
+         * @details 上游 -> obscura 方向先读一次，再把当前立即可读的数据一并收进同一条 websocket 消息，
+         * 减少 TLS 记录与 websocket 帧头的数量。合批默认只在会话自身的半缓冲区内进行，
+         * `batch` 大于半缓冲区时每个会话额外分配一块该大小的合批缓冲区（计入准入内存）。
+         */
+        struct obscura_option
+        {
+            std::size_t batch = 0;               // 单条消息的合批上限（字节），不超过半缓冲区（含 0）时不另外分配
+            std::chrono::milliseconds delay{0};  // 首次读到数据后最多再等待多久凑批，0 表示只收立即可读的数据
+            std::size_t write_buffer = 65536;    // websocket 写缓冲区大小，同时关闭自动分片
+            std::size_t message_max = 16777216; // 单条 websocket 消息上限（字节），超出视为协议错误
+        };
+
+        /**
+         * @brief 服务端 TLS 参数
+         * @details 会话恢复使用无状态票据，票据密钥按周期轮换。
+         * 握手计算可以卸载到独立线程池，避免握手风暴拖慢转发。
+         */
+        struct tls_option
+        {
+            std::chrono::seconds rotate{3600}; // 票据密钥轮换周期，0 表示不轮换
+            std::size_t keys = 3;              // 保留的票据密钥数量（含当前签发密钥）
+            std::size_t threads = 0;           // 握手线程数，0 表示在会话所在线程上握手
+            std::size_t queue = 1024;          // 同时排队或执行的握手上限，超出时拒绝连接
+        };
+
+        /**
+         * @brief 本地接入（客户端模式）参数
+         * @details `ingress` 在本地接受 HTTP CONNECT / SOCKS5 连接，经预热的多路复用 obscura 连接池转发到远端。
+         * 连接池至少保持 `min` 条连接，并在没有空闲连接时后台补充一条，直到 `max`。
+         */
+        struct ingress_option
+        {
+            std::string listen = "127.0.0.1";   // 本地监听地址
+            std::uint16_t local = 1080;         // 本地监听端口
+            std::string host;                   // 远端地址，为空表示不启用
+            std::uint16_t port = 443;           // 远端端口
+            std::string sni;                    // TLS SNI 与证书校验使用的主机名，为空时使用 host
+            std::string path;                   // 远端的多路复用路径，须与远端 multiplex.path 一致
+            std::string ca;                     // 校验远端证书使用的 CA 文件，为空时使用系统默认
+            bool verify = true;                 // 是否校验远端证书
+            std::size_t min = 2;                // 连接池常驻连接数下限
+            std::size_t max = 8;                // 连接池连接数上限
+            std::chrono::seconds keepalive{15}; // 保活探测周期，一个周期内没有回显即淘汰该连接，0 表示关闭
+            std::chrono::seconds idle{60};      // 超出下限的连接空闲多久后关闭
+        };
+
+        zerocopy_option zerocopy;
+        reservoir_option reservoir;
+        timeout_option timeout;
+        accept_option accept;
+        admission_option admission;
+        quota_option quota;
+        shaping_option shaping;
+        multiplex_option multiplex;
+        obscura_option obscura;
+        tls_option tls;
+        ingress_option ingress;
+
+        [[nodiscard]] static const option &defaults() noexcept;
+        [[nodiscard]] static option load(const boost::property_tree::ptree &tree);
+    }; // struct option
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <boost/asio.hpp>
+#include "option.hpp"
+#include "shaper.hpp"
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+
+    /**
+     * @brief 按客户端地址的配额
+     * @details 限制单个客户端地址的新建连接速率、并发会话数与转发带宽（双向合计）。
+     * 每个客户端占用表中的一个槽位，表在构造时一次性分配，按地址哈希划分为若干分片，查找只在分片内探测一个小窗口；
+     * 窗口内没有空位时淘汰其中最久未活动、且没有存活会话的槽位（近似 LRU），内存占用与客户端数量无关。
+     * 令牌桶采用 GCRA 形式，每个桶只是一个“理论到达时间”原子量，用到时才按当前时间折算补充，没有后台定时器；
+     * 带宽桶作为 `shaper` 的客户端层级参与会话的读取整形。
+     * @note 全部操作都是无锁的原子操作，多线程运行同一个 `io_context` 时无需加锁；
+     * 槽位被淘汰或窗口已满时按不限制处理，配额是尽力而为的保护而不是精确计量。
+     */
+    class quota
+    {
+        /**
+         * @brief 客户端槽位，独占一条缓存行
+         */
+        struct alignas(64) slot
+        {
+            std::atomic<std::uint64_t> key{0};      // 地址指纹，0 表示空位
+            std::atomic<std::int64_t> seen{0};      // 最近活动时间（纳秒）
+            std::atomic<std::int64_t> connect{0};   // 连接桶的理论到达时间（纳秒）
+            shaper::bucket bytes;                   // 带宽桶（同一地址的会话共享）
+            std::atomic<std::uint32_t> sessions{0}; // 存活会话数
+        }; // struct slot
+
+    public:
+        /**
+         * @brief 会话持有的配额凭证
+         * @details 记录会话所属的客户端槽位，析构时归还并发会话计数；空凭证表示不受限制。
+         */
+        class pass
+        {
+        public:
+            pass() = default;
+            pass(pass &&other) noexcept;
+            pass &operator=(pass &&other) noexcept;
+            pass(const pass &) = delete;
+            pass &operator=(const pass &) = delete;
+            ~pass();
+
+            /**
+             * @brief 客户端带宽层级，供会话的整形通道引用
+             * @return 未限制带宽或空凭证时为空层级
+             */
+            [[nodiscard]] shaper::level level() const noexcept;
+
+            [[nodiscard]] explicit operator bool() const noexcept
+            {
+                return owner_ != nullptr;
+            }
+
+        private:
+            friend class quota;
+            pass(const quota *owner, slot *entry) noexcept;
+            void reset() noexcept;
+
+            const quota *owner_ = nullptr;
+            slot *slot_ = nullptr;
+        }; // class pass
+
+        explicit quota(const option::quota_option &opt);
+
+        /**
+         * @brief 参数中是否配置了任一限制
+         */
+        [[nodiscard]] static bool enabled(const option::quota_option &opt) noexcept
+        {
+            return opt.rate > 0 || opt.sessions != 0 || opt.bandwidth != 0;
+        }
+
+        [[nodiscard]] std::optional<pass> enter(const net::ip::address &client) noexcept;
+
+        /**
+         * @brief 槽位总数
+         */
+        [[nodiscard]] std::size_t capacity() const noexcept
+        {
+            return mask_ + 1;
+        }
+
+    private:
+        static constexpr std::size_t window = 8; // 分片内的探测窗口
+
+        [[nodiscard]] static std::uint64_t fingerprint(const net::ip::address &client) noexcept;
+        [[nodiscard]] slot *locate(std::uint64_t key, std::int64_t time) noexcept;
+
+        const option::quota_option &option_;
+        std::unique_ptr<slot[]> slots_;
+        std::size_t mask_ = 0;
+        std::size_t shard_ = 0;     // 分片大小（槽位数，2 的幂）
+        std::int64_t interval_ = 0; // 连接桶每个令牌的间隔（纳秒）
+        std::int64_t tolerance_ = 0; // 连接桶允许的突发提前量（纳秒）
+        shaper::rate bandwidth_;     // 带宽桶速率，桶深为一秒
+    }; // class quota
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <boost/asio.hpp>
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+
+    /**
+     * @brief 当前编译选择的事件循环后端
+     * @details 由构建选项 `FORWARD_IO_URING` 决定：开启后 Asio 的 socket 操作直接提交到 io_uring，
+     * 省去“就绪通知 + 再发一次读写系统调用”的往返。
+     */
+    [[nodiscard]] constexpr std::string_view reactor_backend() noexcept
+    {
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+        return "io_uring";
+#elif defined(BOOST_ASIO_HAS_IOCP)
+        return "iocp";
+#elif defined(BOOST_ASIO_HAS_EPOLL)
+        return "epoll";
+#elif defined(BOOST_ASIO_HAS_KQUEUE)
+        return "kqueue";
+#else
+        return "select";
+#endif
+    }
+
+    /**
+     * @brief 隧道缓冲池
+     * @details 每个 `worker` 一份，启动时一次性分配若干个隧道槽位，每个槽位拆成上/下行两半。
+     * io_uring 后端下整块内存会通过 `net::register_buffers` 注册给内核，
+     * 读写时内核无需再逐次固定/映射用户页面；其余后端下它只是一个普通的定长缓冲池。
+     * @note 池子耗尽时 `acquire` 返回空租约，调用方应退回自己的缓冲区。
+     */
+    class reservoir
+    {
+    public:
+#if defined(BOOST_ASIO_HAS_IO_URING)
+        using buffer_type = net::mutable_registered_buffer;
+#else
+        using buffer_type = net::mutable_buffer;
+#endif
+
+        // 单个槽位大小，与 `session` 自带缓冲区保持一致
+        static constexpr std::size_t slot_size = 16384;
+
+        /**
+         * @brief 槽位租约
+         * @details 析构时自动归还槽位，移动后原租约失效。
+         */
+        class lease
+        {
+        public:
+            lease() = default;
+            lease(reservoir *owner, std::size_t index) noexcept;
+            lease(lease &&other) noexcept;
+            lease &operator=(lease &&other) noexcept;
+            lease(const lease &) = delete;
+            lease &operator=(const lease &) = delete;
+            ~lease();
+
+            explicit operator bool() const noexcept;
+
+            [[nodiscard]] buffer_type left() const;
+            [[nodiscard]] buffer_type right() const;
+
+        private:
+            void reset() noexcept;
+
+            reservoir *owner_ = nullptr;
+            std::size_t index_ = 0;
+        }; // class lease
+
+        reservoir(net::io_context &ioc, std::size_t slots);
+
+        reservoir(const reservoir &) = delete;
+        reservoir &operator=(const reservoir &) = delete;
+
+        [[nodiscard]] lease acquire();
+        [[nodiscard]] bool registered() const noexcept;
+        [[nodiscard]] std::size_t capacity() const noexcept;
+
+    private:
+        void release(std::size_t index) noexcept;
+        [[nodiscard]] buffer_type half(std::size_t index) const;
+
+        std::unique_ptr<std::byte[]> memory_;
+        std::vector<net::mutable_buffer> halves_;
+        std::vector<std::uint32_t> free_;
+        mutable std::mutex mutex_;
+#if defined(BOOST_ASIO_HAS_IO_URING)
+        std::optional<net::buffer_registration<std::vector<net::mutable_buffer>>> registration_;
+#endif
+    }; // class reservoir
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace ngx::agent
+{
+    /**
+     * @brief 反向代理的编译路由表
+     * @details 两级结构，构造后只读，查找不分配内存：
+     * - 主机：按标签倒序组织的前缀树（`www.example.com` 依次走 `com`、`example`、`www`），
+     *   每个节点带精确匹配与 `*.` 通配两个入口，子节点按标签排序、二分查找，主机名按 ASCII 忽略大小写比较；
+     * - 路径：每个主机入口一棵压缩前缀树（radix tree），按字节做最长前缀匹配，子边按首字节排序。
+     *
+     * 匹配顺序与 nginx 的 `server_name` + `location` 前缀匹配一致：先选主机（精确优先，其次最长的通配，最后 `*`），
+     * 再在该主机内选最长的路径前缀；主机选定后路径不匹配即失败，不回退到更宽的主机。
+     */
+    class router
+    {
+    public:
+        /**
+         * @brief 未命中
+         */
+        static constexpr std::uint32_t npos = UINT32_MAX;
+
+        bool insert(std::string_view host, std::string_view prefix, std::uint32_t value);
+        [[nodiscard]] std::uint32_t find(std::string_view host, std::string_view path) const noexcept;
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return hosts_.size() == 1 && paths_.empty();
+        }
+
+        [[nodiscard]] static std::string_view normalize(std::string_view host) noexcept;
+
+    private:
+        /**
+         * @brief 主机前缀树节点（一个标签）
+         */
+        struct host_node
+        {
+            std::string label;                  // 小写
+            std::vector<std::uint32_t> children; // 按 `label` 排序
+            std::uint32_t exact = npos;          // 精确匹配到此为止的主机对应的路径树根
+            std::uint32_t wildcard = npos;       // `*.` 加上此节点对应后缀的路径树根
+        }; // struct host_node
+
+        /**
+         * @brief 路径压缩前缀树节点（一条边）
+         */
+        struct path_node
+        {
+            std::string edge;                    // 从父节点到此节点的字节串，根节点为空
+            std::vector<std::uint32_t> children; // 按 `edge` 首字节排序，首字节互不相同
+            std::uint32_t value = npos;
+        }; // struct path_node
+
+        [[nodiscard]] std::uint32_t descend(std::uint32_t parent, std::string_view label);
+        [[nodiscard]] std::uint32_t child(std::uint32_t parent, std::string_view label) const noexcept;
+        [[nodiscard]] std::uint32_t attach(std::uint32_t &root);
+        void assign(std::uint32_t root, std::string_view prefix, std::uint32_t value);
+        [[nodiscard]] std::uint32_t longest(std::uint32_t root, std::string_view path) const noexcept;
+
+        std::vector<host_node> hosts_{1}; // [0] 为根
+        std::vector<path_node> paths_;
+    }; // class router
+}
@@ -5,8 +5,13 @@
 #include <string>
 #include <string_view>
 #include <array>
+#include <atomic>
 #include <cstddef>
+#include <type_traits>
 #include <cctype>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <memory_resource>
 #include <boost/asio.hpp>
 #include <abnormal.hpp>
@@ -14,6 +19,11 @@
 #include "obscura.hpp"
 #include "connection.hpp"
 #include "adaptation.hpp"
+#include "environment.hpp"
+#include "quota.hpp"
+#include "zerocopy.hpp"
+#include "wheel.hpp"
+#include "multiplex.hpp"
 #include <http/deserialization.hpp>
 #include <http/serialization.hpp>
 #include <boost/asio/experimental/awaitable_operators.hpp>
@@ -36,7 +46,7 @@ namespace ngx::agent
         using socket_type = Transport;
 
         explicit session(net::io_context &io_context, socket_type socket, distributor &dist,
-        std::shared_ptr<ssl::context> ssl_ctx);
+        std::shared_ptr<ssl::context> ssl_ctx, const environment &env = environment::defaults(), quota::pass pass = {});
         virtual ~session();
 
         void start();
@@ -47,6 +57,16 @@ namespace ngx::agent
         using cancellation_slot = net::cancellation_slot;
         using cancellation_signal = net::cancellation_signal;
 
+        /**
+         * @brief 会话阶段，决定当前适用的超时
+         */
+        enum class stage
+        {
+            header,  // 等待首个请求头（含 obscura 握手）
+            connect, // 连接上游
+            tunnel   // 双向转发
+        };
+
         /**
          * @brief 判断 `boost::system::error_code` 是否属于“正常收尾”
          * @details “正常收尾”包括：对端正常关闭、被取消、连接被重置等。
@@ -93,34 +113,65 @@ namespace ngx::agent
             }
         }
 
+        void watch(stage next);
+        void expire();
+        [[nodiscard]] std::uint64_t due() const noexcept;
+
+        /**
+         * @brief 记录一次数据活动
+         * @details 只写时间戳、不改期，空闲超时在到期时惰性重算，热路径上没有加锁操作。
+         */
+        void touch() noexcept
+        {
+            if (environment_.timer)
+            {
+                activity_.store(environment_.timer->now(), std::memory_order_relaxed);
+            }
+        }
+
+        net::awaitable<std::size_t> throttle(std::size_t want, cancellation_slot cancel_slot = {});
+
         net::awaitable<void> diversion();
         net::awaitable<void> tunnel();
 
+        template <typename Buffer>
+        net::awaitable<void> relay(Buffer left_buffer, Buffer right_buffer);
+
         net::awaitable<void> handle_http();
         net::awaitable<void> handle_obscura();
+        net::awaitable<void> handle_multiplex(std::shared_ptr<obscura<tcp>> proto);
 
         net::awaitable<void> tunnel_obscura(std::shared_ptr<obscura<tcp>> proto);
-        net::awaitable<void> transfer_obscura(obscura<tcp> &proto, cancellation_slot cancel_slot) const;
-        net::awaitable<void> transfer_obscura(obscura<tcp> &proto, cancellation_slot cancel_slot, mutable_buf buffer) const;
+        net::awaitable<void> transfer_obscura(obscura<tcp> &proto, cancellation_slot cancel_slot);
+        net::awaitable<void> transfer_obscura(obscura<tcp> &proto, cancellation_slot cancel_slot, mutable_buf buffer);
+        net::awaitable<std::size_t> coalesce(mutable_buf space, net::steady_timer &timer, boost::system::error_code &ec);
         
         /**
          * @brief 从源读取数据并写入目标
          * @param from 源
          * @param to 目标
-         * @param buffer 复用缓冲区（必须在 `co_await` 生命周期内保持有效）
+         * @param buffer 复用缓冲区（必须在 `co_await` 生命周期内保持有效，可以是已注册缓冲区）
          * @details 该函数会从源读取数据，并将数据写入目标。
          * 依赖协程的默认取消机制，不需要手动传递 cancellation_slot。
          */
-        template <typename Source, typename Dest>
-        net::awaitable<void> transfer_tcp(Source &from, Dest &to, mutable_buf buffer)
+        template <typename Source, typename Dest, typename Buffer>
+        net::awaitable<void> transfer_tcp(Source &from, Dest &to, Buffer buffer)
         {
             boost::system::error_code ec;
             auto token = net::redirect_error(net::use_awaitable, ec);
 
             while (true)
             {
+                std::size_t allowed = lane_ ? lane_.grant(buffer.size()) : buffer.size();
+                if (allowed == 0 && (allowed = co_await throttle(buffer.size())) == 0)
+                {   // 等待令牌时被取消
+                    shut_close(to);
+                    co_return;
+                }
+
                 ec.clear();
-                const std::size_t n = co_await from.async_read_some(buffer, token);
+                const std::size_t n = co_await from.async_read_some(net::buffer(buffer, allowed), token);
+                touch();
                 if (ec)
                 {
                     if (graceful(ec))
@@ -136,9 +187,13 @@ namespace ngx::agent
                     shut_close(to);
                     co_return;
                 }
+                if (lane_)
+                {
+                    lane_.charge(n);
+                }
 
                 ec.clear();
-                co_await net::async_write(to, net::buffer(buffer.data(), n), token);
+                co_await net::async_write(to, net::buffer(buffer, n), token);
                 if (ec)
                 {
                     if (graceful(ec))
@@ -151,11 +206,102 @@ namespace ngx::agent
             }
         }
 
+        /**
+         * @brief 以零拷贝方式从源读取数据并写入目标
+         * @param from 源
+         * @param to 目标（必须是独占的 `tcp::socket`，见 `zerocopy` 的说明）
+         * @details 读缓冲直接使用 `zerocopy` 的发送块，发送块在内核释放前不会被再次读入，
+         * 退出语义与 `transfer_tcp` 保持一致；关闭目标之前先收回全部在途发送块。
+         */
+        template <typename Source>
+        net::awaitable<void> transfer_zerocopy(Source &from, tcp::socket &to)
+        {
+            zerocopy sender(to, option_.zerocopy);
+            if (sender.active())
+            {
+                ticket_.charge(option_.zerocopy.block * option_.zerocopy.depth);
+            }
+            boost::system::error_code ec;
+            auto token = net::redirect_error(net::use_awaitable, ec);
+
+            while (true)
+            {
+                ec.clear();
+                const auto buffer = co_await sender.acquire(ec);
+                if (ec)
+                {
+                    if (graceful(ec) || ec == net::error::bad_descriptor)
+                    {
+                        shut_close(from);
+                        co_return;
+                    }
+                    throw abnormal::network_error("transfer_zerocopy 等待发送块失败: {}", ec.message());
+                }
+
+                std::size_t allowed = lane_ ? lane_.grant(buffer.size()) : buffer.size();
+                if (allowed == 0 && (allowed = co_await throttle(buffer.size())) == 0)
+                {
+                    co_await sender.drain();
+                    shut_close(to);
+                    co_return;
+                }
+
+                const std::size_t n = co_await from.async_read_some(net::buffer(buffer, allowed), token);
+                touch();
+                if (ec)
+                {
+                    if (graceful(ec))
+                    {
+                        co_await sender.drain();
+                        shut_close(to);
+                        co_return;
+                    }
+                    throw abnormal::network_error("transfer_zerocopy 读失败: {}", ec.message());
+                }
+
+                if (n == 0)
+                {
+                    co_await sender.drain();
+                    shut_close(to);
+                    co_return;
+                }
+                if (lane_)
+                {
+                    lane_.charge(n);
+                }
+
+                co_await sender.async_send(n, ec);
+                if (ec)
+                {
+                    if (graceful(ec))
+                    {
+                        shut_close(from);
+                        co_return;
+                    }
+                    throw abnormal::network_error("transfer_zerocopy 写失败: {}", ec.message());
+                }
+            }
+        }
+
         net::io_context &io_context_;
+        net::strand<net::io_context::executor_type> strand_; // 会话协程与超时处理都在此串行执行
+        const environment &environment_;
+        const option &option_;
         std::shared_ptr<ssl::context> ssl_ctx_;
         distributor &distributor_;
         socket_type client_socket_; // 客户端连接
+        quota::pass pass_;          // 客户端地址的配额凭证，空凭证表示不限制
+        shaper::lane lane_;         // 带宽整形通道，两个转发方向共用
         internal_ptr upstream_;
+        std::shared_ptr<obscura<tcp>> obscura_; // obscura 会话接管客户端 socket 后，超时需要经由它关闭
+
+        admission::ticket ticket_;   // 准入凭证，析构时归还会话数与缓冲内存计数
+        wheel::entry deadline_;      // 时间轮定时项
+        cancellation_signal abort_;  // 超时时取消会话协程当前挂起的操作（包括连接上游）
+        stage stage_ = stage::header;
+        std::uint64_t born_ = 0;     // 会话创建刻度
+        std::uint64_t since_ = 0;    // 进入当前阶段的刻度
+        std::atomic<std::uint64_t> activity_{0}; // 最近一次数据活动的刻度（多路复用时由 `multiplex` 的流协程更新）
 
         std::array<std::byte, 16384> buffer_{};
         std::pmr::monotonic_buffer_resource pool_;
@@ -166,9 +312,20 @@ namespace ngx::agent
 {
     template <socket_concept Transport>
     session<Transport>::session(net::io_context &io_context, socket_type socket, distributor &dist,
-        std::shared_ptr<ssl::context> ssl_ctx)
-    : io_context_(io_context), ssl_ctx_(std::move(ssl_ctx)), distributor_(dist),
-    client_socket_(std::move(socket)), pool_(buffer_.data(), buffer_.size()) {}
+        std::shared_ptr<ssl::context> ssl_ctx, const environment &env, quota::pass pass)
+    : io_context_(io_context), strand_(net::make_strand(io_context)), environment_(env), option_(*env.config), ssl_ctx_(std::move(ssl_ctx)), distributor_(dist),
+    client_socket_(std::move(socket)), pass_(std::move(pass)), lane_(env.shaping, pass_.level()), pool_(buffer_.data(), buffer_.size())
+    {
+        if (environment_.gate)
+        {
+            ticket_ = environment_.gate->admit(sizeof(*this));
+        }
+        if (environment_.timer)
+        {
+            born_ = since_ = environment_.timer->now();
+            activity_.store(born_, std::memory_order_relaxed);
+        }
+    }
 
     template <socket_concept Transport>
     session<Transport>::~session()
@@ -179,6 +336,21 @@ namespace ngx::agent
     template <socket_concept Transport>
     void session<Transport>::start()
     {
+        if (environment_.timer)
+        {   // 到期回调运行在时间轮所在线程，只持有弱引用并投递到会话的 strand 上处理
+            deadline_.callback([weak = this->weak_from_this(), strand = strand_]()
+            {
+                if (auto self = weak.lock())
+                {
+                    net::post(strand, [self = std::move(self)]()
+                    {
+                        self->expire();
+                    });
+                }
+            });
+            watch(stage::header);
+        }
+
         auto process = [self = this->shared_from_this()]() -> net::awaitable<void>
         {
             co_await self->diversion();
@@ -198,6 +370,13 @@ namespace ngx::agent
             {
                 session_log(e.dump());
             }
+            catch (const boost::system::system_error &e)
+            {   // 超时取消等正常收尾已在别处记录
+                if (!graceful(e.code()))
+                {
+                    session_log(e.what());
+                }
+            }
             catch (const std::exception &e)
             {
                 session_log(e.what());
@@ -206,7 +385,8 @@ namespace ngx::agent
             self->close();
         };
 
-        net::co_spawn(io_context_, std::move(process), std::move(completion));
+        // 协程运行在会话的 strand 上，与 `expire` 串行，成员无需额外同步；取消槽供超时时中止挂起的操作
+        net::co_spawn(strand_, std::move(process), net::bind_cancellation_slot(abort_.slot(), std::move(completion)));
     }
 
     /**
@@ -216,11 +396,155 @@ namespace ngx::agent
     template <socket_concept Transport>
     void session<Transport>::close()
     {
+        if (environment_.timer)
+        {
+            environment_.timer->cancel(deadline_);
+        }
+        if (obscura_)
+        {
+            obscura_->abort();
+            obscura_.reset();
+        }
         shut_close(client_socket_);
         shut_close(upstream_);
         upstream_.reset();
     }
 
+    /**
+     * @brief 进入新阶段并按该阶段的超时重新布防
+     * @param next 新阶段
+     */
+    template <socket_concept Transport>
+    void session<Transport>::watch(const stage next)
+    {
+        auto *timer = environment_.timer;
+        if (!timer)
+        {
+            return;
+        }
+
+        stage_ = next;
+        since_ = timer->now();
+        activity_.store(since_, std::memory_order_relaxed);
+        if (const auto deadline = due(); deadline != 0)
+        {
+            timer->arm(deadline_, deadline);
+        }
+        else
+        {
+            timer->cancel(deadline_);
+        }
+    }
+
+    /**
+     * @brief 计算最近的到期刻度
+     * @return 阶段超时与总时长超时中较早的一个，0 表示不限制
+     */
+    template <socket_concept Transport>
+    std::uint64_t session<Transport>::due() const noexcept
+    {
+        const auto &timeout = option_.timeout;
+        const auto *timer = environment_.timer;
+        const auto after = [timer](const std::uint64_t from, const std::chrono::seconds limit) -> std::uint64_t
+        {
+            return limit.count() > 0 ? from + timer->ticks(limit) : 0;
+        };
+
+        std::uint64_t phase = 0;
+        switch (stage_)
+        {
+        case stage::header:
+            phase = after(since_, timeout.header);
+            break;
+        case stage::connect:
+            phase = after(since_, timeout.connect);
+            break;
+        case stage::tunnel:
+            phase = after(activity_.load(std::memory_order_relaxed), timeout.idle);
+            break;
+        }
+
+        const std::uint64_t lifetime = after(born_, timeout.lifetime);
+        if (phase == 0 || lifetime == 0)
+        {
+            return phase | lifetime;
+        }
+        return std::min(phase, lifetime);
+    }
+
+    /**
+     * @brief 定时项到期
+     * @details 在会话的 strand 上执行，与会话协程不会并发。
+     * 隧道阶段的活动时间戳在转发时只写不改期，所以这里先重算：
+     * 仍未到期则按新的截止刻度重新布防，否则向会话协程发出终止取消，并关闭两端 socket。
+     * 连接阶段 `upstream_` 尚未赋值，正在进行的解析与连接只能经由取消信号中止；
+     * obscura 握手期间 `obscura_` 同样尚未赋值，握手可能运行在卸载线程池上，也只经由取消信号中止。
+     */
+    template <socket_concept Transport>
+    void session<Transport>::expire()
+    {
+        auto *timer = environment_.timer;
+        const auto deadline = due();
+        if (deadline == 0)
+        {
+            return;
+        }
+
+        if (timer->now() < deadline)
+        {
+            timer->arm(deadline_, deadline);
+            return;
+        }
+
+        static constexpr std::array<std::string_view, 3> names{"header", "connect", "tunnel"};
+        session_log(std::string("session timeout at stage ").append(names[static_cast<std::size_t>(stage_)]));
+
+        abort_.emit(net::cancellation_type::terminal);
+
+        // 协程仍在使用这些 socket，这里只关闭不释放，释放交给协程退出后的正常流程
+        if (obscura_)
+        {
+            obscura_->abort();
+        }
+        shut_close(client_socket_);
+        shut_close(upstream_);
+    }
+
+    /**
+     * @brief 等待整形令牌
+     * @param want 缓冲区大小
+     * @param cancel_slot 取消信号槽，未连接时沿用协程自身的取消
+     * @return 授权的读取长度；等待被取消（隧道另一方向已结束或会话超时）时返回 0
+     * @details 只在令牌不足时调用。唤醒时刻由 `shaper::lane::wake` 对齐到刻度，
+     * 大量受限会话的定时器在同一时刻到期、一次处理；醒来后令牌被其他会话抢先用完时继续等待下一个刻度。
+     */
+    template <socket_concept Transport>
+    net::awaitable<std::size_t> session<Transport>::throttle(const std::size_t want, const cancellation_slot cancel_slot)
+    {
+        net::steady_timer timer(co_await net::this_coro::executor);
+        while (true)
+        {
+            timer.expires_at(lane_.wake(want));
+            boost::system::error_code ec;
+            if (cancel_slot.is_connected())
+            {
+                co_await timer.async_wait(net::bind_cancellation_slot(cancel_slot, net::redirect_error(net::use_awaitable, ec)));
+            }
+            else
+            {
+                co_await timer.async_wait(net::redirect_error(net::use_awaitable, ec));
+            }
+            if (ec)
+            {
+                co_return 0;
+            }
+            if (const auto granted = lane_.grant(want); granted != 0)
+            {
+                co_return granted;
+            }
+        }
+    }
+
     /**
      * @brief 会话分发器
      * @details 该函数会根据请求协议类型，选择相应的处理函数。
@@ -281,6 +605,7 @@ namespace ngx::agent
             // std::cerr << "[Session] HTTP request received: " << req.method_string() << " " << req.target() << std::endl;
 
             //  连接上游
+            watch(stage::connect);
             const auto target = analysis::resolve(req);
             if (target.forward_proxy)
             {
@@ -288,7 +613,12 @@ namespace ngx::agent
             }
             else
             {
-                upstream_ = co_await distributor_.route_reverse(target.host);
+                affinity hint;
+                boost::system::error_code ec;
+                hint.client = client_socket_.remote_endpoint(ec).address();
+                hint.path = std::string_view(req.target());
+                hint.path = hint.path.substr(0, hint.path.find('?'));
+                upstream_ = co_await distributor_.route_reverse(target.host, hint);
             }
 
             if (!upstream_) 
@@ -339,12 +669,14 @@ namespace ngx::agent
         } // 限制request 生命周期防止在下面request指向无效的tcp字节流
         
         // std::cerr << "[Session] Starting tunnel..." << std::endl;
+        watch(stage::tunnel);
         co_await tunnel();
     }
 
     /**
      * @brief 隧道 TCP 流量
      * @details 该函数会在客户端套接字和上游服务器套接字之间建立隧道，实现流量的双向传输。
+     * 优先从 `worker` 的隧道缓冲池租用槽位（io_uring 下为已注册缓冲区），池子耗尽或未启用时使用会话自带缓冲区。
      */
     template<socket_concept Transport>
     net::awaitable<void> session<Transport>::tunnel()
@@ -354,6 +686,30 @@ namespace ngx::agent
             co_return;
         }
 
+        pool_.release();
+
+        if (environment_.buffers)
+        {
+            if (const auto lease = environment_.buffers->acquire())
+            {
+                co_await relay(lease.left(), lease.right());
+                co_return;
+            }
+        }
+
+        const std::size_t half = buffer_.size() / 2;
+        co_await relay(mutable_buf(buffer_.data(), half), mutable_buf(buffer_.data() + half, buffer_.size() - half));
+    }
+
+    /**
+     * @brief 双向转发
+     * @param left_buffer 客户端 -> 上游方向的缓冲区
+     * @param right_buffer 上游 -> 客户端方向的缓冲区
+     */
+    template<socket_concept Transport>
+    template <typename Buffer>
+    net::awaitable<void> session<Transport>::relay(Buffer left_buffer, Buffer right_buffer)
+    {
         /**
          * @details 使用 awaitable_operators 实现双向隧道。
          * 使用 || 运算符并发执行两个传输任务：
@@ -363,12 +719,6 @@ namespace ngx::agent
          */
         using namespace boost::asio::experimental::awaitable_operators;
 
-        pool_.release();
-
-        const std::size_t half = buffer_.size() / 2;
-        auto left_buffer = mutable_buf(buffer_.data(), half);
-        auto right_buffer = mutable_buf(buffer_.data() + half, buffer_.size() - half);
-
         auto client_to_upstream = [this, left_buffer]() -> net::awaitable<void>
         {
             // std::cerr << "[Session] Tunnel: Client -> Upstream started." << std::endl;
@@ -379,6 +729,16 @@ namespace ngx::agent
         auto upstream_to_client = [this, right_buffer]() -> net::awaitable<void>
         {
             // std::cerr << "[Session] Tunnel: Upstream -> Client started." << std::endl;
+            // 下行方向是大流量主力：客户端 socket 由会话独占，可以安全地开启零拷贝
+            // 上行方向的上游连接会回收进连接池，内核通知序号无法跨会话延续，因此不启用
+            if constexpr (std::is_same_v<socket_type, tcp::socket>)
+            {
+                if (option_.zerocopy.enable && zerocopy::supported())
+                {
+                    co_await transfer_zerocopy(*upstream_, client_socket_);
+                    co_return;
+                }
+            }
             co_await transfer_tcp(*upstream_, client_socket_, right_buffer);
             // std::cerr << "[Session] Tunnel: Upstream -> Client finished." << std::endl;
         };
@@ -406,10 +766,14 @@ namespace ngx::agent
     /**
      * @brief 处理 obscura 协议
      * @details 该函数会处理 obscura 协议，并建立与上游服务器的连接。
+     * 读到升级请求后即可确定目标，上游连接与 websocket 升级并发进行；
+     * 客户端随升级请求携带的首包在上游就绪后先行写入，省去一次往返。
      */
     template <socket_concept Transport>
     net::awaitable<void> session<Transport>::handle_obscura()
     {
+        using namespace boost::asio::experimental::awaitable_operators;
+
         if (!ssl_ctx_)
         {
             co_return;
@@ -417,10 +781,27 @@ namespace ngx::agent
 
         pool_.release();
         auto proto = std::make_shared<obscura<tcp>>(std::move(client_socket_), ssl_ctx_, role::server);
+        proto->tune(option_.obscura.write_buffer, option_.obscura.message_max);
+
+        auto upgrade = [proto]() -> net::awaitable<void>
+        {
+            try
+            {
+                co_await proto->accept_upgrade();
+            }
+            catch (const boost::system::system_error &e)
+            {
+                throw abnormal::protocol_error("obscura 握手失败: {}", e.code().message());
+            }
+        };
+
+        // 握手可能在线程池上执行，期间超时只经由取消信号中止；握手结束回到会话 strand 后才交给 `expire` 关闭
         std::string target_path;
         try
-        {
-            target_path = co_await proto->handshake();
+        {   // 握手计算量大，配置了握手线程池时整体移到池上执行，不占用转发线程
+            target_path = environment_.handshake
+                ? co_await environment_.handshake->run(proto->accept_request())
+                : co_await proto->accept_request();
         }
         catch (const boost::system::system_error &e)
         {
@@ -430,6 +811,20 @@ namespace ngx::agent
         {
             throw abnormal::protocol_error("obscura 握手失败: {}", e.what());
         }
+        obscura_ = proto;
+
+        const std::string early = proto->early();
+
+        if (!option_.multiplex.path.empty() && target_path == option_.multiplex.path)
+        {
+            if (!early.empty())
+            {   // 多路复用的首个消息必须是 connect 帧，不接受随升级请求携带的数据
+                throw abnormal::protocol_error("obscura 多路复用不支持首包");
+            }
+            co_await upgrade();
+            co_await handle_multiplex(std::move(proto));
+            co_return;
+        }
 
         if (target_path.starts_with('/'))
         {
@@ -441,15 +836,87 @@ namespace ngx::agent
             co_return;
         }
 
-        upstream_ = co_await distributor_.route_forward(target.host, target.port);
+        watch(stage::connect);
+        upstream_ = co_await (distributor_.route_forward(target.host, target.port) && upgrade());
         if (!upstream_ || !upstream_->is_open())
         {
             co_return;
         }
 
+        if (!early.empty())
+        {
+            boost::system::error_code ec;
+            co_await adaptation::async_write(*upstream_, net::buffer(early), net::redirect_error(net::use_awaitable, ec));
+            if (ec)
+            {
+                if (graceful(ec))
+                {
+                    co_return;
+                }
+                throw abnormal::network_error("写入上游失败: {}", ec.message());
+            }
+        }
+
+        watch(stage::tunnel);
         co_await tunnel_obscura(std::move(proto));
     }
 
+    /**
+     * @brief 处理多路复用的 obscura 连接
+     * @param proto 已完成握手的 obscura 协议实例
+     * @details 连接上的所有逻辑流交给 `multiplex`，它与会话协程同在会话的 strand 上运行：
+     * 各条流的协程不会并发访问共享状态，超时时 `expire` 关闭 obscura 连接也不会与收发帧的协程并发。
+     */
+    template <socket_concept Transport>
+    net::awaitable<void> session<Transport>::handle_multiplex(std::shared_ptr<obscura<tcp>> proto)
+    {
+        watch(stage::tunnel);
+
+        auto mux = std::make_shared<multiplex>(proto, distributor_, option_.multiplex,
+            [self = this->shared_from_this()]()
+            {
+                self->touch();
+            });
+        if (environment_.gate)
+        {   // 各条流的收发队列计入准入内存，会话协程此时挂起等待多路复用结束，凭证只在会话的 strand 上修改
+            mux->meter([self = this->shared_from_this()](const std::ptrdiff_t delta)
+            {
+                if (delta > 0)
+                {
+                    self->ticket_.charge(static_cast<std::size_t>(delta));
+                }
+                else
+                {
+                    self->ticket_.refund(static_cast<std::size_t>(-delta));
+                }
+            });
+        }
+
+        std::exception_ptr error;
+        try
+        {
+            co_await net::co_spawn(strand_, mux->run(), net::use_awaitable);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+
+        try
+        {
+            co_await proto->close();
+        }
+        catch (const std::exception &)
+        {
+            // 连接已断开时关闭帧发不出去，忽略
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
     /**
      * @brief 从 obscura 协议读取数据并写入服务器
      * @param proto obscura 协议实例
@@ -457,15 +924,25 @@ namespace ngx::agent
      * @details 该函数会从 obscura 协议读取数据，并将数据写入服务器。
      */
     template <socket_concept Transport>
-    net::awaitable<void> session<Transport>::transfer_obscura(obscura<tcp> &proto, const cancellation_slot cancel_slot) const
+    net::awaitable<void> session<Transport>::transfer_obscura(obscura<tcp> &proto, const cancellation_slot cancel_slot)
     {
-        beast::flat_buffer buffer;
+        // 会话缓冲区的后半段：前半段留给反方向，整个隧道期间不再分配内存
+        const std::size_t half = buffer_.size() / 2;
+        const auto buffer = mutable_buf(buffer_.data() + half, buffer_.size() - half);
+
         while (true)
         {
+            std::size_t allowed = lane_ ? lane_.grant(buffer.size()) : buffer.size();
+            if (allowed == 0 && (allowed = co_await throttle(buffer.size(), cancel_slot)) == 0)
+            {
+                co_return;
+            }
+
             std::size_t n = 0;
             try
-            {
-                n = co_await proto.async_read(buffer);
+            {   // 分段读取，大消息边到达边转发
+                n = co_await proto.async_read_some(net::buffer(buffer, allowed));
+                touch();
             }
             catch (const boost::system::system_error &e)
             {
@@ -481,13 +958,17 @@ namespace ngx::agent
             }
 
             if (n == 0)
+            {   // 空消息或空分片，连接关闭会以异常形式报告
+                continue;
+            }
+            if (lane_)
             {
-                co_return;
+                lane_.charge(n);
             }
 
             boost::system::error_code ec;
             auto token = net::bind_cancellation_slot(cancel_slot, net::redirect_error(net::use_awaitable, ec));
-            co_await adaptation::async_write(*upstream_, buffer.data(), token);
+            co_await adaptation::async_write(*upstream_, net::buffer(buffer.data(), n), token);
             if (ec)
             {
                 if (graceful(ec))
@@ -496,8 +977,6 @@ namespace ngx::agent
                 }
                 throw abnormal::network_error("写入上游失败: {}", ec.message());
             }
-
-            buffer.consume(n);
         }
     }
 
@@ -505,19 +984,53 @@ namespace ngx::agent
      * @brief 从服务器读取数据并写入 obscura 协议
      * @param proto obscura 协议实例
      * @param cancel_slot 取消信号槽实例
-     * @param buffer 用于读取数据的缓冲区
+     * @param buffer 用于读取数据的缓冲区（小于配置的合批上限时改用独立的合批缓冲区）
      * @details 该函数会从服务器读取数据，并将数据写入 obscura 协议实例。
+     * 每次读到数据后先经 `coalesce` 合批，再作为一条 websocket 消息写出。
      */
     template <socket_concept Transport>
-    net::awaitable<void> session<Transport>::transfer_obscura(obscura<tcp> &proto, const cancellation_slot cancel_slot, mutable_buf buffer) const
+    net::awaitable<void> session<Transport>::transfer_obscura(obscura<tcp> &proto, const cancellation_slot cancel_slot, mutable_buf buffer)
     {
         boost::system::error_code ec;
         auto token = net::bind_cancellation_slot(cancel_slot, net::redirect_error(net::use_awaitable, ec));
 
+        std::unique_ptr<char[]> batch;
+        if (option_.obscura.batch > buffer.size())
+        {
+            batch = std::make_unique_for_overwrite<char[]>(option_.obscura.batch);
+            buffer = mutable_buf(batch.get(), option_.obscura.batch);
+            ticket_.charge(option_.obscura.batch);
+        }
+        net::steady_timer timer(co_await net::this_coro::executor);
+
+        // `coalesce` 依赖非阻塞读；上游连接会回收进连接池，退出时恢复原来的模式，不影响下一个使用者
+        struct restore
+        {
+            tcp::socket &socket;
+            bool previous;
+            ~restore()
+            {
+                boost::system::error_code ignored;
+                if (socket.is_open())
+                {
+                    socket.non_blocking(previous, ignored);
+                }
+            }
+        } restore_on_exit{*upstream_, upstream_->non_blocking()};
+        upstream_->non_blocking(true, ec);
+
         while (true)
         {
+            std::size_t allowed = lane_ ? lane_.grant(buffer.size()) : buffer.size();
+            if (allowed == 0 && (allowed = co_await throttle(buffer.size(), cancel_slot)) == 0)
+            {
+                co_return;
+            }
+            const auto window = mutable_buf(buffer.data(), allowed);
+
             ec.clear();
-            const std::size_t n = co_await adaptation::async_read(*upstream_, buffer, token);
+            std::size_t n = co_await adaptation::async_read(*upstream_, window, token);
+            touch();
             if (ec)
             {
                 if (graceful(ec))
@@ -532,9 +1045,16 @@ namespace ngx::agent
                 co_return;
             }
 
+            // 合批过程中遇到的 EOF/错误先记下，把已读到的数据写出后再处理；合批同样不超出授权长度
+            n += co_await coalesce(window + n, timer, ec);
+            if (lane_)
+            {
+                lane_.charge(n);
+            }
+
             try
             {   // 写入 obscura 协议
-                const auto view = std::string_view(static_cast<const char *>(buffer.data()), n);
+                const auto view = std::string_view(static_cast<const char *>(window.data()), n);
                 co_await proto.async_write(view);
             }
             catch (const boost::system::system_error &e)
@@ -549,7 +1069,73 @@ namespace ngx::agent
             {
                 throw abnormal::protocol_error("obscura 写失败: {}", e.what());
             }
+
+            if (ec)
+            {
+                if (graceful(ec))
+                {
+                    co_return;
+                }
+                throw abnormal::network_error("从上游读取失败: {}", ec.message());
+            }
+        }
+    }
+
+    /**
+     * @brief 合批读取上游数据
+     * @param space 缓冲区剩余空间
+     * @param timer 等待凑批用的定时器
+     * @param ec 读到 EOF 或出错时设置，由调用方在写出已读数据后处理
+     * @return 额外读入的字节数
+     * @details 先用非阻塞读收下所有立即可读的数据；配置了 `delay` 时，在截止时间前继续等待上游可读，
+     * 直到缓冲区写满、超时或上游结束。
+     */
+    template <socket_concept Transport>
+    net::awaitable<std::size_t> session<Transport>::coalesce(mutable_buf space, net::steady_timer &timer, boost::system::error_code &ec)
+    {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        const auto delay = option_.obscura.delay;
+        const auto deadline = std::chrono::steady_clock::now() + delay;
+        std::size_t total = 0;
+
+        while (space.size() != 0)
+        {
+            const std::size_t n = upstream_->read_some(space, ec);
+            if (!ec)
+            {
+                total += n;
+                space += n;
+                continue;
+            }
+
+            if (ec != net::error::would_block && ec != net::error::try_again)
+            {
+                co_return total;
+            }
+            ec.clear();
+
+            if (delay.count() <= 0 || std::chrono::steady_clock::now() >= deadline)
+            {
+                break;
+            }
+
+            timer.expires_at(deadline);
+            try
+            {
+                const auto result = co_await (upstream_->async_wait(tcp::socket::wait_read, net::use_awaitable)
+                    || timer.async_wait(net::use_awaitable));
+                if (result.index() == 1)
+                {   // 等待超时
+                    break;
+                }
+            }
+            catch (const boost::system::system_error &)
+            {   // socket 已关闭等情况，交给下一次读取报告
+                break;
+            }
         }
+        co_return total;
     }
 
     /**
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "option.hpp"
+
+namespace ngx::agent
+{
+    /**
+     * @brief 隧道带宽整形
+     * @details 分层令牌桶：全局（进程内全部隧道）→ 监听器（一个 `worker` 的全部隧道）→ 客户端地址（见 `quota`）→ 会话。
+     * 会话在读取前按各级剩余令牌的最小值限制本次读取长度，读到后逐级扣除；任何一级没有令牌时不读取，
+     * 数据留在内核缓冲区里由 TCP 流控反压对端，代理自身不积压。
+     * 每个桶只是一个 GCRA “理论到达时间”原子量，补充在用到时按当前时间折算，不需要逐个会话刷新；
+     * 等待令牌的会话把唤醒时刻向上对齐到统一的刻度，同一刻度到期的定时器在一次事件循环中集中处理。
+     * 全局层级由调用方以 `budget` 持有并在构造时传入，多个 `worker` 的整形器引用同一个 `budget` 即共享全局限额。
+     * @note 全部操作无锁，可被运行同一 `io_context` 的多个线程同时调用。
+     */
+    class shaper
+    {
+    public:
+        /**
+         * @brief 速率：每秒字节数与桶深
+         */
+        struct rate
+        {
+            std::uint64_t bytes = 0;    // 每秒字节数，0 表示不限制
+            std::int64_t tolerance = 0; // 桶深折算成的时长（纳秒）
+
+            rate() = default;
+            rate(std::uint64_t bytes_per_second, std::chrono::nanoseconds depth) noexcept;
+
+            /**
+             * @brief 转发 `n` 字节占用的时长（纳秒）
+             */
+            [[nodiscard]] std::int64_t cost(const std::size_t n) const noexcept
+            {
+                return static_cast<std::int64_t>(n * std::uint64_t{1000000000} / bytes);
+            }
+        }; // struct rate
+
+        /**
+         * @brief 令牌桶
+         * @details 以 GCRA 形式保存：理论到达时间领先当前时间的部分就是已透支的令牌，领先不超过桶深即有余量。
+         */
+        class bucket
+        {
+        public:
+            [[nodiscard]] std::size_t allowance(const rate &limit, std::int64_t now) const noexcept;
+            [[nodiscard]] std::int64_t delay(const rate &limit, std::size_t bytes, std::int64_t now) const noexcept;
+            void charge(const rate &limit, std::size_t bytes, std::int64_t now) noexcept;
+
+            void reset() noexcept
+            {
+                arrival_.store(0, std::memory_order_relaxed);
+            }
+
+        private:
+            std::atomic<std::int64_t> arrival_{0};
+        }; // class bucket
+
+        /**
+         * @brief 层级：一个桶与它的速率
+         */
+        struct level
+        {
+            bucket *meter = nullptr;
+            const rate *limit = nullptr;
+        }; // struct level
+
+        /**
+         * @brief 持有桶与速率的层级
+         * @details 用于全局层级：由进程入口（或未共享时由 `worker`）持有，速率在构造后不再修改，
+         * 生命周期须覆盖所有引用它的整形器及其会话。
+         */
+        struct budget
+        {
+            bucket meter;
+            const rate limit;
+
+            budget(const std::uint64_t bytes_per_second, const std::chrono::nanoseconds depth) noexcept
+                : limit(bytes_per_second, depth)
+            {
+            }
+
+            budget(const budget &) = delete;
+            budget &operator=(const budget &) = delete;
+
+            [[nodiscard]] level view() noexcept
+            {
+                return {&meter, &limit};
+            }
+        }; // struct budget
+
+        /**
+         * @brief 会话的整形通道
+         * @details 持有会话自己的桶，并引用上面各级共享的桶；默认构造的通道不限制。
+         */
+        class lane
+        {
+        public:
+            lane() = default;
+            lane(const shaper *owner, level client) noexcept;
+            lane(const lane &) = delete;
+            lane &operator=(const lane &) = delete;
+
+            [[nodiscard]] std::size_t grant(std::size_t want) const noexcept;
+            [[nodiscard]] std::chrono::steady_clock::time_point wake(std::size_t want) const noexcept;
+            void charge(std::size_t bytes) noexcept;
+
+            [[nodiscard]] explicit operator bool() const noexcept
+            {
+                return count_ != 0 || own_rate_.bytes != 0;
+            }
+
+        private:
+            std::array<level, 3> levels_{}; // 全局、监听器、客户端中受限的几级
+            std::size_t count_ = 0;
+            rate own_rate_;                 // 会话级速率
+            bucket own_;                    // 会话级桶（双向合计）
+            std::int64_t tick_ = 10000000;  // 唤醒对齐粒度（纳秒）
+        }; // class lane
+
+        explicit shaper(const option::shaping_option &opt);
+        shaper(const option::shaping_option &opt, level global);
+        shaper(const shaper &) = delete;
+        shaper &operator=(const shaper &) = delete;
+
+        /**
+         * @brief 参数中是否配置了任一层级
+         */
+        [[nodiscard]] static bool enabled(const option::shaping_option &opt) noexcept
+        {
+            return opt.global != 0 || opt.listener != 0 || opt.session != 0;
+        }
+
+        [[nodiscard]] static std::int64_t now() noexcept;
+
+    private:
+        level global_;
+        rate listener_rate_;
+        rate session_rate_;
+        mutable bucket listener_; // 会话通道经 `const shaper *` 引用，桶本身是原子量
+        std::int64_t tick_;
+    }; // class shaper
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <utility>
+
+namespace ngx::agent
+{
+    /**
+     * @brief 不可变快照的发布与读取（RCU 风格）
+     * @tparam T 快照类型，发布后不再修改
+     * @details 写者构造一份完整的新快照后调用 `publish` 原子替换，从不原地修改；
+     * 读者在每个线程里缓存当前快照的共享指针和代号，代号未变时 `load` 只有一次原子读，不加锁、不改引用计数，
+     * 代号变化后才从共享指针重新取一次。旧快照在最后一个缓存它的线程换新（或线程退出）时释放。
+     * @note `load` 返回的引用在本线程下一次 `load` 之前有效，因此不能跨越 `co_await` 持有；
+     * 需要跨挂起点使用的数据应在挂起前复制出来（或复制其中的共享指针）。
+     */
+    template <typename T>
+    class snapshot
+    {
+    public:
+        explicit snapshot(std::shared_ptr<const T> initial)
+            : current_(std::move(initial)), generation_(next_generation())
+        {
+        }
+
+        snapshot(const snapshot &) = delete;
+        snapshot &operator=(const snapshot &) = delete;
+
+        /**
+         * @brief 发布新快照
+         * @note 可在任意线程调用；多个写者之间需自行串行化
+         */
+        void publish(std::shared_ptr<const T> next)
+        {
+            current_.store(std::move(next), std::memory_order_release);
+            generation_.store(next_generation(), std::memory_order_release);
+        }
+
+        /**
+         * @brief 读取当前快照
+         */
+        [[nodiscard]] const T &load() const
+        {
+            auto &cache = local();
+            const auto generation = generation_.load(std::memory_order_acquire);
+            if (cache.owner != this || cache.generation != generation)
+            {
+                cache.value = current_.load(std::memory_order_acquire);
+                cache.owner = this;
+                cache.generation = generation;
+            }
+            return *cache.value;
+        }
+
+        /**
+         * @brief 取当前快照的共享指针（写者或低频路径使用）
+         */
+        [[nodiscard]] std::shared_ptr<const T> acquire() const
+        {
+            return current_.load(std::memory_order_acquire);
+        }
+
+    private:
+        /**
+         * @brief 线程私有的缓存，每个线程只缓存最近访问的一个实例
+         */
+        struct cache_entry
+        {
+            const snapshot *owner = nullptr;
+            std::uint64_t generation = 0;
+            std::shared_ptr<const T> value;
+        }; // struct cache_entry
+
+        static cache_entry &local() noexcept
+        {
+            thread_local cache_entry entry;
+            return entry;
+        }
+
+        /**
+         * @brief 进程内全局递增的代号，实例地址被复用时也不会误命中旧缓存
+         */
+        static std::uint64_t next_generation() noexcept
+        {
+            static std::atomic<std::uint64_t> counter{0};
+            return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+
+        std::atomic<std::shared_ptr<const T>> current_;
+        std::atomic<std::uint64_t> generation_;
+    }; // class snapshot
+}
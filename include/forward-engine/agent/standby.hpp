@@ -0,0 +1,87 @@
+#pragma once
+
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include "option.hpp"
+#include "obscura.hpp"
+#include "multiplex.hpp"
+#include "ticket.hpp"
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+    namespace ssl = boost::asio::ssl;
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @brief 预热的 obscura 客户端连接池
+     * @details 面向 `ingress_option` 配置的单个远端，池中每条连接都已完成 TLS 与 WebSocket 升级并运行多路复用，
+     * 新流直接取用，关键路径上没有握手。
+     * - 补充：连接数低于 `min`，或所有连接都已承载流（没有空闲备用）且未达 `max` 时，后台建立新连接；
+     *   建立失败按 1 秒起、最长 30 秒的退避间隔重试；
+     * - 保活：每条连接按 `keepalive` 周期探测，一个周期内没有回显即中止并移出池；
+     * - 收缩：超出 `min` 的连接空闲超过 `idle` 后关闭，但总保留一条空闲备用；
+     * - 客户端 TLS 上下文安装了会话缓存，补充连接时走会话恢复。
+     * @note 池状态由互斥量保护，`acquire` 可在任意线程调用；补充与收缩由一个跑在独立 strand 上的协程决定。
+     */
+    class standby
+    {
+    public:
+        /**
+         * @brief 池中的连接
+         */
+        struct channel
+        {
+            std::shared_ptr<obscura<tcp>> proto;
+            std::shared_ptr<multiplex> mux;
+            net::strand<net::io_context::executor_type> strand; // 多路复用状态所在的 strand
+            std::chrono::steady_clock::time_point idle_since;   // 最近一次被观察到空闲或被取用的时间
+        }; // struct channel
+
+        standby(net::io_context &ioc, const option &opt);
+
+        standby(const standby &) = delete;
+        standby &operator=(const standby &) = delete;
+
+        void start();
+        void stop();
+
+        [[nodiscard]] std::shared_ptr<channel> acquire();
+
+        /**
+         * @brief 可以承载新流的连接数
+         */
+        [[nodiscard]] std::size_t established();
+
+    private:
+        net::awaitable<void> supervise();
+        net::awaitable<void> grow();
+        net::awaitable<std::shared_ptr<channel>> dial();
+        net::awaitable<std::shared_ptr<channel>> establish();
+
+        void reconcile();
+        void nudge();
+        static void retire(const std::shared_ptr<channel> &item);
+
+        net::io_context &ioc_;
+        const option &option_;
+        std::shared_ptr<ssl::context> ssl_ctx_;
+        resumption resumption_;
+
+        net::strand<net::io_context::executor_type> strand_; // 补充与收缩决策所在的 strand
+        net::steady_timer wake_;
+        bool pending_ = false;                               // 有未处理的补充请求（仅在 strand_ 上访问）
+
+        std::mutex mutex_;
+        std::vector<std::shared_ptr<channel>> channels_;
+        std::size_t dialing_ = 0;                            // 正在建立的连接数
+        std::chrono::seconds backoff_{0};                    // 当前重试退避间隔
+        std::chrono::steady_clock::time_point retry_{};      // 最早可以再次建立连接的时间
+        bool stopped_ = false;
+    }; // class standby
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <deque>
+#include <string>
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include <boost/asio/ssl.hpp>
+
+namespace ngx::agent
+{
+    namespace ssl = boost::asio::ssl;
+
+    /**
+     * @brief 配置服务端 TLS 版本范围
+     * @details 最低 TLS 1.2，允许协商 TLS 1.3（1-RTT 握手，且会话恢复走无状态票据）。
+     */
+    void modernize(ssl::context &context);
+
+    /**
+     * @brief 服务端会话票据密钥环
+     * @details 通过 OpenSSL 的票据密钥回调接管票据加解密，实现无状态会话恢复：
+     * 服务端不保存任何会话，所有状态都加密在发给客户端的票据里。
+     * 密钥定期轮换，最新的密钥用于签发，旧密钥在保留期内仍可解密；用旧密钥恢复的会话会被要求换发新票据。
+     * @note 回调可能在多个线程上并发执行，内部以互斥量保护。
+     */
+    class keyring
+    {
+    public:
+        /**
+         * @brief 票据密钥
+         */
+        struct key
+        {
+            std::array<unsigned char, 16> name{};  // 票据中携带的密钥名
+            std::array<unsigned char, 32> cipher{}; // AES-256-CBC 密钥
+            std::array<unsigned char, 32> mac{};    // HMAC-SHA256 密钥
+        }; // struct key
+
+        /**
+         * @param keep 保留的密钥数量（含当前签发密钥），至少为 1
+         */
+        explicit keyring(std::size_t keep = 3);
+
+        keyring(const keyring &) = delete;
+        keyring &operator=(const keyring &) = delete;
+
+        void install(ssl::context &context);
+        void rotate();
+
+        /**
+         * @brief 取签发用的密钥
+         */
+        [[nodiscard]] key current();
+
+        /**
+         * @brief 按名字查找解密用的密钥
+         * @param name 票据中的密钥名
+         * @param result 找到的密钥
+         * @param fresh 是否为当前签发密钥（否则需要换发票据）
+         */
+        [[nodiscard]] bool find(const unsigned char *name, key &result, bool &fresh);
+
+    private:
+        std::mutex mutex_;
+        std::size_t keep_;
+        std::deque<key> keys_; // 头部为当前签发密钥
+    }; // class keyring
+
+    /**
+     * @brief 客户端会话缓存
+     * @details 以 SNI 主机名为键缓存服务端下发的会话票据，重连同一主机时恢复会话，
+     * 省去证书校验与完整密钥交换。TLS 1.3 票据按 RFC 8446 建议只使用一次，取出即移除，
+     * 恢复成功后服务端会下发新票据再次入缓存。
+     * @note 0-RTT 早期数据需要 `SSL_write_early_data`/`SSL_read_early_data`，
+     * Asio 的 `ssl::stream` 握手路径没有对应接口，因此这里只做 1-RTT 恢复，不发送早期数据。
+     */
+    class resumption
+    {
+    public:
+        explicit resumption(std::size_t capacity = 256);
+        ~resumption();
+
+        resumption(const resumption &) = delete;
+        resumption &operator=(const resumption &) = delete;
+
+        void install(ssl::context &context);
+
+        /**
+         * @brief 握手前为连接设置缓存的会话
+         * @param handle 连接的 `SSL*`
+         * @param host SNI 主机名，为空时不恢复
+         * @details 连接所属的上下文未安装缓存时为空操作。
+         */
+        static void resume(SSL *handle, std::string_view host);
+
+    private:
+        static int on_session(SSL *handle, SSL_SESSION *session);
+
+        void store(std::string_view host, SSL_SESSION *session);
+        [[nodiscard]] SSL_SESSION *take(std::string_view host);
+
+        std::mutex mutex_;
+        std::size_t capacity_;
+        std::unordered_map<std::string, SSL_SESSION *> sessions_;
+    }; // class resumption
+}
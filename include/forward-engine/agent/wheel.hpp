@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <boost/asio.hpp>
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+
+    /**
+     * @brief 分层时间轮
+     * @details 每个 `worker` 一份，整个时间轮只占用一个 `steady_timer`，按固定刻度推进。
+     * 采用 256 + 64 * 3 的四级槽位（与 Linux 早期内核定时器相同的布局），
+     * 布防、改期、撤销都是对侵入式双向链表的 O(1) 操作，到期时按级联方式逐级下沉。
+     * @note 所有操作都在内部互斥量保护下进行，回调在锁外执行，可以在回调里再次布防。
+     */
+    class wheel
+    {
+    public:
+        /**
+         * @brief 时间轮上的定时项
+         * @details 由使用方（通常是 `session`）持有，析构时自动撤销，不需要额外分配内存。
+         */
+        class entry
+        {
+            friend class wheel;
+
+        public:
+            entry() = default;
+            entry(const entry &) = delete;
+            entry &operator=(const entry &) = delete;
+            ~entry();
+
+            /**
+             * @brief 设置到期回调
+             * @param callback 到期回调（在时间轮线程上、锁外执行）
+             * @note 必须在首次布防之前设置，布防期间不要修改。
+             */
+            void callback(std::function<void()> callback)
+            {
+                callback_ = std::move(callback);
+            }
+
+            [[nodiscard]] bool armed() const noexcept
+            {
+                return owner_.load(std::memory_order_acquire) != nullptr;
+            }
+
+        private:
+            entry *prev_ = nullptr;
+            entry *next_ = nullptr;
+            entry **head_ = nullptr;
+            std::atomic<wheel *> owner_{nullptr};
+            std::uint64_t deadline_ = 0;
+            std::function<void()> callback_;
+        }; // class entry
+
+        wheel(net::io_context &ioc, std::chrono::milliseconds tick);
+        wheel(const wheel &) = delete;
+        wheel &operator=(const wheel &) = delete;
+        ~wheel();
+
+        void start();
+        void stop();
+
+        void arm(entry &item, std::uint64_t deadline);
+        void cancel(entry &item);
+
+        /**
+         * @brief 当前刻度
+         * @details 无锁读取，适合在热路径上给会话打“最近活跃”时间戳。
+         */
+        [[nodiscard]] std::uint64_t now() const noexcept
+        {
+            return current_.load(std::memory_order_relaxed);
+        }
+
+        [[nodiscard]] std::uint64_t ticks(std::chrono::milliseconds duration) const noexcept;
+
+    private:
+        static constexpr std::size_t near_bits = 8;
+        static constexpr std::size_t far_bits = 6;
+        static constexpr std::size_t near_size = std::size_t{1} << near_bits;
+        static constexpr std::size_t far_size = std::size_t{1} << far_bits;
+        static constexpr std::size_t far_levels = 3;
+
+        void schedule();
+        void advance(std::uint64_t target);
+        void step();
+        void place(entry &item);
+        void cascade(std::size_t level, std::size_t index);
+
+        static void push(entry *&head, entry &item) noexcept;
+        static void unlink(entry &item) noexcept;
+        static entry *detach(entry *&head) noexcept;
+
+        net::steady_timer timer_;
+        std::chrono::milliseconds tick_;
+        std::chrono::steady_clock::time_point origin_;
+        std::atomic<std::uint64_t> current_{0};
+        std::atomic<bool> stopped_{false};
+
+        std::mutex mutex_;
+        std::array<entry *, near_size> near_{};
+        std::array<std::array<entry *, far_size>, far_levels> far_{};
+        std::vector<std::function<void()>> fired_;
+    }; // class wheel
+}
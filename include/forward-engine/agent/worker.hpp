@@ -4,10 +4,33 @@
 #include <agent/connection.hpp>  // 你已经写好的连接池
 #include <agent/distributor.hpp> // 下一步要写的路由器
 #include <agent/session.hpp>     // 最后一步要写的会话
+#include <agent/option.hpp>
+#include <agent/environment.hpp>
+#include <agent/reservoir.hpp>
+#include <agent/wheel.hpp>
+#include <agent/admission.hpp>
+#include <agent/quota.hpp>
+#include <agent/shaper.hpp>
+#include <agent/ticket.hpp>
+#include <agent/offload.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <chrono>
+#include <csignal>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <thread>
 #include <vector>
 
+#ifdef __linux__
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <unistd.h>
+    #include <cerrno>
+#endif
+
 namespace ngx::agent
 {
 
@@ -18,15 +41,21 @@ namespace ngx::agent
     {
     public:
         // 构造函数：初始化所有线程局部资源
-        explicit worker(const unsigned short port, const std::string &cert, const std::string &key)
-            : ioc_(1),                   // 1. 初始化 IO 上下文 (hint=1 表示单线程)
+        explicit worker(const unsigned short port, const std::string &cert, const std::string &key,
+            const option &opt = option::defaults())
+            : option_(opt),
+              ioc_(1),                   // 1. 初始化 IO 上下文 (hint=1 表示单线程)
               pool_(ioc_),               // 2. 初始化连接池 (依赖 ioc)
               distributor_(pool_, ioc_), // 3. 初始化路由器 (依赖 pool 和 ioc)
-              ssl_ctx_(std::make_shared<net::ssl::context>(net::ssl::context::tlsv12)),
-              acceptor_(ioc_) // 4. 初始化接收器
+              ssl_ctx_(std::make_shared<net::ssl::context>(net::ssl::context::tls_server)),
+              acceptor_(ioc_), // 4. 初始化接收器
+              protocol_(tcp::v4()),
+              rotation_(ioc_),
+              signals_(ioc_)
         {
             try
             {
+                modernize(*ssl_ctx_);
                 ssl_ctx_->use_certificate_chain_file(cert);
                 ssl_ctx_->use_private_key_file(key, net::ssl::context::pem);
             }
@@ -35,8 +64,11 @@ namespace ngx::agent
                 ssl_ctx_.reset();
             }
 
+            environment_.config = &option_;
+
             auto endpoint = tcp::endpoint(tcp::v4(), port);
-            acceptor_.open(endpoint.protocol());
+            protocol_ = endpoint.protocol();
+            acceptor_.open(protocol_);
             acceptor_.set_option(net::socket_base::reuse_address(true));
 
             int one = 1;
@@ -46,11 +78,65 @@ namespace ngx::agent
 
             acceptor_.bind(endpoint);
             acceptor_.listen();
+            acceptor_.non_blocking(true);
         }
 
         void load_reverse_map(const std::string &file_path)
         {
             distributor_.load_reverse_map(file_path);
+            std::lock_guard lock(routes_mutex_);
+            routes_path_ = file_path;
+        }
+
+        /**
+         * @brief 从上次加载的配置文件重新加载路由表与黑名单
+         * @return 是否成功；失败时保留原路由表
+         * @details 可在运行期间从任意线程调用，不阻塞正在路由的会话，但会在调用线程上同步构造新快照；
+         * POSIX 下收到 `SIGHUP` 时在专用的重新加载线程上调用，不占用事件循环线程。
+         */
+        bool reload() noexcept
+        {
+            std::string file_path;
+            {
+                std::lock_guard lock(routes_mutex_);
+                file_path = routes_path_;
+            }
+            if (file_path.empty())
+            {
+                return false;
+            }
+
+            try
+            {
+                distributor_.load_reverse_map(file_path);
+                return true;
+            }
+            catch (const std::exception &)
+            {
+                return false;
+            }
+        }
+
+        /**
+         * @brief 使用调用方持有的全局带宽层级
+         * @param global 通常是进程入口持有的 `shaper::budget::view()`，多个 `worker` 传入同一个即共享全局限额
+         * @note 必须在 `run` 之前调用；未调用时按本 `worker` 的 `shaping.global` 自建一个只供自己使用的层级
+         */
+        void share_bandwidth(const shaper::level global) noexcept
+        {
+            environment_.bandwidth = global;
+        }
+
+        /**
+         * @brief 从配置文件加载运行参数
+         * @param file_path 配置文件路径
+         * @note 会话直接引用这份参数，必须在 `run` 之前调用
+         */
+        void load_option(const std::string &file_path)
+        {
+            boost::property_tree::ptree pt;
+            boost::property_tree::read_json(file_path, pt);
+            option_ = option::load(pt);
         }
 
         void run()
@@ -65,7 +151,78 @@ namespace ngx::agent
                 threads_count = 1;
             }
 
-            do_accept();
+            // 缓冲池依赖已加载的参数，因此推迟到 run 时创建
+            if (option_.reservoir.slots != 0 && !reservoir_)
+            {
+                reservoir_.emplace(ioc_, option_.reservoir.slots);
+                environment_.buffers = &*reservoir_;
+            }
+
+            if (!wheel_)
+            {
+                wheel_.emplace(ioc_, option_.timeout.tick);
+                wheel_->start();
+                environment_.timer = &*wheel_;
+            }
+
+            if (ssl_ctx_ && !keyring_)
+            {   // 票据密钥环依赖已加载的保留数量，连接接入前安装即可
+                keyring_.emplace(option_.tls.keys);
+                keyring_->install(*ssl_ctx_);
+                rotate();
+            }
+
+            if (ssl_ctx_ && option_.tls.threads != 0 && !offload_)
+            {
+                offload_.emplace(option_.tls.threads, option_.tls.queue);
+                environment_.handshake = &*offload_;
+            }
+
+            if (!quota_ && quota::enabled(option_.quota))
+            {
+                quota_.emplace(option_.quota);
+            }
+
+            if (!environment_.bandwidth.meter && option_.shaping.global != 0)
+            {
+                bandwidth_.emplace(option_.shaping.global, option_.shaping.burst);
+                environment_.bandwidth = bandwidth_->view();
+            }
+
+            if (!shaper_ && (shaper::enabled(option_.shaping) || environment_.bandwidth.meter))
+            {
+                shaper_.emplace(option_.shaping, environment_.bandwidth);
+                environment_.shaping = &*shaper_;
+            }
+
+            if (!admission_)
+            {
+                admission_.emplace(ioc_, option_.admission);
+                admission_->start();
+                environment_.gate = &*admission_;
+            }
+
+#ifdef SIGHUP
+            if (!hangup_)
+            {
+                hangup_ = true;
+                reloader_.emplace(1);
+                signals_.add(SIGHUP);
+                watch_hangup();
+            }
+#endif
+
+#ifdef TCP_DEFER_ACCEPT
+            if (const int defer = static_cast<int>(option_.accept.defer.count()); defer > 0)
+            {
+                setsockopt(acceptor_.native_handle(), IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer, sizeof(defer));
+            }
+#endif
+
+            for (std::size_t i = 0; i < option_.accept.concurrency; ++i)
+            {
+                do_accept();
+            }
 
             std::vector<std::jthread> threads;
             threads.reserve(threads_count > 0 ? threads_count - 1 : 0);
@@ -81,31 +238,230 @@ namespace ngx::agent
             ioc_.run();
         }
 
-    private:    
+    private:
+        /**
+         * @brief 挂起一条接入链
+         * @details 只等待监听 socket 可读，可读后由 `drain` 在一次唤醒内批量接入，
+         * 突发连接不再是每次唤醒只接入一个。
+         */
         void do_accept()
         {
-            acceptor_.async_accept(
-                [this](boost::system::error_code ec, tcp::socket socket)
+            acceptor_.async_wait(tcp::acceptor::wait_read,
+                [this](const boost::system::error_code &ec)
+                {
+                    if (ec == net::error::operation_aborted)
+                    {
+                        return;
+                    }
+                    drain();
+                });
+        }
+
+        /**
+         * @brief 批量接入积压连接
+         * @details 循环接入直到积压清空（`EAGAIN`）再回到等待；达到批量上限时让出一次事件循环后继续，
+         * 因为边沿触发下剩余的积压不会再产生新的可读事件。资源耗尽类错误稍后重试。
+         */
+        void drain()
+        {
+            for (std::size_t i = 0; i < option_.accept.batch; ++i)
+            {
+                const auto verdict = admission_ ? admission_->judge() : admission::verdict::admit;
+                if (verdict == admission::verdict::pause)
+                {   // 超过硬上限：连接留在内核积压队列里，等负载回落再接入
+                    resume(admission_->interval());
+                    return;
+                }
+
+                boost::system::error_code ec;
+                tcp::endpoint peer;
+                tcp::socket socket = accept_one(ec, peer);
+                if (!ec)
                 {
-                    if (!ec)
+                    if (!distributor_.admit(peer.address()))
+                    {   // 访问控制拒绝：不分配会话，直接复位
+                        deny(socket);
+                        continue;
+                    }
+                    if (verdict == admission::verdict::shed)
                     {
-                        // 创建会话，把“路由器”传给它
-                        std::make_shared<session<tcp::socket>>(
-                            ioc_,
-                            std::move(socket),
-                            distributor_,
-                            ssl_ctx_)
-                            ->start();
+                        admission_->refuse(socket);
+                        continue;
                     }
+                    quota::pass pass;
+                    if (quota_)
+                    {
+                        auto granted = quota_->enter(peer.address());
+                        if (!granted)
+                        {   // 超过该地址的连接速率或并发会话上限
+                            deny(socket);
+                            continue;
+                        }
+                        pass = std::move(*granted);
+                    }
+                    serve(std::move(socket), std::move(pass));
+                    continue;
+                }
+
+                if (ec == net::error::would_block || ec == net::error::try_again)
+                {
                     do_accept();
+                    return;
+                }
+
+                if (ec == net::error::connection_aborted || ec == net::error::interrupted)
+                {   // 握手完成前对端已放弃，继续接入下一个
+                    continue;
+                }
+
+                if (ec == net::error::operation_aborted || ec == net::error::bad_descriptor)
+                {   // 监听 socket 已关闭
+                    return;
+                }
+
+                // 文件描述符或内存耗尽：积压留在内核里，稍后再试
+                resume(std::chrono::milliseconds(100));
+                return;
+            }
+
+            net::post(ioc_, [this]
+            {
+                drain();
+            });
+        }
+
+        /**
+         * @brief 周期轮换会话票据密钥
+         */
+        void rotate()
+        {
+            if (option_.tls.rotate.count() <= 0)
+            {
+                return;
+            }
+
+            rotation_.expires_after(option_.tls.rotate);
+            rotation_.async_wait([this](const boost::system::error_code &ec)
+            {
+                if (ec)
+                {
+                    return;
+                }
+                keyring_->rotate();
+                rotate();
+            });
+        }
+
+        /**
+         * @brief 等待 `SIGHUP`，收到后重新加载路由表
+         * @details 重新加载要解析配置、读取 GeoIP 数据、编译出站策略并为每个分组构造 Maglev 表，
+         * 整体投递到单线程的 `reloader_` 上执行，事件循环线程只负责接收信号；连续的信号在该线程上依次处理。
+         */
+        void watch_hangup()
+        {
+            signals_.async_wait([this](const boost::system::error_code &ec, int)
+            {
+                if (ec)
+                {
+                    return;
+                }
+                net::post(*reloader_, [this]
+                {
+                    reload();
                 });
+                watch_hangup();
+            });
+        }
+
+        /**
+         * @brief 延迟一段时间后恢复接入链
+         */
+        void resume(const std::chrono::milliseconds delay)
+        {
+            auto backoff = std::make_shared<net::steady_timer>(ioc_, delay);
+            backoff->async_wait([this, backoff](const boost::system::error_code &)
+            {
+                do_accept();
+            });
+        }
+
+        /**
+         * @brief 非阻塞接入一个连接
+         * @param ec 错误码
+         * @param peer 输出对端地址
+         * @details Linux 下直接用 `accept4` 一次性设置 `SOCK_NONBLOCK | SOCK_CLOEXEC`，省去后续的 `fcntl`，
+         * 对端地址随同一次系统调用返回；其他平台走非阻塞 acceptor 的同步 `accept`。
+         */
+        tcp::socket accept_one(boost::system::error_code &ec, tcp::endpoint &peer)
+        {
+#ifdef __linux__
+            socklen_t length = static_cast<socklen_t>(peer.capacity());
+            const int fd = ::accept4(acceptor_.native_handle(), peer.data(), &length, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0)
+            {
+                ec.assign(errno, boost::system::system_category());
+                return tcp::socket(ioc_);
+            }
+            peer.resize(length);
+
+            tcp::socket socket(ioc_);
+            socket.assign(protocol_, fd, ec);
+            if (ec)
+            {
+                ::close(fd);
+            }
+            return socket;
+#else
+            return acceptor_.accept(ioc_, peer, ec);
+#endif
+        }
+
+        /**
+         * @brief 关闭被访问控制或配额拒绝的连接
+         * @details 置零 `SO_LINGER` 后关闭，内核直接发送 RST，不进入 `TIME_WAIT`，扫描流量不占用本端资源。
+         */
+        static void deny(tcp::socket &socket)
+        {
+            boost::system::error_code ec;
+            socket.set_option(net::socket_base::linger(true, 0), ec);
+            socket.close(ec);
+        }
+
+        void serve(tcp::socket socket, quota::pass pass)
+        {
+            // 创建会话，把“路由器”传给它
+            std::make_shared<session<tcp::socket>>(
+                ioc_,
+                std::move(socket),
+                distributor_,
+                ssl_ctx_,
+                environment_,
+                std::move(pass))
+                ->start();
         }
 
+        option option_;           // 运行参数
         net::io_context ioc_;
         source pool_;             // 资源仓库
         distributor distributor_; // 业务大脑
         std::shared_ptr<net::ssl::context> ssl_ctx_;
         tcp::acceptor acceptor_;
+        tcp protocol_;                       // 监听协议，接入的 socket 沿用，避免每次接入都 getsockname
+        std::optional<reservoir> reservoir_; // 隧道缓冲池（按需创建）
+        std::optional<wheel> wheel_;         // 会话超时时间轮
+        std::optional<admission> admission_; // 准入控制
+        std::optional<quota> quota_;         // 按客户端地址的配额（按需创建）
+        std::optional<shaper::budget> bandwidth_; // 未共享时自建的全局带宽层级（按需创建）
+        std::optional<shaper> shaper_;       // 隧道带宽整形（按需创建）
+        std::optional<keyring> keyring_;     // 会话票据密钥环
+        net::steady_timer rotation_;         // 票据密钥轮换定时器
+        net::signal_set signals_;            // 触发重新加载的信号
+        bool hangup_ = false;                // 是否已注册 `SIGHUP`
+        std::mutex routes_mutex_;
+        std::string routes_path_;            // 路由表配置文件，供重新加载使用
+        std::optional<net::thread_pool> reloader_; // 重新加载线程（注册 `SIGHUP` 时创建），先于其引用的成员析构
+        std::optional<offload> offload_;     // TLS 握手线程池（按需创建）
+        environment environment_;            // 会话共享环境
     };
 
 }
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <boost/asio.hpp>
+#include "option.hpp"
+
+namespace ngx::agent
+{
+    namespace net = boost::asio;
+    using tcp = boost::asio::ip::tcp;
+
+    /**
+     * @brief 零拷贝发送器
+     * @details 基于 Linux `SO_ZEROCOPY`/`MSG_ZEROCOPY` 的发送路径。内核直接引用用户态页面发送，
+     * 因此发送块在内核通过错误队列（`MSG_ERRQUEUE`）通知释放之前不能被复用。
+     * 发送器自己持有一组发送块，调用方按 `acquire` -> 读入数据 -> `async_send` 的顺序轮转使用。
+     * @note 不满足阈值、内核回报已退化为拷贝、或平台不支持时，自动走普通 `net::async_write`。
+     * 内核的通知序号按 socket 累计，所以同一个 socket 在生命周期内只能绑定一个发送器。
+     * 关闭 socket 前须 `co_await drain()`；未收回全部发送块就析构时，发送器会以 RST 中止连接。
+     */
+    class zerocopy
+    {
+        struct block
+        {
+            std::unique_ptr<std::byte[]> data;
+            std::size_t remaining = 0; // 尚未被内核释放的发送次数
+        }; // struct block
+
+        struct inflight
+        {
+            std::uint32_t sequence = 0;
+            std::size_t index = 0;
+        }; // struct inflight
+
+    public:
+        zerocopy(tcp::socket &socket, const option::zerocopy_option &opt);
+        ~zerocopy();
+
+        zerocopy(const zerocopy &) = delete;
+        zerocopy &operator=(const zerocopy &) = delete;
+
+        [[nodiscard]] static bool supported() noexcept;
+        [[nodiscard]] bool active() const noexcept;
+
+        [[nodiscard]] net::awaitable<net::mutable_buffer> acquire(boost::system::error_code &ec);
+        net::awaitable<void> async_send(std::size_t n, boost::system::error_code &ec);
+        net::awaitable<void> drain();
+
+    private:
+        bool reap();
+        void reset() noexcept;
+        void release(std::uint32_t low, std::uint32_t high);
+
+        tcp::socket &socket_;
+        net::steady_timer timer_; // `drain` 的等待上限
+        std::size_t threshold_;
+        std::size_t block_size_;
+        std::vector<block> blocks_;
+        std::vector<inflight> inflight_;
+        std::size_t cursor_ = 0;
+        std::uint32_t sequence_ = 0;
+        bool active_ = false;
+    }; // class zerocopy
+}
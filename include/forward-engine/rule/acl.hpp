@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "matcher.hpp"
+
+namespace ngx::rule
+{
+    /**
+     * @brief 客户端地址访问控制表
+     * @details 规则按顺序给出，第一条命中的生效，没有规则命中时取默认动作：
+     * `allow 10.0.0.0/8`、`deny 192.0.2.7`、`deny 1.0.0.0-1.0.0.255`、`deny all`。
+     * `compile` 把全部网段合并为一张有序、互不相交的区间表（IPv4 映射进 IPv6 空间），
+     * 每段记下覆盖它的第一条规则，判定为一次二分查找，不分配内存。
+     */
+    class acl
+    {
+    public:
+        void compile(const std::vector<std::string> &rules, bool allow = true);
+        [[nodiscard]] bool permit(const net::ip::address &address) const noexcept;
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return networks_.empty();
+        }
+
+    private:
+        interval_map<address_key> networks_; // 值为规则序号
+        std::vector<bool> allows_;           // 按规则序号
+        bool fallback_ = true;               // 默认动作
+    }; // class acl
+}
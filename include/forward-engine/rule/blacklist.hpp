@@ -1,16 +1,36 @@
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <unordered_set>
 #include <vector>
+#include "matcher.hpp"
+#include "blocklist.hpp"
 
 
 namespace ngx::limit
 {
 
+    /**
+     * @brief 黑名单
+     * @details 域名存放在 `rule::suffix_table` 中，查询时在原主机名上折叠大小写、逐个标签边界探测，不分配内存；
+     * 端点集合支持以 `std::string_view` 异构查找。
+     * 大型列表可以预编译为文件后用 `attach` 挂上映射（见 `rule::blocklist`），与配置中的条目同时生效。
+     */
     class  blacklist
     {
+        struct transparent_hash
+        {
+            using is_transparent = void;
+
+            std::size_t operator()(const std::string_view value) const noexcept
+            {
+                return std::hash<std::string_view>{}(value);
+            }
+        }; // struct transparent_hash
+
     public:
         // 默认构造
         blacklist() = default;
@@ -26,14 +46,20 @@ namespace ngx::limit
         // 例如：黑名单有 "baidu.com"，那么 "map.baidu.com" 也会被屏蔽
         bool domain(std::string_view host_value) const;
 
+        // 4. 检查解析后的地址 (只查挂载的预编译列表中的网段)
+        bool address(const boost::asio::ip::address &address_value) const;
+
+        void attach(std::shared_ptr<const rule::blocklist> mapped);
+
         void insert_domain(std::string_view domain);
 
-        void insert_endpoint(std::string& endpoint_value);
+        void insert_endpoint(std::string_view endpoint_value);
         void clear();
 
     private:
-        std::unordered_set<std::string> ips_;
-        std::unordered_set<std::string> domains_;
+        std::unordered_set<std::string, transparent_hash, std::equal_to<>> ips_;
+        rule::suffix_table domains_;
+        std::shared_ptr<const rule::blocklist> mapped_;
     };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "matcher.hpp"
+
+namespace ngx::rule
+{
+    /**
+     * @brief 预编译拦截列表文件头
+     * @details 文件由离线工具一次生成，按本机字节序存放，各段以相对文件起点的偏移定位，8 字节对齐：
+     * `[文件头][槽位数组][名字池][布隆过滤器][地址分段起点][地址分段值]`。
+     * 槽位与名字池即 `suffix_view` 的内存布局，地址分段即 `interval_map<address_key>` 编译后的结果，映射后直接查询。
+     */
+    struct blocklist_header
+    {
+        char magic[8];               // "FEBLOCK\0"
+        std::uint32_t version;       // 格式版本
+        std::uint32_t order;         // 0x01020304，用于识别字节序
+        std::uint64_t size;          // 文件总长度，用于发现截断
+        std::uint64_t domains;       // 域名数
+        std::uint64_t capacity;      // 槽位数，2 的幂
+        std::uint64_t slots;         // 槽位数组偏移
+        std::uint64_t names;         // 名字池偏移
+        std::uint64_t names_size;    // 名字池长度
+        std::uint64_t bloom;         // 布隆过滤器偏移，0 表示没有
+        std::uint64_t bloom_words;   // 布隆过滤器字数，2 的幂
+        std::uint64_t ranges;        // 地址分段数
+        std::uint64_t starts;        // 地址分段起点偏移
+        std::uint64_t values;        // 地址分段值偏移
+    }; // struct blocklist_header
+
+    /**
+     * @brief 内存映射的预编译拦截列表
+     * @details `open` 只映射文件并校验文件头，耗时与列表大小无关；页面由操作系统按需换入，多个进程映射同一文件时共享物理页。
+     * 文件映射后只读，重新加载时映射新文件即可，旧映射随最后一个持有者释放。
+     */
+    class blocklist
+    {
+    public:
+        [[nodiscard]] static std::shared_ptr<const blocklist> open(const std::string &path);
+        static void compile(const std::vector<std::string> &domains, const std::vector<std::string> &networks,
+            const std::string &path, bool bloom = true);
+
+        [[nodiscard]] bool domain(std::string_view host) const noexcept;
+        [[nodiscard]] bool address(const net::ip::address &address) const noexcept;
+
+        [[nodiscard]] std::size_t domains() const noexcept
+        {
+            return view_.size();
+        }
+
+        [[nodiscard]] std::size_t ranges() const noexcept
+        {
+            return ranges_;
+        }
+
+    private:
+        blocklist() = default;
+
+        boost::interprocess::file_mapping file_;
+        boost::interprocess::mapped_region region_;
+        suffix_view view_;
+        const address_key *starts_ = nullptr;
+        const std::uint32_t *values_ = nullptr;
+        std::size_t ranges_ = 0;
+    }; // class blocklist
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <boost/asio/ip/address.hpp>
+
+namespace ngx::rule
+{
+    namespace net = boost::asio;
+
+    /**
+     * @brief 未命中
+     */
+    inline constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+    /**
+     * @brief 域名后缀表的槽位
+     * @details 布局固定（24 字节、无填充），预编译的拦截列表文件按原样存放槽位数组。
+     */
+    struct suffix_slot
+    {
+        std::uint64_t hash = 0;
+        std::uint32_t offset = 0; // 域名在名字池中的偏移
+        std::uint32_t length = 0; // 0 表示空槽
+        std::uint32_t exact = npos;
+        std::uint32_t suffix = npos;
+    }; // struct suffix_slot
+
+    static_assert(sizeof(suffix_slot) == 24);
+
+    /**
+     * @brief 域名后缀表的只读视图
+     * @details 开放寻址的哈希表，键为小写域名，所有域名首尾相接存放在一块连续内存（名字池）里，槽位只记偏移与长度。
+     * 哈希按字符从后往前累积，查找时从主机名末尾扫描一遍，每到一个标签边界就得到一个后缀的哈希并探测一次，
+     * 大小写在扫描时折叠（校验时按 16 字节一组比较），全程不复制主机名、不分配内存。
+     * 每个域名带两个值：`exact` 只匹配域名本身，`suffix` 还匹配它的所有子域名；查找返回命中的最小值。
+     *
+     * 视图不持有内存，槽位与名字池既可以来自 `suffix_table`，也可以直接指向映射进来的文件；
+     * 可选的布隆过滤器放在探测之前，未命中的后缀多数不必访问槽位数组。
+     * 映射进来的文件只在打开时校验头部与各段边界，探测时再逐个校验槽位：越出名字池的槽位视为不匹配，
+     * 探测至多走满一圈，没有空槽的槽位数组也不会使查找陷入死循环。
+     */
+    class suffix_view
+    {
+        friend class suffix_table;
+
+    public:
+        suffix_view() = default;
+
+        suffix_view(const suffix_slot *slots, const std::size_t capacity, const char *names, const std::size_t names_size,
+            const std::size_t count, const std::uint64_t *bloom = nullptr, const std::size_t bloom_words = 0) noexcept
+            : slots_(slots), capacity_(capacity), names_(names), names_size_(names_size), count_(count), bloom_(bloom),
+              bloom_words_(bloom_words)
+        {
+        }
+
+        [[nodiscard]] std::uint32_t find(std::string_view host) const noexcept;
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return count_;
+        }
+
+        [[nodiscard]] static std::uint64_t hash(std::string_view domain) noexcept;
+        static void mark(std::uint64_t *bloom, std::size_t words, std::uint64_t hash) noexcept;
+
+    private:
+        [[nodiscard]] std::size_t probe(std::uint64_t hash, std::string_view host, std::size_t from) const noexcept;
+        [[nodiscard]] bool maybe(std::uint64_t hash) const noexcept;
+
+        const suffix_slot *slots_ = nullptr; // 容量为 2 的幂
+        std::size_t capacity_ = 0;
+        const char *names_ = nullptr;
+        std::size_t names_size_ = 0;
+        std::size_t count_ = 0;
+        const std::uint64_t *bloom_ = nullptr; // 字数为 2 的幂，空表示不过滤
+        std::size_t bloom_words_ = 0;
+    }; // class suffix_view
+
+    /**
+     * @brief 域名后缀表
+     * @details 持有槽位与名字池的可增长版本，查找委托给 `suffix_view`。
+     */
+    class suffix_table
+    {
+    public:
+        bool insert(std::string_view domain, std::uint32_t value, bool subdomains);
+        void reserve(std::size_t count, std::size_t bytes = 0);
+        void clear() noexcept;
+
+        [[nodiscard]] std::uint32_t find(const std::string_view host) const noexcept
+        {
+            return view().find(host);
+        }
+
+        [[nodiscard]] suffix_view view() const noexcept
+        {
+            return {slots_.data(), slots_.size(), names_.data(), names_.size(), count_};
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept
+        {
+            return count_;
+        }
+
+        [[nodiscard]] const std::vector<suffix_slot> &slots() const noexcept
+        {
+            return slots_;
+        }
+
+        [[nodiscard]] std::string_view names() const noexcept
+        {
+            return names_;
+        }
+
+    private:
+        void rehash(std::size_t capacity);
+
+        std::vector<suffix_slot> slots_;
+        std::string names_;
+        std::size_t count_ = 0;
+    }; // class suffix_table
+
+    /**
+     * @brief 关键字自动机（Aho-Corasick）
+     * @details `compile` 把关键字前缀树展开为稠密的状态转移表：字节先按关键字中出现过的字符归类（其余字符归为一类，
+     * 大写字母与小写同类），转移表大小为状态数乘类别数；每个状态预先合并失败链上的输出，
+     * 扫描时每个字节一次查表，不回溯。
+     */
+    class keyword_automaton
+    {
+    public:
+        void insert(std::string_view keyword, std::uint32_t value);
+        void compile();
+        [[nodiscard]] std::uint32_t find(std::string_view text) const noexcept;
+        void clear() noexcept;
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return output_.empty();
+        }
+
+    private:
+        std::vector<std::string> keywords_;     // 编译前收集
+        std::vector<std::uint32_t> values_;
+        std::array<std::uint8_t, 256> classes_{};
+        std::size_t width_ = 1;                 // 类别数
+        std::vector<std::uint32_t> transition_; // 状态 * 类别
+        std::vector<std::uint32_t> output_;     // 每个状态命中的最小值
+    }; // class keyword_automaton
+
+    /**
+     * @brief 128 位地址键，IPv4 映射到 `::ffff:0:0/96`
+     */
+    struct address_key
+    {
+        std::uint64_t high = 0;
+        std::uint64_t low = 0;
+
+        friend auto operator<=>(const address_key &, const address_key &) = default;
+
+        [[nodiscard]] static address_key from(const net::ip::address &address) noexcept;
+    }; // struct address_key
+
+    bool parse_network(std::string_view text, address_key &first, address_key &last);
+
+    /**
+     * @brief 区间表
+     * @tparam Key 整数或 `address_key`
+     * @details `compile` 把可能重叠的区间扫描合并为有序、互不相交的分段，每段取覆盖它的区间中的最小值，
+     * 查找为一次二分；分段起点与值分两个数组存放。
+     */
+    template <typename Key>
+    class interval_map
+    {
+    public:
+        void insert(const Key first, const Key last, const std::uint32_t value)
+        {
+            if (!(last < first))
+            {
+                pending_.push_back({first, last, value});
+            }
+        }
+
+        void compile()
+        {
+            struct event
+            {
+                Key at;
+                bool open;
+                std::uint32_t value;
+            };
+
+            std::vector<event> events;
+            events.reserve(pending_.size() * 2);
+            for (const auto &item : pending_)
+            {
+                events.push_back({item.first, true, item.value});
+                if (Key after = item.last; advance(after))
+                {
+                    events.push_back({after, false, item.value});
+                }
+            }
+            std::ranges::sort(events, [](const event &left, const event &right)
+            {
+                return left.at < right.at;
+            });
+
+            starts_.clear();
+            values_.clear();
+            std::multiset<std::uint32_t> active;
+            for (std::size_t i = 0; i < events.size();)
+            {
+                const auto at = events[i].at;
+                for (; i < events.size() && events[i].at == at; ++i)
+                {
+                    if (events[i].open)
+                    {
+                        active.insert(events[i].value);
+                    }
+                    else
+                    {
+                        active.erase(active.find(events[i].value));
+                    }
+                }
+                const auto value = active.empty() ? npos : *active.begin();
+                if (values_.empty() ? value != npos : values_.back() != value)
+                {
+                    starts_.push_back(at);
+                    values_.push_back(value);
+                }
+            }
+            pending_.clear();
+            pending_.shrink_to_fit();
+        }
+
+        [[nodiscard]] std::uint32_t find(const Key key) const noexcept
+        {
+            const auto it = std::upper_bound(starts_.begin(), starts_.end(), key);
+            if (it == starts_.begin())
+            {
+                return npos;
+            }
+            return values_[static_cast<std::size_t>(it - starts_.begin()) - 1];
+        }
+
+        void clear() noexcept
+        {
+            pending_.clear();
+            starts_.clear();
+            values_.clear();
+        }
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return starts_.empty();
+        }
+
+        [[nodiscard]] const std::vector<Key> &starts() const noexcept
+        {
+            return starts_;
+        }
+
+        [[nodiscard]] const std::vector<std::uint32_t> &values() const noexcept
+        {
+            return values_;
+        }
+
+    private:
+        struct range
+        {
+            Key first;
+            Key last;
+            std::uint32_t value;
+        }; // struct range
+
+        /**
+         * @brief 取后继，已是最大值时返回 `false`
+         */
+        static bool advance(Key &key) noexcept
+        {
+            if constexpr (std::is_integral_v<Key>)
+            {
+                if (key == std::numeric_limits<Key>::max())
+                {
+                    return false;
+                }
+                ++key;
+                return true;
+            }
+            else
+            {
+                if (++key.low == 0 && ++key.high == 0)
+                {
+                    return false;
+                }
+                return true;
+            }
+        }
+
+        std::vector<range> pending_; // 编译前收集
+        std::vector<Key> starts_;
+        std::vector<std::uint32_t> values_;
+    }; // class interval_map
+}
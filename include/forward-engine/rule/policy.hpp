@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "matcher.hpp"
+
+namespace ngx::rule
+{
+    /**
+     * @brief 出站动作
+     */
+    enum class action : std::uint8_t
+    {
+        direct, // 直连
+        reject, // 拒绝
+        parent  // 经上级代理
+    }; // enum class action
+
+    /**
+     * @brief 正向代理出站策略
+     * @details 规则按 Clash 的写法逐行给出，`类型,内容,目标`，按顺序第一条命中的规则生效：
+     * - `DOMAIN,example.com,DIRECT`：主机名完全相同；
+     * - `DOMAIN-SUFFIX,example.com,REJECT`：主机名为该域名或其子域名；
+     * - `DOMAIN-KEYWORD,ads,REJECT`：主机名包含该关键字；
+     * - `IP-CIDR,10.0.0.0/8,DIRECT`（`IP-CIDR6` 同义）、`IP-RANGE,1.0.0.0-1.0.0.255,DIRECT`：目标地址在网段内；
+     * - `GEOIP,CN,DIRECT`：目标地址属于该地区，地址段来自 `compile` 时给出的 CSV 文件（`起始地址,结束地址,地区`）；
+     * - `DST-PORT,25,REJECT`（或 `8000-9000`）：目标端口；
+     * - `MATCH,DIRECT`：兜底。
+     *
+     * 目标为 `DIRECT`、`REJECT` 或上级代理名。`compile` 把同类规则合并为一个匹配器，规则序号即优先级：
+     * 域名进后缀哈希表，关键字进一个 Aho-Corasick 自动机，地址与端口各进一张有序区间表，
+     * 判定时每类各查一次，取序号最小者；没有规则命中时直连。
+     */
+    class policy
+    {
+    public:
+        /**
+         * @brief 判定结果
+         */
+        struct verdict
+        {
+            action kind = action::direct;
+            std::uint32_t parent = 0;   // `kind` 为 `parent` 时的上级代理序号
+            std::uint32_t rule = npos;  // 命中的规则序号，`npos` 表示没有规则命中
+            bool resolve = false;       // 须先解析目标地址再调用带地址的 `decide`
+        }; // struct verdict
+
+        void compile(const std::vector<std::string> &rules, const std::vector<std::string> &parents, const std::string &geoip = {});
+
+        [[nodiscard]] verdict decide(std::string_view host, std::uint16_t port) const noexcept;
+        [[nodiscard]] verdict decide(std::string_view host, std::uint16_t port, const net::ip::address &address) const noexcept;
+
+        [[nodiscard]] bool empty() const noexcept
+        {
+            return targets_.empty();
+        }
+
+    private:
+        /**
+         * @brief 规则的目标
+         */
+        struct target
+        {
+            action kind = action::direct;
+            std::uint32_t parent = 0;
+        }; // struct target
+
+        [[nodiscard]] std::uint32_t prematch(std::string_view host, std::uint16_t port) const noexcept;
+        [[nodiscard]] verdict conclude(std::uint32_t rule) const noexcept;
+
+        suffix_table domains_;
+        keyword_automaton keywords_;
+        interval_map<std::uint16_t> ports_;
+        interval_map<address_key> addresses_;
+        std::uint32_t fallback_ = npos;      // `MATCH` 规则的序号
+        std::uint32_t first_address_ = npos; // 第一条地址类规则的序号
+        std::vector<target> targets_;        // 按规则序号
+    }; // class policy
+}
@@ -0,0 +1,109 @@
+#include <rule/blocklist.hpp>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rule = ngx::rule;
+
+namespace
+{
+    /**
+     * @brief 逐行读取列表文件
+     * @details 忽略空行与 `#` 注释；hosts 文件格式（`0.0.0.0 example.com`）取第二列，其余取第一列。
+     */
+    bool read_list(const std::string &path, std::vector<std::string> &items)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (const auto hash = line.find('#'); hash != std::string::npos)
+            {
+                line.erase(hash);
+            }
+            std::istringstream fields(line);
+            std::string first, second;
+            fields >> first >> second;
+            if (first.empty())
+            {
+                continue;
+            }
+            if (!second.empty() && (first == "0.0.0.0" || first == "127.0.0.1" || first == "::" || first == "::1"))
+            {
+                items.push_back(std::move(second));
+            }
+            else
+            {
+                items.push_back(std::move(first));
+            }
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief 拦截列表离线编译工具
+ * @details 用法：`Forward_blocklist <输出文件> <域名列表> [地址列表] [--no-bloom]`，
+ * 生成的文件在配置中以 `agent.blacklist.file` 引用，代理启动或重新加载时直接映射。
+ */
+int main(int argc, char *argv[])
+{
+    std::vector<std::string_view> arguments;
+    bool bloom = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string_view(argv[i]) == "--no-bloom")
+        {
+            bloom = false;
+        }
+        else
+        {
+            arguments.emplace_back(argv[i]);
+        }
+    }
+    if (arguments.size() < 2 || arguments.size() > 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <output> <domains.txt> [networks.txt] [--no-bloom]" << std::endl;
+        return 2;
+    }
+
+    std::vector<std::string> domains;
+    std::vector<std::string> networks;
+    if (!read_list(std::string(arguments[1]), domains))
+    {
+        std::cerr << "cannot read " << arguments[1] << std::endl;
+        return 1;
+    }
+    if (arguments.size() == 3 && !read_list(std::string(arguments[2]), networks))
+    {
+        std::cerr << "cannot read " << arguments[2] << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        const auto begin = std::chrono::steady_clock::now();
+        const std::string output(arguments[0]);
+        rule::blocklist::compile(domains, networks, output, bloom);
+        const auto list = rule::blocklist::open(output);
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        std::cout << output << ": " << list->domains() << " domains, " << list->ranges() << " address ranges, "
+                  << elapsed << " ms" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include <agent/admission.hpp>
+#include <algorithm>
+#include <array>
+#include <string_view>
+#include <utility>
+
+namespace ngx::agent
+{
+    admission::ticket::ticket(admission *owner, const std::size_t bytes) noexcept
+        : owner_(owner), bytes_(bytes)
+    {
+    }
+
+    admission::ticket::ticket(ticket &&other) noexcept
+        : owner_(std::exchange(other.owner_, nullptr)), bytes_(std::exchange(other.bytes_, 0))
+    {
+    }
+
+    admission::ticket &admission::ticket::operator=(ticket &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            owner_ = std::exchange(other.owner_, nullptr);
+            bytes_ = std::exchange(other.bytes_, 0);
+        }
+        return *this;
+    }
+
+    admission::ticket::~ticket()
+    {
+        reset();
+    }
+
+    void admission::ticket::charge(const std::size_t bytes) noexcept
+    {
+        if (owner_)
+        {
+            owner_->memory_.fetch_add(bytes, std::memory_order_relaxed);
+            bytes_ += bytes;
+        }
+    }
+
+    void admission::ticket::refund(std::size_t bytes) noexcept
+    {
+        if (owner_)
+        {
+            bytes = std::min(bytes, bytes_);
+            owner_->memory_.fetch_sub(bytes, std::memory_order_relaxed);
+            bytes_ -= bytes;
+        }
+    }
+
+    void admission::ticket::reset() noexcept
+    {
+        if (owner_)
+        {
+            owner_->sessions_.fetch_sub(1, std::memory_order_relaxed);
+            owner_->memory_.fetch_sub(bytes_, std::memory_order_relaxed);
+            owner_ = nullptr;
+            bytes_ = 0;
+        }
+    }
+
+    /**
+     * @brief 构造准入控制
+     * @param ioc 用于测量事件循环延迟的 `io_context`（应与会话所在的相同）
+     * @param opt 准入参数（由 `worker` 持有）
+     */
+    admission::admission(net::io_context &ioc, const option::admission_option &opt)
+        : option_(opt), timer_(ioc)
+    {
+    }
+
+    /**
+     * @brief 启动延迟采样
+     */
+    void admission::start()
+    {
+        expected_ = std::chrono::steady_clock::now() + option_.interval;
+        timer_.expires_at(expected_);
+        timer_.async_wait([this](const boost::system::error_code &ec)
+        {
+            if (ec)
+            {
+                return;
+            }
+            sample();
+        });
+    }
+
+    void admission::stop()
+    {
+        timer_.cancel();
+    }
+
+    /**
+     * @brief 采样一次事件循环延迟
+     * @details 延迟 = 实际唤醒时间 - 预定唤醒时间，按 1/8 权重并入滑动平均，单次毛刺不会触发拒绝。
+     */
+    void admission::sample()
+    {
+        const auto late = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - expected_);
+        const std::int64_t current = std::max<std::int64_t>(late.count(), 0);
+        const std::int64_t previous = lag_.load(std::memory_order_relaxed);
+        lag_.store(previous + (current - previous) / 8, std::memory_order_relaxed);
+        start();
+    }
+
+    /**
+     * @brief 判断当前负载下是否放行新连接
+     * @return 任一维度超过硬上限返回 `pause`，超过软上限返回 `shed`，否则 `admit`
+     */
+    admission::verdict admission::judge() const noexcept
+    {
+        const auto over = [](const auto value, const auto limit)
+        {
+            return limit != decltype(limit){} && value >= limit;
+        };
+
+        const std::size_t live = sessions();
+        const std::size_t bytes = memory();
+        const auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(lag());
+
+        if (over(live, option_.hard_sessions) || over(bytes, option_.hard_memory) || over(delay, option_.hard_lag))
+        {
+            return verdict::pause;
+        }
+        if (over(live, option_.soft_sessions) || over(bytes, option_.soft_memory) || over(delay, option_.soft_lag))
+        {
+            return verdict::shed;
+        }
+        return verdict::admit;
+    }
+
+    /**
+     * @brief 放行一个会话
+     * @param bytes 会话初始占用的缓冲内存
+     */
+    admission::ticket admission::admit(const std::size_t bytes) noexcept
+    {
+        sessions_.fetch_add(1, std::memory_order_relaxed);
+        memory_.fetch_add(bytes, std::memory_order_relaxed);
+        return ticket(this, bytes);
+    }
+
+    void admission::refuse(tcp::socket &socket) const noexcept
+    {
+        boost::system::error_code ec;
+        if (option_.shed == option::admission_option::shed_mode::reset)
+        {
+            socket.set_option(net::socket_base::linger(true, 0), ec);
+        }
+        else
+        {
+            // 请求尚未读取，直接回复；发不出去（对端窗口为 0 等）就算了，不做等待
+            static constexpr std::string_view response =
+                "HTTP/1.1 503 Service Unavailable\r\n"
+                "Content-Length: 0\r\n"
+                "Retry-After: 1\r\n"
+                "Connection: close\r\n\r\n";
+            socket.non_blocking(true, ec);
+            // 先读掉已到达的请求，否则关闭时内核会因接收缓冲区有残留而发送 RST，客户端可能收不到响应
+            std::array<char, 4096> sink{};
+            socket.receive(net::buffer(sink), 0, ec);
+            socket.send(net::buffer(response), 0, ec);
+            socket.shutdown(tcp::socket::shutdown_send, ec);
+        }
+        socket.close(ec);
+    }
+}
@@ -145,6 +145,20 @@ namespace ngx::agent
 
     void analysis::parse(const std::string_view src, memory::string &host, memory::string &port)
     {
+        // IPv6 字面量 `[::1]:8080`：端口分隔符在方括号之后，主机不含方括号
+        if (src.starts_with('['))
+        {
+            const auto close = src.find(']');
+            if (close != std::string_view::npos)
+            {
+                host.assign(src.substr(1, close - 1).begin(), src.substr(1, close - 1).end());
+                if (src.substr(close + 1).starts_with(':') && src.size() > close + 2)
+                {
+                    port.assign(src.substr(close + 2).begin(), src.substr(close + 2).end());
+                }
+                return;
+            }
+        }
         if (const auto pos = src.find(':'); pos != std::string_view::npos)
         {
             host.assign(src.substr(0, pos).begin(), src.substr(0, pos).end());
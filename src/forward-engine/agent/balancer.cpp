@@ -0,0 +1,311 @@
+#include <agent/balancer.hpp>
+#include <abnormal.hpp>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        /**
+         * @brief FNV-1a 64 位哈希
+         */
+        [[nodiscard]] std::uint64_t fnv1a(const std::string_view data, std::uint64_t seed = 14695981039346656037ull) noexcept
+        {
+            for (const auto c : data)
+            {
+                seed ^= static_cast<unsigned char>(c);
+                seed *= 1099511628211ull;
+            }
+            return seed;
+        }
+
+        /**
+         * @brief 线程私有的随机数发生器
+         */
+        [[nodiscard]] std::minstd_rand &generator() noexcept
+        {
+            thread_local std::minstd_rand engine{std::random_device{}()};
+            return engine;
+        }
+
+        /**
+         * @brief 在途连接数 / 权重，用交叉相乘比较避免除法
+         */
+        [[nodiscard]] bool lighter(const backend &left, const backend &right) noexcept
+        {
+            const std::uint64_t l = left.state->outstanding.load(std::memory_order_relaxed);
+            const std::uint64_t r = right.state->outstanding.load(std::memory_order_relaxed);
+            return l * right.weight < r * left.weight;
+        }
+
+        /**
+         * @brief 平滑加权轮询
+         * @details 按 nginx 的平滑加权算法预先生成一整轮的调度序列（长度为约分后的权重和），
+         * 运行时只需原子自增一个游标；序列中同一后端的出现位置是分散的，不会连续命中。
+         */
+        class smooth_round_robin final : public balancer
+        {
+        public:
+            explicit smooth_round_robin(std::vector<backend> backends)
+                : balancer(std::move(backends))
+            {
+                std::uint32_t divisor = 0;
+                for (const auto &item : backends_)
+                {
+                    divisor = std::gcd(divisor, item.weight);
+                }
+
+                std::vector<std::int64_t> current(backends_.size(), 0);
+                std::int64_t total = 0;
+                for (const auto &item : backends_)
+                {
+                    total += item.weight / divisor;
+                }
+
+                schedule_.reserve(static_cast<std::size_t>(total));
+                for (std::int64_t round = 0; round < total; ++round)
+                {
+                    std::size_t best = 0;
+                    for (std::size_t i = 0; i < backends_.size(); ++i)
+                    {
+                        current[i] += backends_[i].weight / divisor;
+                        if (current[i] > current[best])
+                        {
+                            best = i;
+                        }
+                    }
+                    current[best] -= total;
+                    schedule_.push_back(static_cast<std::uint32_t>(best));
+                }
+            }
+
+            [[nodiscard]] const backend &select(const affinity &) noexcept override
+            {
+                const auto n = cursor_.fetch_add(1, std::memory_order_relaxed);
+                return fallback(backends_[schedule_[n % schedule_.size()]]);
+            }
+
+        private:
+            std::vector<std::uint32_t> schedule_;
+            std::atomic<std::size_t> cursor_{0};
+        }; // class smooth_round_robin
+
+        /**
+         * @brief 最少在途连接
+         */
+        class least_outstanding final : public balancer
+        {
+        public:
+            explicit least_outstanding(std::vector<backend> backends)
+                : balancer(std::move(backends))
+            {
+            }
+
+            [[nodiscard]] const backend &select(const affinity &) noexcept override
+            {
+                // 从随机位置开始扫描，负载相同的后端之间不会总偏向第一个
+                const auto start = generator()() % backends_.size();
+                const backend *best = &backends_[start];
+                for (std::size_t i = 1; i < backends_.size(); ++i)
+                {
+                    const auto &item = backends_[(start + i) % backends_.size()];
+                    // 可用的优先，同为可用（或同为不可用）时比较负载
+                    if (item.usable() != best->usable() ? item.usable() : lighter(item, *best))
+                    {
+                        best = &item;
+                    }
+                }
+                return *best;
+            }
+        }; // class least_outstanding
+
+        /**
+         * @brief 两次随机选择
+         */
+        class power_of_two final : public balancer
+        {
+        public:
+            explicit power_of_two(std::vector<backend> backends)
+                : balancer(std::move(backends))
+            {
+            }
+
+            [[nodiscard]] const backend &select(const affinity &) noexcept override
+            {
+                const auto size = backends_.size();
+                if (size == 1)
+                {
+                    return backends_.front();
+                }
+
+                auto &engine = generator();
+                const auto first = engine() % size;
+                // 第二个从其余后端中取，保证两者不同
+                const auto second = (first + 1 + engine() % (size - 1)) % size;
+                const auto &left = backends_[first];
+                const auto &right = backends_[second];
+                if (left.usable() != right.usable())
+                {
+                    return left.usable() ? left : right;
+                }
+                return fallback(lighter(right, left) ? right : left);
+            }
+        }; // class power_of_two
+
+        /**
+         * @brief Maglev 一致性哈希
+         * @details 每个后端按自身地址生成 (offset, skip) 排列，各后端按权重比例轮流认领查找表中的空位，
+         * 直到填满。查找为一次哈希加一次取模。
+         */
+        class maglev_hash final : public balancer
+        {
+        public:
+            /**
+             * @brief 查找表大小，须为质数
+             */
+            static constexpr std::size_t table_size = 65537;
+
+            /**
+             * @brief 命中不可用后端时沿查找表顺延的最大步数，超过后退回到按顺序找第一个可用后端
+             */
+            static constexpr std::size_t probe_limit = 64;
+
+            maglev_hash(std::vector<backend> backends, const hash_key key)
+                : balancer(std::move(backends)), key_(key), table_(table_size)
+            {
+                const auto count = backends_.size();
+                std::vector<std::uint64_t> offset(count), skip(count), next(count, 0), credit(count, 0);
+                std::uint32_t heaviest = 0;
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    const auto name = backends_[i].endpoint.address().to_string() + ':' + std::to_string(backends_[i].endpoint.port());
+                    offset[i] = fnv1a(name) % table_size;
+                    skip[i] = fnv1a(name, 0x9e3779b97f4a7c15ull) % (table_size - 1) + 1;
+                    heaviest = std::max(heaviest, backends_[i].weight);
+                }
+
+                std::vector<bool> taken(table_size, false);
+                std::size_t filled = 0;
+                while (filled < table_size)
+                {
+                    for (std::size_t i = 0; i < count && filled < table_size; ++i)
+                    {
+                        // 权重最大的后端每轮认领一个位置，其余按比例累积
+                        credit[i] += backends_[i].weight;
+                        if (credit[i] < heaviest)
+                        {
+                            continue;
+                        }
+                        credit[i] -= heaviest;
+
+                        std::size_t slot = 0;
+                        do
+                        {
+                            slot = (offset[i] + next[i] * skip[i]) % table_size;
+                            ++next[i];
+                        } while (taken[slot]);
+
+                        taken[slot] = true;
+                        table_[slot] = static_cast<std::uint32_t>(i);
+                        ++filled;
+                    }
+                }
+            }
+
+            [[nodiscard]] const backend &select(const affinity &hint) noexcept override
+            {
+                std::uint64_t hash = 0;
+                if (key_ == hash_key::path)
+                {
+                    hash = fnv1a(hint.path);
+                }
+                else if (hint.client.is_v4())
+                {
+                    const auto bytes = hint.client.to_v4().to_bytes();
+                    hash = fnv1a(std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size()));
+                }
+                else
+                {
+                    const auto bytes = hint.client.to_v6().to_bytes();
+                    hash = fnv1a(std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size()));
+                }
+                // 命中的后端不可用时沿查找表顺延，同一个键仍然稳定地落到同一个替代后端
+                const auto slot = hash % table_size;
+                for (std::size_t i = 0; i < probe_limit; ++i)
+                {
+                    const auto &item = backends_[table_[(slot + i) % table_size]];
+                    if (item.usable())
+                    {
+                        return item;
+                    }
+                }
+                return fallback(backends_[table_[slot]]);
+            }
+
+        private:
+            hash_key key_;
+            std::vector<std::uint32_t> table_;
+        }; // class maglev_hash
+    }
+
+    balancer::balancer(std::vector<backend> backends)
+        : backends_(std::move(backends))
+    {
+    }
+
+    /**
+     * @brief 选中的后端不可用时改选第一个可用后端
+     * @return 全部不可用时返回原选择
+     * @note 只在有后端被驱逐时才会扫描，正常路径是一次原子读
+     */
+    const backend &balancer::fallback(const backend &chosen) const noexcept
+    {
+        if (chosen.usable())
+        {
+            return chosen;
+        }
+        for (const auto &item : backends_)
+        {
+            if (item.usable())
+            {
+                return item;
+            }
+        }
+        return chosen;
+    }
+
+    /**
+     * @brief 创建均衡器
+     * @param kind 均衡策略
+     * @param backends 后端列表，不能为空；权重限制在 [1, 256]，保证轮询序列与查找表的构建开销有界
+     * @param key 一致性哈希的键，只对 `maglev` 有效
+     * @throws abnormal::protocol_error 后端列表为空时抛出
+     */
+    std::unique_ptr<balancer> balancer::make(const strategy kind, std::vector<backend> backends, const hash_key key)
+    {
+        if (backends.empty())
+        {
+            throw abnormal::protocol_error("负载均衡分组没有后端");
+        }
+        for (auto &item : backends)
+        {
+            item.weight = std::clamp<std::uint32_t>(item.weight, 1, 256);
+        }
+
+        switch (kind)
+        {
+        case strategy::least:
+            return std::make_unique<least_outstanding>(std::move(backends));
+        case strategy::p2c:
+            return std::make_unique<power_of_two>(std::move(backends));
+        case strategy::maglev:
+            return std::make_unique<maglev_hash>(std::move(backends), key);
+        case strategy::swrr:
+        default:
+            return std::make_unique<smooth_round_robin>(std::move(backends));
+        }
+    }
+}
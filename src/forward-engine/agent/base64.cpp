@@ -0,0 +1,100 @@
+#include <agent/base64.hpp>
+#include <cstdint>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+        /**
+         * @brief 字符在字母表中的值，不在字母表中时为 -1
+         */
+        [[nodiscard]] int value(const char c) noexcept
+        {
+            if (c >= 'A' && c <= 'Z')
+            {
+                return c - 'A';
+            }
+            if (c >= 'a' && c <= 'z')
+            {
+                return c - 'a' + 26;
+            }
+            if (c >= '0' && c <= '9')
+            {
+                return c - '0' + 52;
+            }
+            if (c == '+')
+            {
+                return 62;
+            }
+            return c == '/' ? 63 : -1;
+        }
+    }
+
+    /**
+     * @brief 编码
+     */
+    std::string base64::encode(const std::string_view data)
+    {
+        const auto byte = [data](const std::size_t i) -> std::uint32_t
+        {
+            return i < data.size() ? static_cast<unsigned char>(data[i]) : 0;
+        };
+
+        std::string text;
+        text.reserve((data.size() + 2) / 3 * 4);
+        for (std::size_t i = 0; i < data.size(); i += 3)
+        {
+            const std::uint32_t group = byte(i) << 16 | byte(i + 1) << 8 | byte(i + 2);
+            const std::size_t rest = data.size() - i;
+            text.push_back(alphabet[group >> 18 & 0x3F]);
+            text.push_back(alphabet[group >> 12 & 0x3F]);
+            text.push_back(rest > 1 ? alphabet[group >> 6 & 0x3F] : '=');
+            text.push_back(rest > 2 ? alphabet[group & 0x3F] : '=');
+        }
+        return text;
+    }
+
+    /**
+     * @brief 解码
+     * @return 长度不是 4 的倍数、含非法字符或填充位置不对时返回 `false`
+     */
+    bool base64::decode(const std::string_view text, std::string &data)
+    {
+        if (text.size() % 4 != 0)
+        {
+            return false;
+        }
+
+        data.clear();
+        data.reserve(text.size() / 4 * 3);
+        for (std::size_t i = 0; i < text.size(); i += 4)
+        {
+            const bool last = i + 4 == text.size();
+            const std::size_t padding = last ? (text[i + 3] == '=') + (text[i + 2] == '=' && text[i + 3] == '=') : 0;
+
+            std::uint32_t group = 0;
+            for (std::size_t j = 0; j < 4; ++j)
+            {
+                const int v = j >= 4 - padding ? 0 : value(text[i + j]);
+                if (v < 0)
+                {
+                    return false;
+                }
+                group = group << 6 | static_cast<std::uint32_t>(v);
+            }
+
+            data.push_back(static_cast<char>(group >> 16 & 0xFF));
+            if (padding < 2)
+            {
+                data.push_back(static_cast<char>(group >> 8 & 0xFF));
+            }
+            if (padding < 1)
+            {
+                data.push_back(static_cast<char>(group & 0xFF));
+            }
+        }
+        return true;
+    }
+}
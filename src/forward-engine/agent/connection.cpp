@@ -7,6 +7,11 @@ namespace ngx::agent
 
     void deleter::operator()(tcp::socket *ptr) const
     {
+        if (outstanding)
+        {
+            outstanding->fetch_sub(1, std::memory_order_relaxed);
+        }
+
         if (pool)
         {
             if (has_endpoint)
@@ -1,22 +1,150 @@
 #include <agent/distributor.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/property_tree/ptree.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <stdexcept>
+#include <vector>
 #include <abnormal.hpp>
 
 namespace ngx::agent
 {
+   namespace
+   {
+      /**
+       * @brief 解析均衡策略名，未知名称按 `swrr` 处理
+       */
+      balancer::strategy parse_strategy(const std::string &name)
+      {
+         if (name == "least")
+         {
+            return balancer::strategy::least;
+         }
+         if (name == "p2c")
+         {
+            return balancer::strategy::p2c;
+         }
+         if (name == "maglev")
+         {
+            return balancer::strategy::maglev;
+         }
+         return balancer::strategy::swrr;
+      }
+
+      /**
+       * @brief 解析一个后端节点 `{"host": "10.0.0.1", "port": 8080, "weight": 2}`
+       * @return 地址无效时为 `false`
+       */
+      bool parse_backend(const boost::property_tree::ptree &node, backend &result)
+      {
+         const auto host = node.get<std::string>("host", "");
+         const auto port = node.get<unsigned short>("port", 0);
+         if (host.empty() || port == 0)
+         {
+            return false;
+         }
+
+         boost::system::error_code ec;
+         const auto address = net::ip::make_address(host, ec);
+         if (ec)
+         {
+            return false;
+         }
+
+         result.endpoint = tcp::endpoint(address, port);
+         result.weight = node.get<std::uint32_t>("weight", 1);
+         return true;
+      }
+
+      /**
+       * @brief 解析分组的 `health` 与 `eject` 节点，缺失的字段保持默认值
+       */
+      health_option parse_health(const boost::property_tree::ptree &node)
+      {
+         health_option result;
+         if (const auto probe = node.get_child_optional("health"))
+         {
+            const auto type = probe->get<std::string>("type", "tcp");
+            result.type = type == "http" ? health_option::probe_type::http
+                        : type == "none" ? health_option::probe_type::none
+                                         : health_option::probe_type::tcp;
+            result.path = probe->get<std::string>("path", result.path);
+            result.interval = std::chrono::seconds(std::max<std::int64_t>(probe->get<std::int64_t>("interval", result.interval.count()), 1));
+            result.timeout = std::chrono::seconds(std::max<std::int64_t>(probe->get<std::int64_t>("timeout", result.timeout.count()), 1));
+            result.rise = std::max<std::uint32_t>(probe->get<std::uint32_t>("rise", result.rise), 1);
+            result.fall = std::max<std::uint32_t>(probe->get<std::uint32_t>("fall", result.fall), 1);
+         }
+         result.failures = node.get<std::uint32_t>("eject.failures", result.failures);
+         result.ejection = std::chrono::seconds(node.get<std::int64_t>("eject.duration", result.ejection.count()));
+         return result;
+      }
+   }
+
    distributor::distributor(source &pool, net::io_context &ioc, std::pmr::memory_resource *mr)
-       : pool_(pool), resolver_(ioc), mr_(mr ? mr : std::pmr::new_delete_resource()), reverse_map_(mr_)
+       : pool_(pool), resolver_(ioc), mr_(mr ? mr : std::pmr::new_delete_resource()),
+         routing_(std::make_shared<const routing>(mr_)), health_(ioc)
    {
    }
 
+   /**
+    * @brief 加载反向代理表与黑名单并发布为新的路由快照
+    * @param file_path 配置文件路径
+    * @details 同一主机下地址相同的后端沿用旧快照里的运行时状态（在途计数、健康与驱逐），重新加载不会让被驱逐的后端立即复活。
+    * @throws 配置文件读取或解析失败时抛出，原快照保持不变
+    */
    void distributor::load_reverse_map(const std::string &file_path)
    {
       boost::property_tree::ptree pt;
       boost::property_tree::read_json(file_path, pt);
 
-      reverse_map_.clear();
+      std::lock_guard lock(reload_mutex_);
+      const auto previous = routing_.acquire();
+      auto next = std::make_shared<routing>(mr_);
+
+      // 沿用旧快照中同一路由键、同一地址后端的状态
+      const auto inherit = [&previous](const std::string &key, std::vector<backend> &backends)
+      {
+         const auto it = previous->names.find(std::string_view(key));
+         if (it == previous->names.end())
+         {
+            return;
+         }
+         for (auto &item : backends)
+         {
+            for (const auto &old : previous->upstreams[it->second].balance->backends())
+            {
+               if (old.endpoint == item.endpoint)
+               {
+                  item.state = old.state;
+                  break;
+               }
+            }
+         }
+      };
+
+      // 路由键为 `主机[/路径前缀]`，主机可以是 `*.example.com` 或 `*`；同一个键重复出现时以后者为准
+      const auto install = [this, &next](const std::string &key, upstream entry)
+      {
+         const auto slash = key.find('/');
+         const auto host = std::string_view(key).substr(0, slash);
+         const auto prefix = slash == std::string::npos ? std::string_view{} : std::string_view(key).substr(slash);
+         const auto found = next->names.find(std::string_view(key));
+         const auto index = found != next->names.end() ? found->second : static_cast<std::uint32_t>(next->upstreams.size());
+         if (!next->table.insert(host, prefix, index))
+         {
+            return;
+         }
+         if (found != next->names.end())
+         {
+            next->upstreams[index] = std::move(entry);
+            return;
+         }
+         next->upstreams.push_back(std::move(entry));
+         memory::string name(mr_);
+         name.assign(key);
+         next->names.emplace(std::move(name), index);
+      };
 
       const auto addressable_host = pt.get<std::string>("agent.addressable.host", "");
       const auto addressable_port = pt.get<unsigned short>("agent.addressable.port", 0);
@@ -33,36 +161,129 @@ namespace ngx::agent
                incoming_host = "localhost";
             }
 
-            memory::string host_key(mr_);
-            host_key.assign(incoming_host);
-            reverse_map_.emplace(std::move(host_key), tcp::endpoint(address, addressable_port));
+            std::vector<backend> single(1);
+            single.front().endpoint = tcp::endpoint(address, addressable_port);
+            inherit(incoming_host, single);
+            install(incoming_host, upstream{balancer::make(balancer::strategy::swrr, std::move(single)), {}});
          }
       }
 
       if (const auto reverse_map_node = pt.get_child_optional("agent.reverse_map"))
       {
-         for (const auto &[incoming_host, backend_node] : *reverse_map_node)
+         for (const auto &[incoming_host, group_node] : *reverse_map_node)
          {
-            const auto backend_host = backend_node.get<std::string>("host", "");
-            const auto backend_port = backend_node.get<unsigned short>("port", 0);
-
-            if (incoming_host.empty() || backend_host.empty() || backend_port == 0)
+            if (incoming_host.empty())
             {
                continue;
             }
 
-            boost::system::error_code ec;
-            const auto address = net::ip::make_address(backend_host, ec);
-            if (ec)
+            // 两种写法：单个后端 `{"host", "port"}`，或分组 `{"balance", "hash", "backends": [...]}`
+            std::vector<backend> backends;
+            if (const auto list = group_node.get_child_optional("backends"))
+            {
+               for (const auto &[index, item] : *list)
+               {
+                  if (backend entry; parse_backend(item, entry))
+                  {
+                     backends.push_back(std::move(entry));
+                  }
+               }
+            }
+            else if (backend entry; parse_backend(group_node, entry))
+            {
+               backends.push_back(std::move(entry));
+            }
+
+            if (backends.empty())
             {
                continue;
             }
 
-            memory::string host_key(mr_);
-            host_key.assign(incoming_host);
-            reverse_map_.insert_or_assign(std::move(host_key), tcp::endpoint(address, backend_port));
+            const auto kind = parse_strategy(group_node.get<std::string>("balance", "swrr"));
+            const auto key = group_node.get<std::string>("hash", "client") == "path"
+                                ? balancer::hash_key::path
+                                : balancer::hash_key::client;
+
+            inherit(incoming_host, backends);
+            install(incoming_host, upstream{balancer::make(kind, std::move(backends), key), parse_health(group_node)});
+         }
+      }
+
+      // 黑名单：`{"agent": {"blacklist": {"endpoints": [...], "domains": [...]}}}`
+      std::vector<std::string> endpoints;
+      std::vector<std::string> domains;
+      if (const auto list = pt.get_child_optional("agent.blacklist.endpoints"))
+      {
+         for (const auto &[index, item] : *list)
+         {
+            endpoints.push_back(item.get_value<std::string>());
+         }
+      }
+      if (const auto list = pt.get_child_optional("agent.blacklist.domains"))
+      {
+         for (const auto &[index, item] : *list)
+         {
+            domains.push_back(item.get_value<std::string>());
          }
       }
+      next->blacklist.load(endpoints, domains);
+      // 预编译的大型列表：`{"agent": {"blacklist": {"file": "blocklist.bin"}}}`，只做映射
+      if (const auto file = pt.get<std::string>("agent.blacklist.file", ""); !file.empty())
+      {
+         next->blacklist.attach(rule::blocklist::open(file));
+      }
+
+      // 出站策略：`{"agent": {"policy": {"rules": [...], "parents": {"name": {"host", "port"}}, "geoip": "geoip.csv"}}}`
+      if (const auto policy_node = pt.get_child_optional("agent.policy"))
+      {
+         std::vector<std::string> names;
+         if (const auto list = policy_node->get_child_optional("parents"))
+         {
+            for (const auto &[name, item] : *list)
+            {
+               names.push_back(name);
+               next->parents.push_back(parent_proxy{item.get<std::string>("host"), item.get<std::string>("port")});
+            }
+         }
+         std::vector<std::string> rules;
+         if (const auto list = policy_node->get_child_optional("rules"))
+         {
+            for (const auto &[index, item] : *list)
+            {
+               rules.push_back(item.get_value<std::string>());
+            }
+         }
+         next->policy.compile(rules, names, policy_node->get<std::string>("geoip", ""));
+      }
+
+      // 客户端访问控制：`{"agent": {"acl": {"default": "allow", "rules": ["deny 10.0.0.0/8", ...]}}}`
+      if (const auto acl_node = pt.get_child_optional("agent.acl"))
+      {
+         std::vector<std::string> rules;
+         if (const auto list = acl_node->get_child_optional("rules"))
+         {
+            for (const auto &[index, item] : *list)
+            {
+               rules.push_back(item.get_value<std::string>());
+            }
+         }
+         const auto fallback = acl_node->get<std::string>("default", "allow");
+         if (fallback != "allow" && fallback != "deny")
+         {
+            throw abnormal::protocol_error("Invalid ACL default: {}", fallback);
+         }
+         next->clients.compile(rules, fallback == "allow");
+      }
+
+      std::vector<std::pair<std::shared_ptr<const balancer>, health_option>> watched;
+      watched.reserve(next->upstreams.size());
+      for (const auto &entry : next->upstreams)
+      {
+         watched.emplace_back(entry.balance, entry.check);
+      }
+
+      routing_.publish(std::move(next));
+      health_.assign(std::move(watched));
    }
 
    /**
@@ -70,32 +291,129 @@ namespace ngx::agent
     * @param host 目标主机名
    * @param port 目标端口号
    * @return 一个指向内部连接对象的智能指针
+   * @details 先查黑名单，再按出站策略决定直连、拒绝或经上级代理；直连时解析出的地址再查一次黑名单网段；
+   * 策略中排在前面的是地址类规则时，先解析目标地址再判定。
    */
    net::awaitable<internal_ptr> distributor::route_forward(const std::string_view host, const std::string_view port)
    {
-      // 1. 查 DNS
-      if (blacklist_.domain(host))
+      const auto &current = routing_.load();
+      if (current.blacklist.domain(host))
       {
          throw abnormal::network_error(std::format("Domain blacklisted: {}, port: {}",host,port));
       }
+
+      // 1. 不看地址能确定的规则
+      std::uint16_t number = 0;
+      std::from_chars(port.data(), port.data() + port.size(), number);
+      auto verdict = current.policy.decide(host, number);
+      if (!verdict.resolve && verdict.kind == rule::action::reject)
+      {
+         throw abnormal::security("Policy rejected: {}:{}", host, port);
+      }
+      if (!verdict.resolve && verdict.kind == rule::action::parent)
+      {
+         co_return co_await route_parent(current.parents[verdict.parent], host, port);
+      }
+
+      // 2. 查 DNS；需要按地址判定时固定住当前快照，挂起后仍用同一套规则
+      const auto pinned = verdict.resolve ? routing_.acquire() : nullptr;
       const auto results = co_await resolver_.async_resolve(host, port, net::use_awaitable);
-      // 2. 找池子要连接
+      if (pinned)
+      {
+         verdict = pinned->policy.decide(host, number, results.begin()->endpoint().address());
+         if (verdict.kind == rule::action::reject)
+         {
+            throw abnormal::security("Policy rejected: {}:{}", host, port);
+         }
+         if (verdict.kind == rule::action::parent)
+         {
+            co_return co_await route_parent(pinned->parents[verdict.parent], host, port);
+         }
+      }
+
+      // 3. 预编译列表中的网段要等拿到地址才能查
+      if (routing_.load().blacklist.address(results.begin()->endpoint().address()))
+      {
+         throw abnormal::network_error(std::format("Address blacklisted: {}, port: {}", host, port));
+      }
+
+      // 4. 找池子要连接
       co_return co_await pool_.acquire_tcp(*results.begin());
    }
 
+   /**
+    * @brief 经上级代理建立到目标的隧道
+    * @param parent 上级代理（按值传入，不引用快照）
+    * @param host 目标主机名
+    * @param port 目标端口号
+    * @return 隧道连接；它绑定了目标，不放回连接池
+    * @throws 连接失败或上级代理未返回 2xx 时抛出
+    */
+   net::awaitable<internal_ptr> distributor::route_parent(const parent_proxy parent, const std::string_view host, const std::string_view port)
+   {
+      const auto endpoints = co_await resolver_.async_resolve(parent.host, parent.port, net::use_awaitable);
+      internal_ptr socket(new tcp::socket(resolver_.get_executor()), deleter{});
+      co_await net::async_connect(*socket, endpoints, net::use_awaitable);
+      socket->set_option(tcp::no_delay(true));
+
+      const auto authority = host.find(':') == std::string_view::npos ? std::format("{}:{}", host, port)
+                                                                       : std::format("[{}]:{}", host, port);
+      const auto request = std::format("CONNECT {0} HTTP/1.1\r\nHost: {0}\r\n\r\n", authority);
+      co_await net::async_write(*socket, net::buffer(request), net::use_awaitable);
+
+      // 客户端发出数据前，上级代理不会在响应头之后再发送内容
+      std::string response;
+      const auto length = co_await net::async_read_until(*socket, net::dynamic_buffer(response, 8192), "\r\n\r\n", net::use_awaitable);
+      const std::string_view status(response.data(), std::min(response.find("\r\n"), length));
+      if (!status.starts_with("HTTP/1.") || status.size() < 12 || status[9] != '2' || response.size() != length)
+      {
+         throw abnormal::network_error("Parent proxy {}:{} refused CONNECT {}: {}", parent.host, parent.port, authority, status);
+      }
+      co_return socket;
+   }
+
    /**
     * @brief 给 HTTP 反向代理用 (查静态表)
-   * @param host 目标主机名
+   * @param host 目标主机名，可以带端口，忽略大小写
+   * @param hint 请求的亲和键，一致性哈希分组按它选择后端；其中的路径同时用于前缀路由
    * @return 一个指向内部连接对象的智能指针
+   * @details 选中的后端在途计数立即加一，连接释放时由 `deleter` 减一；连接结果上报给 `health` 用于被动驱逐。
    */
-   net::awaitable<internal_ptr> distributor::route_reverse(const std::string_view host)
+   net::awaitable<internal_ptr> distributor::route_reverse(const std::string_view host, const affinity hint)
    {
-      // 1. 查配置表 (比如 configuration.json 加载进来的 map)
-      if (auto it = reverse_map_.find(host); it != reverse_map_.end())
+      // 1. 查路由表：主机（精确、通配）加最长路径前缀
+      const auto &current = routing_.load();
+      const auto index = current.table.find(host, hint.path);
+      if (index == router::npos)
+      {
+         throw abnormal::network_error("Unknown host: {}", std::string_view(host));
+      }
+
+      // 2. 分组内选后端（跳过被驱逐或探测不健康的）
+      // 快照引用不能跨越挂起点，挂起前把后面要用的复制出来
+      const auto &entry = current.upstreams[index];
+      const auto &chosen = entry.balance->select(hint);
+      const auto endpoint = chosen.endpoint;
+      const auto threshold = entry.check.failures;
+      const auto ejection = entry.check.ejection;
+      std::shared_ptr<backend_state> state = chosen.state;
+      state->outstanding.fetch_add(1, std::memory_order_relaxed);
+
+      internal_ptr socket;
+      try
+      {
+         socket = co_await pool_.acquire_tcp(endpoint);
+      }
+      catch (...)
       {
-         co_return co_await pool_.acquire_tcp(it->second);
+         state->outstanding.fetch_sub(1, std::memory_order_relaxed);
+         health::failed(*state, threshold, ejection);
+         throw;
       }
-      throw abnormal::network_error("Unknown host: {}", std::string_view(host));
+      health::succeeded(*state);
+      auto *counter = &state->outstanding;
+      socket.get_deleter().outstanding = std::shared_ptr<std::atomic<std::uint32_t>>(std::move(state), counter);
+      co_return socket;
    }
 
    /**
@@ -32,19 +32,12 @@ namespace ngx::agent
      */
     std::string serialize(const frame &frame_instance)
     {
-        std::string buffer;
-        // 预留内存: 4 字节 ID + 1 字节 type+ 数据长度
-        buffer.reserve(sizeof(uint32_t) + sizeof(uint8_t) + frame_instance.data().size());
-
-        uint32_t net_id = boost::endian::native_to_big(frame_instance.stream_id());
-        char id_bytes[sizeof(uint32_t)];
-        std::memcpy(id_bytes, &net_id, sizeof(uint32_t));
-        buffer.append(id_bytes, sizeof(uint32_t));
-
-        buffer.push_back(static_cast<char>(frame_instance.type()));
+        const auto header = encode(frame_instance.type(), frame_instance.stream_id());
 
+        std::string buffer;
+        buffer.reserve(header.size() + frame_instance.data().size());
+        buffer.append(header.data(), header.size());
         buffer.append(frame_instance.data());
-
         return buffer;
     }
 
@@ -53,28 +46,54 @@ namespace ngx::agent
      * @param string_value 待反序列化的字符串
      * @param frame_instance 反序列化后的帧
      * @return 是否成功反序列化
+     * @note 负载会被复制进帧；转发路径上应使用不复制的 `decode`
      */
     bool deserialize(std::string_view string_value, frame &frame_instance)
     {
-        // 检查最小长度: 4 字节 ID + 1 字节 type = 5 字节
-        if (string_value.size() < 5)
+        frame_view view;
+        if (!decode(string_value, view))
         {
             return false;
         }
 
-        uint32_t net_id;
-        std::memcpy(&net_id, string_value.data(), sizeof(uint32_t));
-        uint32_t id = boost::endian::big_to_native(net_id);
-
-        auto raw_type = static_cast<uint8_t>(string_value[4]);
-        const auto type = static_cast<enum frame::type>(raw_type);
+        frame_instance = frame(view.type, view.stream_id, view.data);
+        return true;
+    }
 
-        std::string_view payload(string_value.data() + 5, string_value.size() - 5);
+    /**
+     * @brief 编码帧头
+     * @param type 帧类型
+     * @param stream_id 流 ID
+     * @return 5 字节帧头
+     * @details 与负载分开编码，发送时和负载一起做聚集写入（gather write），负载无需拼接复制。
+     */
+    frame_header encode(const enum frame::type type, const std::uint32_t stream_id) noexcept
+    {
+        frame_header header{};
+        const std::uint32_t net_id = boost::endian::native_to_big(stream_id);
+        std::memcpy(header.data(), &net_id, sizeof(net_id));
+        header[4] = static_cast<char>(type);
+        return header;
+    }
 
-        // 构造新帧并赋值给实例
-        // 这要求 frame 是可复制赋值或可移动赋值（默认生成的是足够的）
-        frame_instance = frame(type, id, payload);
+    /**
+     * @brief 解析帧但不复制负载
+     * @param string_value 待解析的字节（通常是 websocket 读缓冲区）
+     * @param view 解析结果，负载指向 `string_value`
+     * @return 是否成功解析（最小长度: 4 字节 ID + 1 字节 type）
+     */
+    bool decode(const std::string_view string_value, frame_view &view) noexcept
+    {
+        if (string_value.size() < std::tuple_size_v<frame_header>)
+        {
+            return false;
+        }
 
+        std::uint32_t net_id;
+        std::memcpy(&net_id, string_value.data(), sizeof(net_id));
+        view.stream_id = boost::endian::big_to_native(net_id);
+        view.type = static_cast<enum frame::type>(static_cast<std::uint8_t>(string_value[4]));
+        view.data = string_value.substr(std::tuple_size_v<frame_header>);
         return true;
     }
 }
@@ -0,0 +1,261 @@
+#include <agent/health.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <charconv>
+#include <format>
+#include <string_view>
+#include <utility>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        /**
+         * @brief 巡检周期：驱逐到期检查的粒度，也是主动探测周期的最小粒度
+         */
+        constexpr auto patrol_period = std::chrono::seconds(1);
+
+        [[nodiscard]] std::int64_t steady_now() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        /**
+         * @brief 从状态行 `HTTP/1.1 200 OK` 中取状态码
+         * @return 格式错误时为 0
+         */
+        [[nodiscard]] int status_code(const std::string_view line) noexcept
+        {
+            if (!line.starts_with("HTTP/"))
+            {
+                return 0;
+            }
+            const auto space = line.find(' ');
+            if (space == std::string_view::npos || line.size() < space + 4)
+            {
+                return 0;
+            }
+            int code = 0;
+            const auto begin = line.data() + space + 1;
+            const auto [end, ec] = std::from_chars(begin, begin + 3, code);
+            return ec == std::errc{} && end == begin + 3 ? code : 0;
+        }
+    }
+
+    /**
+     * @brief 构造健康管理
+     * @param ioc 探测与巡检协程所在的 `io_context`
+     */
+    health::health(net::io_context &ioc)
+        : strand_(net::make_strand(ioc)), timer_(strand_)
+    {
+    }
+
+    /**
+     * @brief 替换受管的分组，首次调用时启动巡检协程
+     * @param groups 分组及其健康检查参数
+     * @note 可在任意线程调用，替换在 strand 上生效；被替换掉的分组上仍在进行的探测结束后不再有影响。
+     */
+    void health::assign(std::vector<std::pair<std::shared_ptr<const balancer>, health_option>> groups)
+    {
+        net::post(strand_, [this, groups = std::move(groups)]() mutable
+        {
+            groups_.clear();
+            groups_.reserve(groups.size());
+            for (auto &[balance, option] : groups)
+            {
+                groups_.push_back(group{std::move(balance), std::move(option)});
+            }
+
+            if (!started_ && !stopped_)
+            {
+                started_ = true;
+                net::co_spawn(strand_, patrol(), net::detached);
+            }
+        });
+    }
+
+    /**
+     * @brief 停止巡检
+     */
+    void health::stop()
+    {
+        net::post(strand_, [this]
+        {
+            stopped_ = true;
+            timer_.cancel();
+        });
+    }
+
+    /**
+     * @brief 被动上报：一次连接失败
+     * @param state 后端状态
+     * @param threshold 所属分组的连续失败阈值（`health_option::failures`），0 表示不驱逐
+     * @param ejection 所属分组的驱逐时长
+     * @details 连续失败达到阈值时驱逐；已被驱逐的不会因为后续失败延长驱逐时间。
+     */
+    void health::failed(backend_state &state, const std::uint32_t threshold, const std::chrono::seconds ejection) noexcept
+    {
+        if (threshold == 0)
+        {
+            return;
+        }
+
+        if (state.failures.fetch_add(1, std::memory_order_relaxed) + 1 < threshold)
+        {
+            return;
+        }
+
+        std::int64_t expected = 0;
+        const auto until = steady_now() + std::chrono::duration_cast<std::chrono::nanoseconds>(ejection).count();
+        if (state.ejected_until.compare_exchange_strong(expected, until, std::memory_order_relaxed))
+        {
+            refresh(state);
+        }
+    }
+
+    /**
+     * @brief 被动上报：一次连接成功，清零连续失败计数
+     */
+    void health::succeeded(backend_state &state) noexcept
+    {
+        auto &failures = state.failures;
+        if (failures.load(std::memory_order_relaxed) != 0)
+        {
+            failures.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 巡检协程：恢复驱逐到期的后端，并按各分组的周期发起主动探测
+     */
+    net::awaitable<void> health::patrol()
+    {
+        boost::system::error_code ec;
+        while (!stopped_)
+        {
+            timer_.expires_after(patrol_period);
+            co_await timer_.async_wait(net::redirect_error(net::use_awaitable, ec));
+            if (stopped_)
+            {
+                co_return;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            const auto now_ns = steady_now();
+            for (auto &item : groups_)
+            {
+                for (const auto &target : item.balance->backends())
+                {
+                    auto &state = *target.state;
+                    const auto until = state.ejected_until.load(std::memory_order_relaxed);
+                    if (until != 0 && now_ns >= until)
+                    {
+                        state.failures.store(0, std::memory_order_relaxed);
+                        state.ejected_until.store(0, std::memory_order_relaxed);
+                        refresh(state);
+                    }
+                }
+
+                if (item.option.type == health_option::probe_type::none || now < item.due)
+                {
+                    continue;
+                }
+                item.due = now + item.option.interval;
+                for (const auto &target : item.balance->backends())
+                {
+                    net::co_spawn(strand_, probe(target, item.option), net::detached);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 探测一个后端并更新其主动健康状态
+     * @param target 后端（按值持有，分组被替换后仍然有效）
+     * @param opt 所属分组的参数
+     * @details 连续 `fall` 次失败判定不健康；不健康时连续 `rise` 次成功恢复，并同时解除被动驱逐。
+     */
+    net::awaitable<void> health::probe(backend target, health_option opt)
+    {
+        const bool ok = co_await attempt(target.endpoint, opt);
+
+        auto &state = *target.state;
+        const bool sick = state.sick.load(std::memory_order_relaxed);
+        if (ok != sick)
+        {   // 结果与当前判定一致
+            state.streak = 0;
+            co_return;
+        }
+
+        if (++state.streak < (sick ? opt.rise : opt.fall))
+        {
+            co_return;
+        }
+
+        state.streak = 0;
+        state.sick.store(!sick, std::memory_order_relaxed);
+        if (sick)
+        {
+            state.failures.store(0, std::memory_order_relaxed);
+            state.ejected_until.store(0, std::memory_order_relaxed);
+        }
+        refresh(state);
+    }
+
+    /**
+     * @brief 执行一次探测
+     * @return 是否健康；超时、连接失败或状态码不是 2xx/3xx 均为不健康
+     */
+    net::awaitable<bool> health::attempt(const tcp::endpoint &endpoint, const health_option &opt)
+    {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        const auto executor = co_await net::this_coro::executor;
+        tcp::socket socket(executor);
+        net::steady_timer deadline(executor, opt.timeout);
+
+        const auto exchange = [&]() -> net::awaitable<bool>
+        {
+            co_await socket.async_connect(endpoint, net::use_awaitable);
+            if (opt.type != health_option::probe_type::http)
+            {
+                co_return true;
+            }
+
+            const auto request = std::format("GET {} HTTP/1.1\r\nHost: {}\r\nConnection: close\r\n\r\n",
+                opt.path, endpoint.address().to_string());
+            co_await net::async_write(socket, net::buffer(request), net::use_awaitable);
+
+            std::string line;
+            co_await net::async_read_until(socket, net::dynamic_buffer(line, 1024), "\r\n", net::use_awaitable);
+            const auto code = status_code(line);
+            co_return code >= 200 && code < 400;
+        };
+
+        bool healthy = false;
+        try
+        {
+            const auto result = co_await (exchange() || deadline.async_wait(net::use_awaitable));
+            healthy = result.index() == 0 && std::get<0>(result);
+        }
+        catch (const std::exception &)
+        {
+            // 连接被拒绝、对端重置等
+        }
+
+        boost::system::error_code ec;
+        socket.close(ec);
+        co_return healthy;
+    }
+
+    /**
+     * @brief 根据主动与被动状态重新计算是否参与选择
+     */
+    void health::refresh(backend_state &state) noexcept
+    {
+        const bool up = !state.sick.load(std::memory_order_relaxed)
+            && state.ejected_until.load(std::memory_order_relaxed) == 0;
+        state.up.store(up, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,321 @@
+#include <agent/ingress.hpp>
+#include <agent/analysis.hpp>
+#include <abnormal.hpp>
+#include <http/deserialization.hpp>
+#include <http/serialization.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <memory_resource>
+#include <string_view>
+#include <thread>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        constexpr std::uint8_t socks_version = 0x05;
+
+        /**
+         * @brief SOCKS5 应答码
+         */
+        enum class socks_reply : std::uint8_t
+        {
+            succeeded = 0x00,
+            failure = 0x01,
+            command = 0x07,  // 不支持的命令
+            address = 0x08   // 不支持的地址类型
+        };
+
+        constexpr std::string_view established_response = "HTTP/1.1 200 Connection Established\r\n\r\n";
+        constexpr std::string_view unavailable_response =
+            "HTTP/1.1 502 Bad Gateway\r\n"
+            "Content-Length: 0\r\n"
+            "Connection: close\r\n\r\n";
+
+        /**
+         * @brief 发送 SOCKS5 应答
+         * @details 远端不确认建立结果，绑定地址一律填 0.0.0.0:0。
+         */
+        net::awaitable<void> answer(tcp::socket &socket, const socks_reply code)
+        {
+            const std::array<std::uint8_t, 10> reply{socks_version, static_cast<std::uint8_t>(code), 0x00, 0x01};
+            boost::system::error_code ec;
+            co_await net::async_write(socket, net::buffer(reply), net::redirect_error(net::use_awaitable, ec));
+        }
+    }
+
+    /**
+     * @brief 构造本地接入
+     * @param opt 运行参数，也可以在 `run` 之前通过 `load_option` 加载
+     */
+    ingress::ingress(const option &opt)
+        : option_(opt), ioc_(1), acceptor_(ioc_), pool_(ioc_, option_)
+    {
+    }
+
+    /**
+     * @brief 从配置文件加载运行参数
+     * @note 多路复用会话直接引用这份参数，必须在 `run` 之前调用
+     */
+    void ingress::load_option(const std::string &file_path)
+    {
+        boost::property_tree::ptree pt;
+        boost::property_tree::read_json(file_path, pt);
+        option_ = option::load(pt);
+    }
+
+    void ingress::run()
+    {
+        run(1);
+    }
+
+    void ingress::run(std::size_t threads_count)
+    {
+        if (threads_count == 0)
+        {
+            threads_count = 1;
+        }
+
+        prepare();
+
+        pool_.start();
+        net::co_spawn(ioc_, accept(), net::detached);
+
+        std::vector<std::jthread> threads;
+        threads.reserve(threads_count - 1);
+        for (std::size_t i = 1; i < threads_count; ++i)
+        {
+            threads.emplace_back([this]
+            {
+                ioc_.run();
+            });
+        }
+
+        ioc_.run();
+    }
+
+    void ingress::stop()
+    {
+        pool_.stop();
+        ioc_.stop();
+    }
+
+    std::size_t ingress::established()
+    {
+        return pool_.established();
+    }
+
+    /**
+     * @brief 根据已加载的参数创建本地监听
+     */
+    void ingress::prepare()
+    {
+        const auto &config = option_.ingress;
+        if (config.host.empty() || config.path.empty())
+        {
+            throw abnormal::protocol_error("ingress 需要配置远端地址与多路复用路径");
+        }
+
+        const tcp::endpoint endpoint(net::ip::make_address(config.listen), config.local);
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen();
+    }
+
+    /**
+     * @brief 本地接入循环
+     */
+    net::awaitable<void> ingress::accept()
+    {
+        net::steady_timer backoff(ioc_);
+        while (acceptor_.is_open())
+        {
+            boost::system::error_code ec;
+            tcp::socket socket = co_await acceptor_.async_accept(net::redirect_error(net::use_awaitable, ec));
+            if (ec)
+            {
+                if (ec == net::error::operation_aborted)
+                {
+                    co_return;
+                }
+                // 文件描述符耗尽等错误，稍后再试，避免空转
+                backoff.expires_after(std::chrono::milliseconds(100));
+                co_await backoff.async_wait(net::redirect_error(net::use_awaitable, ec));
+                continue;
+            }
+
+            net::co_spawn(ioc_, serve(std::move(socket)), [](const std::exception_ptr &)
+            {
+                // 单个本地连接的异常不影响其他连接
+            });
+        }
+    }
+
+    /**
+     * @brief 完成 SOCKS5 方法协商并读取 CONNECT 请求
+     * @param socket 本地连接
+     * @param result 解析出的请求，仅填写 `destination`
+     * @return 请求可以转发时为 `true`；不支持的请求已回复错误码
+     * @note 只支持无认证方式、CONNECT 命令以及 IPv4 / 域名地址，远端按 `host:port` 解析目标，不接受 IPv6 字面量。
+     */
+    net::awaitable<bool> ingress::socks_request(tcp::socket &socket, request &result)
+    {
+        boost::system::error_code ec;
+        auto token = net::redirect_error(net::use_awaitable, ec);
+
+        std::array<std::uint8_t, 2> greeting{};
+        co_await net::async_read(socket, net::buffer(greeting), token);
+        if (ec || greeting[0] != socks_version || greeting[1] == 0)
+        {
+            co_return false;
+        }
+
+        std::array<std::uint8_t, 255> methods{};
+        co_await net::async_read(socket, net::buffer(methods.data(), greeting[1]), token);
+        if (ec)
+        {
+            co_return false;
+        }
+
+        const bool anonymous = std::find(methods.begin(), methods.begin() + greeting[1], 0x00) != methods.begin() + greeting[1];
+        const std::array<std::uint8_t, 2> selection{socks_version, static_cast<std::uint8_t>(anonymous ? 0x00 : 0xFF)};
+        co_await net::async_write(socket, net::buffer(selection), token);
+        if (ec || !anonymous)
+        {
+            co_return false;
+        }
+
+        // VER CMD RSV ATYP
+        std::array<std::uint8_t, 4> head{};
+        co_await net::async_read(socket, net::buffer(head), token);
+        if (ec || head[0] != socks_version)
+        {
+            co_return false;
+        }
+        if (head[1] != 0x01)
+        {
+            co_await answer(socket, socks_reply::command);
+            co_return false;
+        }
+
+        std::string host;
+        if (head[3] == 0x01)
+        {
+            net::ip::address_v4::bytes_type bytes{};
+            co_await net::async_read(socket, net::buffer(bytes), token);
+            host = net::ip::make_address_v4(bytes).to_string();
+        }
+        else if (head[3] == 0x03)
+        {
+            std::uint8_t length = 0;
+            co_await net::async_read(socket, net::buffer(&length, 1), token);
+            if (!ec)
+            {
+                host.resize(length);
+                co_await net::async_read(socket, net::buffer(host), token);
+            }
+        }
+        else
+        {
+            co_await answer(socket, socks_reply::address);
+            co_return false;
+        }
+
+        std::array<std::uint8_t, 2> port{};
+        if (!ec)
+        {
+            co_await net::async_read(socket, net::buffer(port), token);
+        }
+        if (ec || host.empty())
+        {
+            co_return false;
+        }
+
+        result.destination = std::format("{}:{}", host, (port[0] << 8) | port[1]);
+        co_return true;
+    }
+
+    /**
+     * @brief 读取 HTTP 代理请求
+     * @param socket 本地连接
+     * @param result 解析出的请求
+     * @return 请求可以转发时为 `true`；只接受 CONNECT 与绝对 URI 请求，不回复任何错误
+     * @details 非 CONNECT 请求重新序列化后作为首包；请求之后已预读的数据追加在首包末尾。
+     */
+    net::awaitable<bool> ingress::proxy_request(tcp::socket &socket, request &result)
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        beast::flat_buffer buffer;
+        http::request req(&arena);
+        if (!co_await http::async_read(socket, req, buffer, &arena))
+        {
+            co_return false;
+        }
+
+        const auto target = analysis::resolve(req, &arena);
+        if (!target.forward_proxy || target.host.empty())
+        {
+            co_return false;
+        }
+        result.destination = std::format("{}:{}", std::string_view(target.host), std::string_view(target.port));
+
+        result.connect = req.method() == http::verb::connect;
+        if (!result.connect)
+        {
+            const auto data = http::serialize(req, &arena);
+            result.first.assign(data.begin(), data.end());
+        }
+        const auto rest = buffer.data();
+        result.first.append(static_cast<const char *>(rest.data()), rest.size());
+        co_return true;
+    }
+
+    /**
+     * @brief 处理一个本地连接
+     * @details 首字节为 0x05 按 SOCKS5 处理，否则按 HTTP 代理请求处理；
+     * 非 CONNECT 请求与已预读的数据作为首包随 `connect` 帧之后立即发出。
+     */
+    net::awaitable<void> ingress::serve(tcp::socket socket)
+    {
+        boost::system::error_code ec;
+        socket.set_option(tcp::no_delay(true), ec);
+
+        std::array<char, 1> peek{};
+        co_await socket.async_receive(net::buffer(peek), tcp::socket::message_peek, net::redirect_error(net::use_awaitable, ec));
+        if (ec)
+        {
+            co_return;
+        }
+
+        const bool socks = static_cast<std::uint8_t>(peek[0]) == socks_version;
+        request incoming;
+        if (!co_await (socks ? socks_request(socket, incoming) : proxy_request(socket, incoming)))
+        {
+            co_return;
+        }
+
+        const auto target = pool_.acquire();
+        if (socks)
+        {
+            co_await answer(socket, target ? socks_reply::succeeded : socks_reply::failure);
+        }
+        else if (!target || incoming.connect)
+        {
+            const auto response = target ? established_response : unavailable_response;
+            co_await net::async_write(socket, net::buffer(response), net::redirect_error(net::use_awaitable, ec));
+        }
+        if (!target || ec)
+        {
+            co_return;
+        }
+
+        internal_ptr local(new tcp::socket(std::move(socket)), deleter{});
+        co_await net::co_spawn(target->strand, target->mux->relay(std::move(local), std::move(incoming.destination), std::move(incoming.first)),
+            net::use_awaitable);
+    }
+}
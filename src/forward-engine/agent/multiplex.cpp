@@ -0,0 +1,638 @@
+#include <agent/multiplex.hpp>
+#include <agent/adaptation.hpp>
+#include <agent/analysis.hpp>
+#include <abnormal.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <boost/endian/conversion.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        [[nodiscard]] bool graceful(const boost::system::error_code &ec) noexcept
+        {
+            using namespace boost::asio;
+            return ec == error::eof || ec == error::operation_aborted || ec == error::connection_reset
+                || ec == error::connection_aborted || ec == error::broken_pipe || ec == error::not_connected
+                || ec == beast::websocket::error::closed;
+        }
+
+        /**
+         * @brief 编码窗口增量（4 字节大端）
+         */
+        [[nodiscard]] std::string encode_credit(const std::size_t credit)
+        {
+            const auto value = static_cast<std::uint32_t>(std::min<std::size_t>(credit, std::numeric_limits<std::uint32_t>::max()));
+            const std::uint32_t big = boost::endian::native_to_big(value);
+            std::string payload(sizeof(big), '\0');
+            std::memcpy(payload.data(), &big, sizeof(big));
+            return payload;
+        }
+
+        /**
+         * @brief 解码窗口增量，格式错误时为 0
+         */
+        [[nodiscard]] std::size_t decode_credit(const std::string_view payload) noexcept
+        {
+            if (payload.size() != sizeof(std::uint32_t))
+            {
+                return 0;
+            }
+            std::uint32_t big = 0;
+            std::memcpy(&big, payload.data(), sizeof(big));
+            return boost::endian::big_to_native(big);
+        }
+
+        /**
+         * @brief 上游单次读取的最大块
+         */
+        constexpr std::size_t chunk_size = 16384;
+
+        void shut_close(const internal_ptr &socket) noexcept
+        {
+            if (socket && socket->is_open())
+            {
+                boost::system::error_code ec;
+                socket->shutdown(tcp::socket::shutdown_both, ec);
+                socket->close(ec);
+            }
+        }
+    }
+
+    multiplex::stream::stream(const std::uint32_t identity, const net::any_io_executor &executor)
+        : id(identity), arrival(executor), replenish(executor)
+    {
+    }
+
+    /**
+     * @brief 构造多路复用会话
+     * @param proto 已完成握手的 obscura 连接
+     * @param dist 路由器
+     * @param opt 多路复用参数
+     * @param activity 有数据往来时的回调（用于刷新外层会话的空闲超时）
+     */
+    multiplex::multiplex(std::shared_ptr<obscura<tcp>> proto, distributor &dist, const option::multiplex_option &opt,
+        std::function<void()> activity)
+        : proto_(std::move(proto)), distributor_(&dist), option_(opt), activity_(std::move(activity)), window_(opt.window)
+    {
+    }
+
+    /**
+     * @brief 构造客户端角色的多路复用会话
+     * @param proto 已完成握手的 obscura 客户端连接
+     * @param opt 多路复用参数（`streams` 限制本端同时发起的流数）
+     * @param activity 有数据往来时的回调
+     */
+    multiplex::multiplex(std::shared_ptr<obscura<tcp>> proto, const option::multiplex_option &opt,
+        std::function<void()> activity)
+        : proto_(std::move(proto)), distributor_(nullptr), option_(opt), activity_(std::move(activity)), window_(opt.window)
+    {
+    }
+
+    /**
+     * @brief 运行多路复用会话，直到 obscura 连接结束
+     * @details 读协程与写协程并发运行；读协程退出时关闭所有流并通知写协程退出，
+     * 因此返回后 obscura 上不再有挂起的读写，调用方可以安全地关闭它。
+     */
+    net::awaitable<void> multiplex::run()
+    {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        executor_ = co_await net::this_coro::executor;
+        wake_ = std::make_unique<net::steady_timer>(executor_);
+        pulse_ = std::make_unique<net::steady_timer>(executor_);
+
+        if (distributor_)
+        {   // 告知客户端每条流的初始窗口
+            enqueue(frame::type::window, 0, encode_credit(window_));
+            ready_.store(true, std::memory_order_relaxed);
+        }
+
+        if (!distributor_ && heartbeat_.count() > 0)
+        {
+            co_await (reader() && writer() && keeper());
+        }
+        else
+        {
+            co_await (reader() && writer());
+        }
+
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+    }
+
+    /**
+     * @brief 读协程：解析客户端帧并分派
+     * @details 读协程只做入队，不等待任何上游写入，单条流的上游再慢也不会阻塞其他流。
+     */
+    net::awaitable<void> multiplex::reader()
+    {
+        beast::flat_buffer buffer;
+        try
+        {
+            while (true)
+            {
+                buffer.clear();
+                const std::size_t n = co_await proto_->async_read(buffer);
+                touch();
+                if (n == 0)
+                {
+                    break;
+                }
+
+                // 直接在读缓冲区上解析，负载不复制
+                frame_view incoming;
+                if (!decode(std::string_view(static_cast<const char *>(buffer.data().data()), n), incoming))
+                {
+                    throw abnormal::protocol_error("multiplex 帧格式错误, 长度: {}", n);
+                }
+
+                const auto id = incoming.stream_id;
+                switch (incoming.type)
+                {
+                case frame::type::connect:
+                {
+                    if (!distributor_ || id == 0 || streams_.contains(id) || streams_.size() >= option_.streams)
+                    {
+                        enqueue(frame::type::close, id);
+                        break;
+                    }
+                    auto target = std::make_shared<stream>(id, executor_);
+                    target->credit = static_cast<std::int64_t>(window_);
+                    streams_.emplace(id, target);
+                    count();
+                    net::co_spawn(executor_, open(std::move(target), std::string(incoming.data)), net::detached);
+                    break;
+                }
+                case frame::type::data:
+                {
+                    if (const auto it = streams_.find(id); it != streams_.end())
+                    {
+                        accept(it->second, incoming.data);
+                    }
+                    // 否则是已关闭的流上的迟到数据，丢弃
+                    break;
+                }
+                case frame::type::window:
+                    if (id == 0 && !distributor_)
+                    {   // 服务端通告的初始窗口
+                        window_ = std::max<std::size_t>(decode_credit(incoming.data), 1);
+                        ready_.store(true, std::memory_order_relaxed);
+                        break;
+                    }
+                    grant(id, incoming.data);
+                    break;
+                case frame::type::close:
+                {
+                    if (const auto it = streams_.find(id); it != streams_.end())
+                    {
+                        release(it->second, false);
+                    }
+                    break;
+                }
+                case frame::type::keepalive:
+                    if (distributor_)
+                    {
+                        enqueue(frame::type::keepalive, id, incoming.data);
+                    }
+                    else
+                    {   // 客户端收到的是探测的回显
+                        answered_ = true;
+                    }
+                    break;
+                default:
+                    // udp 等尚未支持的类型直接拒绝
+                    enqueue(frame::type::close, id);
+                    break;
+                }
+            }
+        }
+        catch (const boost::system::system_error &e)
+        {
+            if (!graceful(e.code()) && !error_)
+            {
+                error_ = std::make_exception_ptr(abnormal::protocol_error("multiplex 读失败: {}", e.code().message()));
+            }
+        }
+        catch (...)
+        {
+            error_ = std::current_exception();
+        }
+
+        shutdown();
+    }
+
+    /**
+     * @brief 写协程：控制帧优先，数据帧在各流之间轮转
+     */
+    net::awaitable<void> multiplex::writer()
+    {
+        boost::system::error_code ec;
+        while (true)
+        {
+            while (control_.empty() && rotation_.empty() && !stopped_)
+            {
+                wake_->expires_at(net::steady_timer::time_point::max());
+                co_await wake_->async_wait(net::redirect_error(net::use_awaitable, ec));
+            }
+            if (stopped_)
+            {
+                co_return;
+            }
+
+            message item;
+            if (!control_.empty())
+            {
+                item = std::move(control_.front());
+                control_.pop_front();
+            }
+            else
+            {
+                auto target = std::move(rotation_.front());
+                rotation_.pop_front();
+                if (target->outbound.empty())
+                {   // 客户端关闭流时已清空
+                    target->scheduled = false;
+                    continue;
+                }
+
+                item = std::move(target->outbound.front());
+                target->outbound.pop_front();
+                if (target->outbound.empty())
+                {
+                    target->scheduled = false;
+                }
+                else
+                {   // 还有数据，排到队尾等下一轮
+                    rotation_.push_back(std::move(target));
+                }
+            }
+
+            try
+            {
+                co_await proto_->async_write(item.buffers());
+            }
+            catch (const std::exception &)
+            {   // 写失败后连接不可再用，关闭底层 socket 让读协程退出并清理
+                stopped_ = true;
+                proto_->abort();
+                co_return;
+            }
+            touch();
+        }
+    }
+
+    /**
+     * @brief 保活协程（仅客户端角色）：按周期发送 `keepalive`，上一次探测未获回显时中止连接
+     * @details 中止底层 socket 后读协程随即出错退出，由它统一清理所有流。
+     */
+    net::awaitable<void> multiplex::keeper()
+    {
+        boost::system::error_code ec;
+        while (!stopped_)
+        {
+            pulse_->expires_after(heartbeat_);
+            co_await pulse_->async_wait(net::redirect_error(net::use_awaitable, ec));
+            if (stopped_)
+            {
+                co_return;
+            }
+            if (!answered_)
+            {
+                error_ = std::make_exception_ptr(abnormal::protocol_error("multiplex 保活超时"));
+                stopped_ = true;
+                proto_->abort();
+                co_return;
+            }
+            answered_ = false;
+            enqueue(frame::type::keepalive, 0);
+        }
+    }
+
+    /**
+     * @brief 建立上游并开始双向转发
+     * @param target 流
+     * @param destination `host:port`
+     */
+    net::awaitable<void> multiplex::open(std::shared_ptr<stream> target, std::string destination)
+    {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        auto self = shared_from_this();
+        try
+        {
+            const auto address = analysis::resolve(std::string_view(destination));
+            if (address.host.empty())
+            {
+                release(target, true);
+                co_return;
+            }
+            target->upstream = co_await distributor_->route_forward(address.host, address.port);
+        }
+        catch (const std::exception &)
+        {
+            release(target, true);
+            co_return;
+        }
+
+        if (target->closed || !target->upstream || !target->upstream->is_open())
+        {   // 建立期间客户端已关闭该流或整个连接
+            release(target, true);
+            co_return;
+        }
+
+        // 任一方向结束都会 release，另一方向随之退出
+        co_await (sink(target) && pump(target));
+    }
+
+    /**
+     * @brief 客户端角色：发起一条流并在本地 socket 与流之间双向转发
+     * @param local 本地接入的 socket
+     * @param destination `host:port`
+     * @param first 本地已读出、需要先发送的数据
+     * @details `connect` 帧之后立即开始发送数据，不等待服务端确认；服务端建立上游失败时以 `close` 帧结束该流。
+     * 连接已失效或流数已满时直接关闭本地 socket。
+     */
+    net::awaitable<void> multiplex::relay(internal_ptr local, std::string destination, std::string first)
+    {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        auto self = shared_from_this();
+        if (distributor_ || stopped_ || streams_.size() >= option_.streams)
+        {
+            shut_close(local);
+            co_return;
+        }
+
+        const std::uint32_t id = next_id_;
+        next_id_ += 2; // 客户端发起的流使用奇数 ID
+        auto target = std::make_shared<stream>(id, executor_);
+        target->credit = static_cast<std::int64_t>(window_);
+        target->upstream = std::move(local);
+        streams_.emplace(id, target);
+        count();
+
+        enqueue(frame::type::connect, id, destination);
+        co_await (sink(target) && pump(target, std::move(first)));
+    }
+
+    /**
+     * @brief 客户端 -> 上游：把流的接收队列写入上游，并按消费量归还信用
+     * @details 信用在数据真正写入上游后才归还（累计到半个窗口时批量发送），上游停滞时客户端自然停止发送这条流。
+     */
+    net::awaitable<void> multiplex::sink(std::shared_ptr<stream> target)
+    {
+        boost::system::error_code ec;
+        while (true)
+        {
+            while (target->inbound.empty() && !target->closed)
+            {
+                target->arrival.expires_at(net::steady_timer::time_point::max());
+                co_await target->arrival.async_wait(net::redirect_error(net::use_awaitable, ec));
+            }
+            if (target->closed)
+            {
+                co_return;
+            }
+
+            const std::string chunk = std::move(target->inbound.front());
+            target->inbound.pop_front();
+
+            ec.clear();
+            co_await adaptation::async_write(*target->upstream, net::buffer(chunk), net::redirect_error(net::use_awaitable, ec));
+            if (ec)
+            {
+                release(target, true);
+                co_return;
+            }
+
+            target->inbound_bytes -= chunk.size();
+            target->consumed += chunk.size();
+            if (target->consumed >= window_ / 2)
+            {
+                enqueue(frame::type::window, target->id, encode_credit(target->consumed));
+                target->consumed = 0;
+            }
+        }
+    }
+
+    /**
+     * @brief 上游 -> 客户端：在客户端窗口内读取上游并封装为 `data` 帧
+     * @param target 流
+     * @param pending 先于上游数据发送的字节（客户端角色下本地已读出的首包）
+     * @details 每次读取不超过剩余信用，单条流在写队列里的数据量因此不超过一个窗口。
+     */
+    net::awaitable<void> multiplex::pump(std::shared_ptr<stream> target, std::string pending)
+    {
+        boost::system::error_code ec;
+        std::size_t offset = 0;
+        while (!target->closed)
+        {
+            while (target->credit <= 0 && !target->closed)
+            {
+                target->replenish.expires_at(net::steady_timer::time_point::max());
+                co_await target->replenish.async_wait(net::redirect_error(net::use_awaitable, ec));
+            }
+            if (target->closed)
+            {
+                break;
+            }
+
+            // 直接读进待发送帧的负载，帧头单独编码，发送时聚集写入
+            message item{encode(frame::type::data, target->id)};
+            const auto limit = std::min<std::size_t>(chunk_size, static_cast<std::size_t>(target->credit));
+            if (offset < pending.size())
+            {
+                const auto n = std::min(limit, pending.size() - offset);
+                item.body = std::make_unique_for_overwrite<char[]>(n);
+                std::memcpy(item.body.get(), pending.data() + offset, n);
+                item.size = n;
+                offset += n;
+                target->credit -= static_cast<std::int64_t>(n);
+                schedule(target, std::move(item));
+                continue;
+            }
+            item.body = std::make_unique_for_overwrite<char[]>(limit);
+
+            ec.clear();
+            const std::size_t n = co_await target->upstream->async_read_some(net::buffer(item.body.get(), limit),
+                net::redirect_error(net::use_awaitable, ec));
+            if (ec || n == 0)
+            {
+                break;
+            }
+            touch();
+
+            if (n < limit / 4)
+            {   // 小块收缩到实际大小，避免队列里大量半空的块占用远超窗口的内存
+                auto exact = std::make_unique_for_overwrite<char[]>(n);
+                std::memcpy(exact.get(), item.body.get(), n);
+                item.body = std::move(exact);
+            }
+            item.size = n;
+
+            target->credit -= static_cast<std::int64_t>(n);
+            schedule(target, std::move(item));
+        }
+
+        release(target, true);
+    }
+
+    /**
+     * @brief 接收客户端数据帧
+     * @details 超出窗口视为客户端违反流控，关闭该流。
+     * 读缓冲区会被下一条消息复用，所以这里是客户端 -> 上游方向唯一的一次复制。
+     */
+    void multiplex::accept(const std::shared_ptr<stream> &target, const std::string_view data)
+    {
+        if (target->inbound_bytes + data.size() > window_)
+        {
+            release(target, true);
+            return;
+        }
+
+        target->inbound.emplace_back(data);
+        target->inbound_bytes += data.size();
+        target->arrival.cancel();
+    }
+
+    /**
+     * @brief 处理客户端的 `window` 帧，增加对应流的发送信用
+     */
+    void multiplex::grant(const std::uint32_t id, const std::string_view payload)
+    {
+        const auto it = streams_.find(id);
+        if (it == streams_.end())
+        {
+            return;
+        }
+
+        it->second->credit += static_cast<std::int64_t>(decode_credit(payload));
+        it->second->replenish.cancel();
+    }
+
+    /**
+     * @brief 入队一个控制帧
+     */
+    void multiplex::enqueue(const enum frame::type type, const std::uint32_t id, const std::string_view data)
+    {
+        if (stopped_)
+        {
+            return;
+        }
+        message item{encode(type, id)};
+        if (!data.empty())
+        {
+            item.body = std::make_unique_for_overwrite<char[]>(data.size());
+            std::memcpy(item.body.get(), data.data(), data.size());
+            item.size = data.size();
+        }
+        control_.push_back(std::move(item));
+        wake_->cancel();
+    }
+
+    /**
+     * @brief 把一帧放入流的发送队列，并让流参与轮转
+     */
+    void multiplex::schedule(const std::shared_ptr<stream> &target, message item)
+    {
+        if (stopped_)
+        {
+            return;
+        }
+
+        target->outbound.push_back(std::move(item));
+        if (!target->scheduled)
+        {
+            target->scheduled = true;
+            rotation_.push_back(target);
+        }
+        wake_->cancel();
+    }
+
+    /**
+     * @brief 关闭一条流
+     * @param target 流
+     * @param notify 是否向客户端发送 `close` 帧（客户端主动关闭时不需要）
+     * @details `close` 帧排在该流已入队的数据帧之后，保证客户端先收完数据。
+     * 只关闭上游 socket，连接对象随流一起释放，避免正在使用它的协程访问悬空指针。
+     * `target` 按值传入：调用方常传 `streams_` 里的元素，从表中移除后仍需使用它。
+     */
+    void multiplex::release(const std::shared_ptr<stream> target, const bool notify)
+    {
+        if (target->closed)
+        {
+            return;
+        }
+        target->closed = true;
+        streams_.erase(target->id);
+        count();
+
+        if (notify)
+        {
+            schedule(target, message{encode(frame::type::close, target->id)});
+        }
+        else
+        {
+            target->outbound.clear();
+        }
+
+        target->inbound.clear();
+        shut_close(target->upstream);
+        target->arrival.cancel();
+        target->replenish.cancel();
+    }
+
+    /**
+     * @brief 关闭所有流并通知写协程退出
+     */
+    void multiplex::shutdown()
+    {
+        stopped_ = true;
+        for (auto &[id, target] : streams_)
+        {
+            target->closed = true;
+            shut_close(target->upstream);
+            target->arrival.cancel();
+            target->replenish.cancel();
+        }
+        streams_.clear();
+        count();
+        ready_.store(false, std::memory_order_relaxed);
+        rotation_.clear();
+        control_.clear();
+        wake_->cancel();
+        pulse_->cancel();
+    }
+
+    /**
+     * @brief 流数变化后更新活跃流数与缓冲内存计量
+     */
+    void multiplex::count() noexcept
+    {
+        active_.store(streams_.size(), std::memory_order_relaxed);
+        if (meter_)
+        {
+            const std::size_t footprint = streams_.size() * (sizeof(stream) + 2 * window_);
+            if (footprint != metered_)
+            {
+                meter_(static_cast<std::ptrdiff_t>(footprint) - static_cast<std::ptrdiff_t>(metered_));
+                metered_ = footprint;
+            }
+        }
+    }
+
+    void multiplex::touch() const
+    {
+        if (activity_)
+        {
+            activity_();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+#include <agent/offload.hpp>
+#include <algorithm>
+
+namespace ngx::agent
+{
+    offload::offload(const std::size_t threads, const std::size_t capacity)
+        : pool_(std::max<std::size_t>(threads, 1)), capacity_(std::max<std::size_t>(capacity, 1))
+    {
+    }
+
+    offload::~offload()
+    {
+        stop();
+    }
+
+    /**
+     * @brief 停止线程池并等待线程退出
+     * @details 尚未执行的握手被丢弃，对应会话的协程不会再恢复，由其所属 `io_context` 的关闭流程回收。
+     */
+    void offload::stop()
+    {
+        pool_.stop();
+        pool_.join();
+    }
+
+    /**
+     * @brief 占用一个排队名额
+     * @return 名额已满时返回 `false`
+     */
+    bool offload::enter() noexcept
+    {
+        std::size_t current = depth_.load(std::memory_order_relaxed);
+        do
+        {
+            if (current >= capacity_)
+            {
+                return false;
+            }
+        } while (!depth_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+        return true;
+    }
+
+    void offload::leave() noexcept
+    {
+        depth_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
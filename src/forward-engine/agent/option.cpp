@@ -0,0 +1,120 @@
+#include <agent/option.hpp>
+#include <algorithm>
+#include <cstdint>
+
+namespace ngx::agent
+{
+    /**
+     * @brief 获取默认参数
+     * @return 全局只读的默认参数实例
+     */
+    const option &option::defaults() noexcept
+    {
+        static const option instance{};
+        return instance;
+    }
+
+    /**
+     * @brief 从配置树加载参数
+     * @param tree 配置文件根节点
+     * @return 加载后的参数，缺失的字段保持默认值
+     * @details 读取 `agent.option` 节点，例如：
+     * `{"agent": {"option": {"zerocopy": {"enable": true, "threshold": 32768}}}}`
+     */
+    option option::load(const boost::property_tree::ptree &tree)
+    {
+        option result{};
+        const auto node = tree.get_child_optional("agent.option");
+        if (!node)
+        {
+            return result;
+        }
+
+        auto &zerocopy = result.zerocopy;
+        zerocopy.enable = node->get<bool>("zerocopy.enable", zerocopy.enable);
+        zerocopy.threshold = node->get<std::size_t>("zerocopy.threshold", zerocopy.threshold);
+        zerocopy.block = std::max<std::size_t>(node->get<std::size_t>("zerocopy.block", zerocopy.block), 4096);
+        zerocopy.depth = std::max<std::size_t>(node->get<std::size_t>("zerocopy.depth", zerocopy.depth), 2);
+
+        result.reservoir.slots = node->get<std::size_t>("reservoir.slots", result.reservoir.slots);
+
+        auto &timeout = result.timeout;
+        const auto seconds = [&node](const char *key, const std::chrono::seconds fallback)
+        {
+            return std::chrono::seconds(node->get<std::int64_t>(key, fallback.count()));
+        };
+        timeout.header = seconds("timeout.header", timeout.header);
+        timeout.connect = seconds("timeout.connect", timeout.connect);
+        timeout.idle = seconds("timeout.idle", timeout.idle);
+        timeout.lifetime = seconds("timeout.lifetime", timeout.lifetime);
+        timeout.tick = std::chrono::milliseconds(std::max<std::int64_t>(node->get<std::int64_t>("timeout.tick", timeout.tick.count()), 1));
+
+        auto &accept = result.accept;
+        accept.concurrency = std::max<std::size_t>(node->get<std::size_t>("accept.concurrency", accept.concurrency), 1);
+        accept.batch = std::max<std::size_t>(node->get<std::size_t>("accept.batch", accept.batch), 1);
+        accept.defer = seconds("accept.defer", accept.defer);
+
+        auto &admission = result.admission;
+        const auto milliseconds = [&node](const char *key, const std::chrono::milliseconds fallback)
+        {
+            return std::chrono::milliseconds(node->get<std::int64_t>(key, fallback.count()));
+        };
+        admission.soft_sessions = node->get<std::size_t>("admission.sessions.soft", admission.soft_sessions);
+        admission.hard_sessions = node->get<std::size_t>("admission.sessions.hard", admission.hard_sessions);
+        // 配置文件中内存以 MiB 为单位
+        admission.soft_memory = node->get<std::size_t>("admission.memory.soft", admission.soft_memory >> 20) << 20;
+        admission.hard_memory = node->get<std::size_t>("admission.memory.hard", admission.hard_memory >> 20) << 20;
+        admission.soft_lag = milliseconds("admission.lag.soft", admission.soft_lag);
+        admission.hard_lag = milliseconds("admission.lag.hard", admission.hard_lag);
+        admission.interval = std::max(milliseconds("admission.interval", admission.interval), std::chrono::milliseconds(1));
+        if (node->get<std::string>("admission.shed", "reply") == "reset")
+        {
+            admission.shed = admission_option::shed_mode::reset;
+        }
+
+        auto &quota = result.quota;
+        quota.rate = std::max(node->get<double>("quota.rate", quota.rate), 0.0);
+        quota.burst = node->get<std::size_t>("quota.burst", quota.burst);
+        quota.sessions = node->get<std::size_t>("quota.sessions", quota.sessions);
+        quota.bandwidth = node->get<std::size_t>("quota.bandwidth", quota.bandwidth);
+        quota.clients = std::max<std::size_t>(node->get<std::size_t>("quota.clients", quota.clients), 1);
+
+        auto &shaping = result.shaping;
+        shaping.global = node->get<std::size_t>("shaping.global", shaping.global);
+        shaping.listener = node->get<std::size_t>("shaping.listener", shaping.listener);
+        shaping.session = node->get<std::size_t>("shaping.session", shaping.session);
+        shaping.burst = milliseconds("shaping.burst", shaping.burst);
+        shaping.tick = std::max(milliseconds("shaping.tick", shaping.tick), std::chrono::milliseconds(1));
+
+        result.multiplex.path = node->get<std::string>("multiplex.path", result.multiplex.path);
+        result.multiplex.streams = std::max<std::size_t>(node->get<std::size_t>("multiplex.streams", result.multiplex.streams), 1);
+        result.multiplex.window = std::max<std::size_t>(node->get<std::size_t>("multiplex.window", result.multiplex.window), 16384);
+
+        auto &obscura = result.obscura;
+        obscura.batch = node->get<std::size_t>("obscura.batch", obscura.batch);
+        obscura.delay = milliseconds("obscura.delay", obscura.delay);
+        obscura.write_buffer = std::max<std::size_t>(node->get<std::size_t>("obscura.write_buffer", obscura.write_buffer), 4096);
+        obscura.message_max = std::max<std::size_t>(node->get<std::size_t>("obscura.message_max", obscura.message_max), 65536);
+
+        result.tls.rotate = seconds("tls.rotate", result.tls.rotate);
+        result.tls.keys = std::max<std::size_t>(node->get<std::size_t>("tls.keys", result.tls.keys), 1);
+        result.tls.threads = node->get<std::size_t>("tls.offload.threads", result.tls.threads);
+        result.tls.queue = std::max<std::size_t>(node->get<std::size_t>("tls.offload.queue", result.tls.queue), 1);
+
+        auto &ingress = result.ingress;
+        ingress.listen = node->get<std::string>("ingress.listen", ingress.listen);
+        ingress.local = node->get<std::uint16_t>("ingress.local", ingress.local);
+        ingress.host = node->get<std::string>("ingress.host", ingress.host);
+        ingress.port = node->get<std::uint16_t>("ingress.port", ingress.port);
+        ingress.sni = node->get<std::string>("ingress.sni", ingress.sni);
+        ingress.path = node->get<std::string>("ingress.path", ingress.path);
+        ingress.ca = node->get<std::string>("ingress.ca", ingress.ca);
+        ingress.verify = node->get<bool>("ingress.verify", ingress.verify);
+        ingress.min = std::max<std::size_t>(node->get<std::size_t>("ingress.pool.min", ingress.min), 1);
+        ingress.max = std::max(node->get<std::size_t>("ingress.pool.max", ingress.max), ingress.min);
+        ingress.keepalive = seconds("ingress.pool.keepalive", ingress.keepalive);
+        ingress.idle = seconds("ingress.pool.idle", ingress.idle);
+
+        return result;
+    }
+}
@@ -0,0 +1,223 @@
+#include <agent/quota.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        constexpr std::int64_t second = 1000000000; // 纳秒
+        constexpr std::size_t shards = 64;
+    }
+
+    quota::pass::pass(const quota *owner, slot *entry) noexcept
+        : owner_(owner), slot_(entry)
+    {
+    }
+
+    quota::pass::pass(pass &&other) noexcept
+        : owner_(std::exchange(other.owner_, nullptr)), slot_(std::exchange(other.slot_, nullptr))
+    {
+    }
+
+    quota::pass &quota::pass::operator=(pass &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            owner_ = std::exchange(other.owner_, nullptr);
+            slot_ = std::exchange(other.slot_, nullptr);
+        }
+        return *this;
+    }
+
+    quota::pass::~pass()
+    {
+        reset();
+    }
+
+    void quota::pass::reset() noexcept
+    {
+        if (slot_)
+        {
+            slot_->seen.store(shaper::now(), std::memory_order_relaxed);
+            slot_->sessions.fetch_sub(1, std::memory_order_release);
+            owner_ = nullptr;
+            slot_ = nullptr;
+        }
+    }
+
+    shaper::level quota::pass::level() const noexcept
+    {
+        if (!slot_ || owner_->bandwidth_.bytes == 0)
+        {
+            return {};
+        }
+        return shaper::level{&slot_->bytes, &owner_->bandwidth_};
+    }
+
+    /**
+     * @brief 构造配额表
+     * @param opt 配额参数（由 `worker` 持有）
+     * @details 槽位数向上取整为 2 的幂，且每个分片至少容纳一个探测窗口。
+     */
+    quota::quota(const option::quota_option &opt)
+        : option_(opt), bandwidth_(opt.bandwidth, std::chrono::seconds(1))
+    {
+        const std::size_t count = std::bit_ceil(std::max(opt.clients, shards * window));
+        slots_ = std::make_unique<slot[]>(count);
+        mask_ = count - 1;
+        shard_ = count / shards;
+
+        if (opt.rate > 0)
+        {
+            interval_ = std::max<std::int64_t>(static_cast<std::int64_t>(static_cast<double>(second) / opt.rate), 1);
+            const auto burst = static_cast<std::int64_t>(std::max<std::size_t>(opt.burst, 1));
+            tolerance_ = interval_ * burst;
+        }
+    }
+
+    /**
+     * @brief 客户端接入
+     * @param client 客户端地址
+     * @return 超过连接速率或并发会话上限时返回空，否则返回会话持有的凭证
+     */
+    std::optional<quota::pass> quota::enter(const net::ip::address &client) noexcept
+    {
+        if (!enabled(option_))
+        {
+            return pass{};
+        }
+
+        const auto time = shaper::now();
+        const auto key = fingerprint(client);
+        slot *entry = locate(key, time);
+        if (!entry)
+        {   // 窗口内全是有存活会话的客户端，不做跟踪
+            return pass{};
+        }
+        entry->seen.store(time, std::memory_order_relaxed);
+
+        if (interval_ != 0)
+        {
+            auto expected = entry->connect.load(std::memory_order_relaxed);
+            std::int64_t arrival;
+            do
+            {
+                arrival = std::max(expected, time) + interval_;
+                if (arrival - time > tolerance_)
+                {
+                    return std::nullopt;
+                }
+            }
+            while (!entry->connect.compare_exchange_weak(expected, arrival, std::memory_order_relaxed));
+        }
+
+        const auto live = entry->sessions.fetch_add(1, std::memory_order_acquire) + 1;
+        if (entry->key.load(std::memory_order_acquire) != key)
+        {   // 计数前槽位刚被其他客户端接管
+            entry->sessions.fetch_sub(1, std::memory_order_release);
+            return pass{};
+        }
+        if (option_.sessions != 0 && live > option_.sessions)
+        {
+            entry->sessions.fetch_sub(1, std::memory_order_release);
+            return std::nullopt;
+        }
+        return pass(this, entry);
+    }
+
+    /**
+     * @brief 查找或分配客户端槽位
+     * @details 先在窗口内找同一指纹，再抢占空位；都没有时以 CAS 接管窗口内最久未活动且没有存活会话的槽位，
+     * 接管后重置两个桶。并发接管同一槽位时只有一个线程成功，失败的一方按不限制处理。
+     */
+    quota::slot *quota::locate(const std::uint64_t key, const std::int64_t time) noexcept
+    {
+        const std::size_t base = static_cast<std::size_t>(key >> 58) * shard_ & mask_;
+        const std::size_t offset = static_cast<std::size_t>(key) & (shard_ - 1);
+        const auto at = [&](const std::size_t i) -> slot &
+        {
+            return slots_[base + ((offset + i) & (shard_ - 1))];
+        };
+
+        for (std::size_t i = 0; i < window; ++i)
+        {
+            if (at(i).key.load(std::memory_order_acquire) == key)
+            {
+                return &at(i);
+            }
+        }
+
+        slot *victim = nullptr;
+        std::uint64_t victim_key = 0;
+        std::int64_t oldest = std::numeric_limits<std::int64_t>::max();
+        for (std::size_t i = 0; i < window; ++i)
+        {
+            auto &candidate = at(i);
+            auto current = candidate.key.load(std::memory_order_acquire);
+            if (current == 0)
+            {
+                if (candidate.key.compare_exchange_strong(current, key, std::memory_order_acq_rel))
+                {
+                    return &candidate;
+                }
+                if (current == key)
+                {   // 同一客户端在另一线程上刚刚占用
+                    return &candidate;
+                }
+            }
+            if (candidate.sessions.load(std::memory_order_acquire) != 0)
+            {
+                continue;
+            }
+            if (const auto seen = candidate.seen.load(std::memory_order_relaxed); seen < oldest)
+            {
+                oldest = seen;
+                victim = &candidate;
+                victim_key = current;
+            }
+        }
+
+        if (!victim || !victim->key.compare_exchange_strong(victim_key, key, std::memory_order_acq_rel))
+        {
+            return nullptr;
+        }
+        victim->seen.store(time, std::memory_order_relaxed);
+        victim->connect.store(0, std::memory_order_relaxed);
+        victim->bytes.reset();
+        return victim;
+    }
+
+    /**
+     * @brief 地址指纹
+     * @details IPv4 映射的 IPv6 地址与 IPv4 取同一指纹；结果经 64 位混合，0 保留给空位。
+     */
+    std::uint64_t quota::fingerprint(const net::ip::address &client) noexcept
+    {
+        std::uint64_t high = 0;
+        std::uint64_t low = 0;
+        if (client.is_v4() || (client.is_v6() && client.to_v6().is_v4_mapped()))
+        {
+            const auto v4 = client.is_v4() ? client.to_v4() : net::ip::make_address_v4(net::ip::v4_mapped, client.to_v6());
+            low = 0xffff00000000ull | v4.to_uint();
+        }
+        else
+        {
+            const auto bytes = client.to_v6().to_bytes();
+            std::memcpy(&high, bytes.data(), 8);
+            std::memcpy(&low, bytes.data() + 8, 8);
+        }
+
+        std::uint64_t hash = high * 0x9e3779b97f4a7c15ull ^ low;
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ull;
+        hash ^= hash >> 33;
+        return hash == 0 ? 1 : hash;
+    }
+}
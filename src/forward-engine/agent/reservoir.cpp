@@ -0,0 +1,152 @@
+#include <agent/reservoir.hpp>
+#include <utility>
+
+namespace ngx::agent
+{
+    reservoir::lease::lease(reservoir *owner, const std::size_t index) noexcept
+        : owner_(owner), index_(index)
+    {
+    }
+
+    reservoir::lease::lease(lease &&other) noexcept
+        : owner_(std::exchange(other.owner_, nullptr)), index_(other.index_)
+    {
+    }
+
+    reservoir::lease &reservoir::lease::operator=(lease &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            owner_ = std::exchange(other.owner_, nullptr);
+            index_ = other.index_;
+        }
+        return *this;
+    }
+
+    reservoir::lease::~lease()
+    {
+        reset();
+    }
+
+    reservoir::lease::operator bool() const noexcept
+    {
+        return owner_ != nullptr;
+    }
+
+    /**
+     * @brief 上行（客户端 -> 上游）方向使用的半个槽位
+     */
+    reservoir::buffer_type reservoir::lease::left() const
+    {
+        return owner_->half(index_ * 2);
+    }
+
+    /**
+     * @brief 下行（上游 -> 客户端）方向使用的半个槽位
+     */
+    reservoir::buffer_type reservoir::lease::right() const
+    {
+        return owner_->half(index_ * 2 + 1);
+    }
+
+    void reservoir::lease::reset() noexcept
+    {
+        if (owner_)
+        {
+            owner_->release(index_);
+            owner_ = nullptr;
+        }
+    }
+
+    /**
+     * @brief 构造缓冲池
+     * @param ioc 所属 `io_context`（注册缓冲区需要它的 io_uring 实例）
+     * @param slots 槽位数量，为 0 时缓冲池不提供任何槽位
+     * @details io_uring 后端下注册失败（例如 `RLIMIT_MEMLOCK` 不足）时不会抛出，
+     * 而是不再提供任何槽位，会话全部退回自带缓冲区。
+     */
+    reservoir::reservoir([[maybe_unused]] net::io_context &ioc, const std::size_t slots)
+    {
+        if (slots == 0)
+        {
+            return;
+        }
+
+        memory_ = std::make_unique<std::byte[]>(slots * slot_size);
+        halves_.reserve(slots * 2);
+        free_.reserve(slots);
+
+        constexpr std::size_t half_size = slot_size / 2;
+        for (std::size_t i = 0; i < slots * 2; ++i)
+        {
+            halves_.emplace_back(memory_.get() + i * half_size, half_size);
+        }
+
+        for (std::size_t i = slots; i > 0; --i)
+        {
+            free_.push_back(static_cast<std::uint32_t>(i - 1));
+        }
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+        try
+        {
+            registration_.emplace(net::register_buffers(ioc, halves_));
+        }
+        catch (const boost::system::system_error &)
+        {
+            registration_.reset();
+            free_.clear();
+        }
+#endif
+    }
+
+    /**
+     * @brief 租用一个槽位
+     * @return 槽位租约；缓冲池耗尽时返回空租约
+     */
+    reservoir::lease reservoir::acquire()
+    {
+        std::lock_guard lock(mutex_);
+        if (free_.empty())
+        {
+            return {};
+        }
+        const auto index = free_.back();
+        free_.pop_back();
+        return lease(this, index);
+    }
+
+    /**
+     * @brief 缓冲区是否已注册给内核（仅 io_uring 后端可能为 `true`）
+     */
+    bool reservoir::registered() const noexcept
+    {
+#if defined(BOOST_ASIO_HAS_IO_URING)
+        return registration_.has_value();
+#else
+        return false;
+#endif
+    }
+
+    std::size_t reservoir::capacity() const noexcept
+    {
+        return halves_.size() / 2;
+    }
+
+    void reservoir::release(const std::size_t index) noexcept
+    {
+        std::lock_guard lock(mutex_);
+        free_.push_back(static_cast<std::uint32_t>(index));
+    }
+
+    reservoir::buffer_type reservoir::half(const std::size_t index) const
+    {
+#if defined(BOOST_ASIO_HAS_IO_URING)
+        // 注册失败时不会发出任何租约，这里一定已注册
+        return (*registration_)[index];
+#else
+        return halves_[index];
+#endif
+    }
+}
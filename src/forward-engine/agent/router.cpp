@@ -0,0 +1,291 @@
+#include <agent/router.hpp>
+#include <algorithm>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        [[nodiscard]] constexpr char fold(const char c) noexcept
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        /**
+         * @brief 比较已小写的标签与任意大小写的查询标签
+         * @return 小于、等于、大于零分别表示 `lower` 排在 `query` 之前、相同、之后
+         */
+        [[nodiscard]] int compare_folded(const std::string_view lower, const std::string_view query) noexcept
+        {
+            const auto length = std::min(lower.size(), query.size());
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                const auto l = static_cast<unsigned char>(lower[i]);
+                const auto r = static_cast<unsigned char>(fold(query[i]));
+                if (l != r)
+                {
+                    return l < r ? -1 : 1;
+                }
+            }
+            if (lower.size() == query.size())
+            {
+                return 0;
+            }
+            return lower.size() < query.size() ? -1 : 1;
+        }
+    }
+
+    /**
+     * @brief 去掉主机名中的端口与结尾的点
+     * @details `example.com:8080` → `example.com`，`[::1]:8080` → `::1`，`example.com.` → `example.com`；
+     * 不带方括号的 IPv6 字面量（含多个冒号）原样返回。
+     */
+    std::string_view router::normalize(std::string_view host) noexcept
+    {
+        if (host.starts_with('['))
+        {
+            const auto close = host.find(']');
+            return close == std::string_view::npos ? std::string_view{} : host.substr(1, close - 1);
+        }
+        if (const auto colon = host.find(':'); colon != std::string_view::npos && host.find(':', colon + 1) == std::string_view::npos)
+        {
+            host = host.substr(0, colon);
+        }
+        if (host.ends_with('.'))
+        {
+            host.remove_suffix(1);
+        }
+        return host;
+    }
+
+    /**
+     * @brief 添加一条路由
+     * @param host 主机：`example.com`、`*.example.com`（任意层子域名，不含自身）或 `*`（任意主机）
+     * @param prefix 路径前缀，空表示该主机下的全部路径
+     * @param value 命中时 `find` 返回的值
+     * @return 主机格式无效时为 `false`，路由表不变；同一主机与前缀重复添加时以后者为准
+     */
+    bool router::insert(std::string_view host, const std::string_view prefix, const std::uint32_t value)
+    {
+        host = normalize(host);
+        if (host.empty())
+        {
+            return false;
+        }
+
+        std::uint32_t node = 0;
+        bool wildcard = false;
+        if (host == "*")
+        {
+            wildcard = true;
+            host = {};
+        }
+        else
+        {
+            if (host.starts_with("*."))
+            {
+                wildcard = true;
+                host.remove_prefix(2);
+            }
+            // 先整体校验，避免留下半条路径
+            if (host.empty() || host.starts_with('.') || host.find("..") != std::string_view::npos || host.find('*') != std::string_view::npos)
+            {
+                return false;
+            }
+        }
+
+        while (!host.empty())
+        {
+            const auto dot = host.rfind('.');
+            node = descend(node, dot == std::string_view::npos ? host : host.substr(dot + 1));
+            host = dot == std::string_view::npos ? std::string_view{} : host.substr(0, dot);
+        }
+
+        const auto root = wildcard ? attach(hosts_[node].wildcard) : attach(hosts_[node].exact);
+        assign(root, prefix, value);
+        return true;
+    }
+
+    /**
+     * @brief 查找路由
+     * @param host 请求的主机，可以带端口，忽略大小写
+     * @param path 请求路径（不含查询串）
+     * @return 命中的值，未命中为 `npos`
+     */
+    std::uint32_t router::find(std::string_view host, const std::string_view path) const noexcept
+    {
+        host = normalize(host);
+        if (host.empty())
+        {
+            return npos;
+        }
+
+        // 由顶级域名往下走，沿途记下最深的通配入口；通配要求其后至少还剩一个标签
+        std::uint32_t candidate = hosts_.front().wildcard;
+        std::uint32_t node = 0;
+        while (true)
+        {
+            const auto dot = host.rfind('.');
+            node = child(node, dot == std::string_view::npos ? host : host.substr(dot + 1));
+            if (node == npos)
+            {
+                break;
+            }
+            if (dot == std::string_view::npos)
+            {
+                if (hosts_[node].exact != npos)
+                {
+                    return longest(hosts_[node].exact, path);
+                }
+                break;
+            }
+            host = host.substr(0, dot);
+            if (hosts_[node].wildcard != npos)
+            {
+                candidate = hosts_[node].wildcard;
+            }
+        }
+        return candidate == npos ? npos : longest(candidate, path);
+    }
+
+    /**
+     * @brief 取（必要时创建）标签对应的子节点
+     */
+    std::uint32_t router::descend(const std::uint32_t parent, const std::string_view label)
+    {
+        if (const auto existing = child(parent, label); existing != npos)
+        {
+            return existing;
+        }
+
+        host_node created;
+        created.label.reserve(label.size());
+        for (const auto c : label)
+        {
+            created.label.push_back(fold(c));
+        }
+        const auto index = static_cast<std::uint32_t>(hosts_.size());
+        auto &children = hosts_[parent].children;
+        const auto it = std::ranges::lower_bound(children, created.label, {}, [this](const std::uint32_t item) -> const std::string &
+        {
+            return hosts_[item].label;
+        });
+        children.insert(it, index);
+        hosts_.push_back(std::move(created));
+        return index;
+    }
+
+    std::uint32_t router::child(const std::uint32_t parent, const std::string_view label) const noexcept
+    {
+        const auto &children = hosts_[parent].children;
+        std::size_t low = 0;
+        std::size_t high = children.size();
+        while (low < high)
+        {
+            const auto middle = low + (high - low) / 2;
+            const auto order = compare_folded(hosts_[children[middle]].label, label);
+            if (order == 0)
+            {
+                return children[middle];
+            }
+            if (order < 0)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        return npos;
+    }
+
+    /**
+     * @brief 取（必要时创建）主机入口的路径树根
+     */
+    std::uint32_t router::attach(std::uint32_t &root)
+    {
+        if (root == npos)
+        {
+            root = static_cast<std::uint32_t>(paths_.size());
+            paths_.emplace_back();
+        }
+        return root;
+    }
+
+    /**
+     * @brief 在路径树中插入前缀，必要时拆分已有的边
+     */
+    void router::assign(std::uint32_t node, std::string_view prefix, const std::uint32_t value)
+    {
+        const auto first_byte = [this](const std::uint32_t item)
+        {
+            return static_cast<unsigned char>(paths_[item].edge.front());
+        };
+
+        while (!prefix.empty())
+        {
+            const auto head = static_cast<unsigned char>(prefix.front());
+            auto &children = paths_[node].children;
+            const auto it = std::ranges::lower_bound(children, head, {}, first_byte);
+            const auto position = it - children.begin();
+            if (it == children.end() || first_byte(*it) != head)
+            {
+                path_node leaf;
+                leaf.edge.assign(prefix);
+                leaf.value = value;
+                children.insert(it, static_cast<std::uint32_t>(paths_.size()));
+                paths_.push_back(std::move(leaf));
+                return;
+            }
+
+            const auto next = *it;
+            const std::string_view edge = paths_[next].edge;
+            const auto common = static_cast<std::size_t>(std::ranges::mismatch(edge, prefix).in1 - edge.begin());
+            if (common < edge.size())
+            {   // 拆分：中间节点接管公共部分，原节点保留剩余部分；首字节不变，父节点中的次序不变
+                path_node middle;
+                middle.edge.assign(edge.substr(0, common));
+                middle.children.push_back(next);
+                paths_[next].edge.erase(0, common);
+                const auto index = static_cast<std::uint32_t>(paths_.size());
+                paths_.push_back(std::move(middle));
+                paths_[node].children[position] = index;
+                node = index;
+            }
+            else
+            {
+                node = next;
+            }
+            prefix.remove_prefix(common);
+        }
+        paths_[node].value = value;
+    }
+
+    /**
+     * @brief 路径树上的最长前缀匹配
+     */
+    std::uint32_t router::longest(std::uint32_t node, std::string_view path) const noexcept
+    {
+        std::uint32_t best = paths_[node].value;
+        while (!path.empty())
+        {
+            const auto head = static_cast<unsigned char>(path.front());
+            const auto &children = paths_[node].children;
+            const auto it = std::ranges::lower_bound(children, head, {}, [this](const std::uint32_t item)
+            {
+                return static_cast<unsigned char>(paths_[item].edge.front());
+            });
+            if (it == children.end() || !path.starts_with(paths_[*it].edge))
+            {
+                break;
+            }
+            node = *it;
+            path.remove_prefix(paths_[node].edge.size());
+            if (paths_[node].value != npos)
+            {
+                best = paths_[node].value;
+            }
+        }
+        return best;
+    }
+}
@@ -0,0 +1,169 @@
+#include <agent/shaper.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        constexpr std::size_t quantum = 4096;  // 单次读取的最小授权，避免令牌不足时碎片化读取
+        constexpr std::size_t shallow = 16384; // 桶深下限，保证桶满时至少能授权一个最小单元
+    }
+
+    shaper::rate::rate(const std::uint64_t bytes_per_second, const std::chrono::nanoseconds depth) noexcept
+        : bytes(bytes_per_second)
+    {
+        if (bytes != 0)
+        {
+            const auto seconds = std::chrono::duration<double>(depth).count();
+            const auto size = std::max(static_cast<std::uint64_t>(static_cast<double>(bytes) * seconds), std::uint64_t{shallow});
+            tolerance = cost(size);
+        }
+    }
+
+    /**
+     * @brief 当前可以转发的字节数
+     */
+    std::size_t shaper::bucket::allowance(const rate &limit, const std::int64_t now) const noexcept
+    {
+        if (limit.bytes == 0)
+        {
+            return std::numeric_limits<std::size_t>::max();
+        }
+        const auto slack = now + limit.tolerance - std::max(arrival_.load(std::memory_order_relaxed), now);
+        if (slack <= 0)
+        {
+            return 0;
+        }
+        return static_cast<std::size_t>(static_cast<double>(slack) * static_cast<double>(limit.bytes) / 1e9);
+    }
+
+    /**
+     * @brief 攒够 `bytes` 字节还需等待的时长（纳秒）
+     */
+    std::int64_t shaper::bucket::delay(const rate &limit, const std::size_t bytes, const std::int64_t now) const noexcept
+    {
+        if (limit.bytes == 0)
+        {
+            return 0;
+        }
+        const auto arrival = std::max(arrival_.load(std::memory_order_relaxed), now) + limit.cost(bytes);
+        return std::max<std::int64_t>(arrival - now - limit.tolerance, 0);
+    }
+
+    /**
+     * @brief 扣除已转发的字节
+     * @details 多个会话并发扣除共享桶时可能略微透支，透支部分在后续补充中归还，长期速率不受影响。
+     */
+    void shaper::bucket::charge(const rate &limit, const std::size_t bytes, const std::int64_t now) noexcept
+    {
+        if (limit.bytes == 0 || bytes == 0)
+        {
+            return;
+        }
+        const auto cost = limit.cost(bytes);
+        auto expected = arrival_.load(std::memory_order_relaxed);
+        while (!arrival_.compare_exchange_weak(expected, std::max(expected, now) + cost, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * @brief 构造会话通道
+     * @param owner 所属整形器，为空时只有客户端层级
+     * @param client 客户端层级（`quota::pass::level`），未限制时为空
+     */
+    shaper::lane::lane(const shaper *owner, const level client) noexcept
+    {
+        const auto add = [this](const level entry)
+        {
+            if (entry.meter && entry.limit && entry.limit->bytes != 0)
+            {
+                levels_[count_++] = entry;
+            }
+        };
+
+        if (owner)
+        {
+            add(owner->global_);
+            add(level{&owner->listener_, &owner->listener_rate_});
+            own_rate_ = owner->session_rate_;
+            tick_ = owner->tick_;
+        }
+        add(client);
+    }
+
+    /**
+     * @brief 本次读取可以授权的字节数
+     * @param want 缓冲区大小
+     * @return 各层级余量与 `want` 的最小值；余量不足一个最小单元时返回 0，调用方应等到 `wake` 再试
+     */
+    std::size_t shaper::lane::grant(const std::size_t want) const noexcept
+    {
+        const auto time = now();
+        std::size_t granted = std::min(want, own_.allowance(own_rate_, time));
+        for (std::size_t i = 0; i < count_ && granted != 0; ++i)
+        {
+            granted = std::min(granted, levels_[i].meter->allowance(*levels_[i].limit, time));
+        }
+        return granted < std::min(want, quantum) ? 0 : granted;
+    }
+
+    /**
+     * @brief 下次可以授权的时刻
+     * @details 取各层级攒够一个最小单元所需时间的最大值，再向上对齐到刻度，
+     * 使大量等待中的会话集中在同一时刻被唤醒。
+     */
+    std::chrono::steady_clock::time_point shaper::lane::wake(const std::size_t want) const noexcept
+    {
+        const auto time = now();
+        const auto unit = std::min(want, quantum);
+        std::int64_t wait = own_.delay(own_rate_, unit, time);
+        for (std::size_t i = 0; i < count_; ++i)
+        {
+            wait = std::max(wait, levels_[i].meter->delay(*levels_[i].limit, unit, time));
+        }
+        const auto due = (time + std::max<std::int64_t>(wait, 1) + tick_ - 1) / tick_ * tick_;
+        return std::chrono::steady_clock::time_point(
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(due)));
+    }
+
+    /**
+     * @brief 逐级扣除已转发的字节
+     */
+    void shaper::lane::charge(const std::size_t bytes) noexcept
+    {
+        const auto time = now();
+        own_.charge(own_rate_, bytes, time);
+        for (std::size_t i = 0; i < count_; ++i)
+        {
+            levels_[i].meter->charge(*levels_[i].limit, bytes, time);
+        }
+    }
+
+    /**
+     * @brief 构造不受全局层级限制的整形器
+     * @param opt 整形参数（由 `worker` 持有）
+     */
+    shaper::shaper(const option::shaping_option &opt)
+        : shaper(opt, level{})
+    {
+    }
+
+    /**
+     * @brief 构造整形器
+     * @param opt 整形参数（由 `worker` 持有），其中的 `global` 只用于调用方构造 `budget`
+     * @param global 全局层级（由调用方持有），只被引用，不会被修改；为空时不限制全局带宽
+     */
+    shaper::shaper(const option::shaping_option &opt, const level global)
+        : global_(global), listener_rate_(opt.listener, opt.burst), session_rate_(opt.session, opt.burst),
+          tick_(std::chrono::duration_cast<std::chrono::nanoseconds>(std::max(opt.tick, std::chrono::milliseconds(1))).count())
+    {
+    }
+
+    std::int64_t shaper::now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
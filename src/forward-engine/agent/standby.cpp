@@ -0,0 +1,339 @@
+#include <agent/standby.hpp>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <variant>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+
+namespace ngx::agent
+{
+    namespace
+    {
+        /**
+         * @brief 补充与收缩的检查周期
+         */
+        constexpr auto check_period = std::chrono::seconds(1);
+
+        constexpr auto backoff_initial = std::chrono::seconds(1);
+        constexpr auto backoff_ceiling = std::chrono::seconds(30);
+    }
+
+    /**
+     * @brief 构造连接池
+     * @param ioc 连接与决策协程所在的 `io_context`
+     * @param opt 运行参数（读取 `ingress` 与 `multiplex`、`obscura` 节点），生命周期须长于连接池
+     */
+    standby::standby(net::io_context &ioc, const option &opt)
+        : ioc_(ioc), option_(opt), strand_(net::make_strand(ioc)), wake_(strand_)
+    {
+    }
+
+    /**
+     * @brief 创建 TLS 上下文并开始补充连接
+     */
+    void standby::start()
+    {
+        const auto &config = option_.ingress;
+
+        ssl_ctx_ = std::make_shared<ssl::context>(ssl::context::tls_client);
+        SSL_CTX_set_min_proto_version(ssl_ctx_->native_handle(), TLS1_2_VERSION);
+        if (config.verify)
+        {
+            if (config.ca.empty())
+            {
+                ssl_ctx_->set_default_verify_paths();
+            }
+            else
+            {
+                ssl_ctx_->load_verify_file(config.ca);
+            }
+            ssl_ctx_->set_verify_mode(ssl::verify_peer);
+            ssl_ctx_->set_verify_callback(ssl::host_name_verification(config.sni.empty() ? config.host : config.sni));
+        }
+        else
+        {
+            ssl_ctx_->set_verify_mode(ssl::verify_none);
+        }
+        resumption_.install(*ssl_ctx_);
+
+        net::co_spawn(strand_, supervise(), net::detached);
+    }
+
+    /**
+     * @brief 中止所有连接并停止补充
+     */
+    void standby::stop()
+    {
+        std::vector<std::shared_ptr<channel>> closing;
+        {
+            std::lock_guard lock(mutex_);
+            stopped_ = true;
+            closing.swap(channels_);
+        }
+        for (const auto &item : closing)
+        {
+            retire(item);
+        }
+        nudge();
+    }
+
+    /**
+     * @brief 中止一条连接
+     * @details 连接的多路复用协程在它自己的 strand 上收发，关闭 socket 必须投递到同一 strand，不能跨线程直接关闭。
+     */
+    void standby::retire(const std::shared_ptr<channel> &item)
+    {
+        net::post(item->strand, [proto = item->proto]
+        {
+            proto->abort();
+        });
+    }
+
+    /**
+     * @brief 取流数最少的可用连接
+     * @return 没有可用连接时为空
+     * @details 取走后若池中不再有空闲备用，通知后台补充一条，下一条新流仍然不需要等待握手。
+     */
+    std::shared_ptr<standby::channel> standby::acquire()
+    {
+        std::lock_guard lock(mutex_);
+        std::shared_ptr<channel> best;
+        for (const auto &item : channels_)
+        {
+            if (item->mux->available() && (!best || item->mux->load() < best->mux->load()))
+            {
+                best = item;
+            }
+        }
+
+        const bool spare = std::ranges::any_of(channels_, [&best](const std::shared_ptr<channel> &item)
+        {
+            return item != best && item->mux->load() == 0;
+        });
+        if (!spare)
+        {
+            nudge();
+        }
+
+        if (best)
+        {   // 流在 strand 上登记之前 `load` 仍为 0，刷新空闲时间以免它被当作空闲连接收缩
+            best->idle_since = std::chrono::steady_clock::now();
+        }
+        return best;
+    }
+
+    std::size_t standby::established()
+    {
+        std::lock_guard lock(mutex_);
+        return static_cast<std::size_t>(std::ranges::count_if(channels_, [](const std::shared_ptr<channel> &item)
+        {
+            return item->mux->available();
+        }));
+    }
+
+    /**
+     * @brief 决策协程：按周期或被 `nudge` 唤醒后调整连接数
+     */
+    net::awaitable<void> standby::supervise()
+    {
+        boost::system::error_code ec;
+        while (true)
+        {
+            if (!pending_)
+            {
+                wake_.expires_after(check_period);
+                co_await wake_.async_wait(net::redirect_error(net::use_awaitable, ec));
+            }
+            pending_ = false;
+
+            {
+                std::lock_guard lock(mutex_);
+                if (stopped_)
+                {
+                    co_return;
+                }
+            }
+            reconcile();
+        }
+    }
+
+    /**
+     * @brief 根据当前连接与负载补充或收缩
+     * @details 每次最多关闭一条空闲连接；补充时先补足下限，之后只在没有空闲备用时补一条。
+     */
+    void standby::reconcile()
+    {
+        const auto &config = option_.ingress;
+        const auto now = std::chrono::steady_clock::now();
+
+        std::size_t want = 0;
+        std::shared_ptr<channel> retired;
+        {
+            std::lock_guard lock(mutex_);
+            std::size_t spare = 0;
+            for (const auto &item : channels_)
+            {
+                if (item->mux->load() == 0)
+                {
+                    ++spare;
+                }
+                else
+                {
+                    item->idle_since = now;
+                }
+            }
+
+            if (channels_.size() > config.min && spare > 1)
+            {
+                const auto it = std::ranges::find_if(channels_, [&](const std::shared_ptr<channel> &item)
+                {
+                    return item->mux->load() == 0 && now - item->idle_since >= config.idle;
+                });
+                if (it != channels_.end())
+                {
+                    retired = std::move(*it);
+                    channels_.erase(it);
+                    --spare;
+                }
+            }
+
+            const std::size_t total = channels_.size() + dialing_;
+            if (total < config.min)
+            {
+                want = config.min - total;
+            }
+            else if (spare == 0 && dialing_ == 0 && total < config.max)
+            {
+                want = 1;
+            }
+            if (now < retry_)
+            {
+                want = 0;
+            }
+            dialing_ += want;
+        }
+
+        if (retired)
+        {   // 已移出池，不会再被取用；中止后它的 `grow` 协程随 `run` 结束
+            retire(retired);
+        }
+        for (std::size_t i = 0; i < want; ++i)
+        {
+            net::co_spawn(ioc_, grow(), net::detached);
+        }
+    }
+
+    /**
+     * @brief 请求决策协程尽快检查一次
+     * @note 可在任意线程调用
+     */
+    void standby::nudge()
+    {
+        net::post(strand_, [this]
+        {
+            pending_ = true;
+            wake_.cancel();
+        });
+    }
+
+    /**
+     * @brief 建立一条连接，放入池中运行直到断开
+     */
+    net::awaitable<void> standby::grow()
+    {
+        std::shared_ptr<channel> current;
+        try
+        {
+            current = co_await dial();
+        }
+        catch (const std::exception &)
+        {
+            // 远端不可达或握手失败，下面退避
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            --dialing_;
+            if (!current)
+            {
+                backoff_ = std::clamp(backoff_ * 2, backoff_initial, backoff_ceiling);
+                retry_ = std::chrono::steady_clock::now() + backoff_;
+                co_return;
+            }
+            backoff_ = std::chrono::seconds(0);
+            if (stopped_)
+            {
+                current->proto->abort();
+                co_return;
+            }
+            current->idle_since = std::chrono::steady_clock::now();
+            channels_.push_back(current);
+        }
+
+        try
+        {
+            co_await net::co_spawn(current->strand, current->mux->run(), net::use_awaitable);
+        }
+        catch (const std::exception &)
+        {
+            // 连接异常结束或保活超时，下面移出池
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            std::erase(channels_, current);
+        }
+        retire(current); // 流协程可能仍在 strand 上收尾
+        nudge();
+    }
+
+    /**
+     * @brief 建立一条多路复用 obscura 连接
+     * @details 解析、连接、TLS 握手与 websocket 升级整体受 `timeout.connect` 限制（与会话连接阶段的超时相同），
+     * 远端不响应时不会让补充协程无限期挂起。
+     * @throws 连接、TLS 握手或升级失败，或超过时限时抛出
+     */
+    net::awaitable<std::shared_ptr<standby::channel>> standby::dial()
+    {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        const auto limit = option_.timeout.connect;
+        if (limit.count() <= 0)
+        {
+            co_return co_await establish();
+        }
+
+        net::steady_timer deadline(co_await net::this_coro::executor, limit);
+        auto result = co_await (establish() || deadline.async_wait(net::use_awaitable));
+        if (result.index() == 1)
+        {
+            throw boost::system::system_error(net::error::timed_out);
+        }
+        co_return std::get<0>(std::move(result));
+    }
+
+    /**
+     * @brief 连接远端并完成握手
+     */
+    net::awaitable<std::shared_ptr<standby::channel>> standby::establish()
+    {
+        const auto &config = option_.ingress;
+        auto executor = co_await net::this_coro::executor;
+
+        tcp::resolver resolver(executor);
+        const auto endpoints = co_await resolver.async_resolve(config.host, std::to_string(config.port), net::use_awaitable);
+
+        tcp::socket socket(executor);
+        co_await net::async_connect(socket, endpoints, net::use_awaitable);
+        socket.set_option(tcp::no_delay(true));
+
+        auto proto = std::make_shared<obscura<tcp>>(std::move(socket), ssl_ctx_, role::client);
+        co_await proto->handshake(config.sni.empty() ? config.host : config.sni, config.path);
+        proto->tune(option_.obscura.write_buffer, option_.obscura.message_max);
+
+        auto mux = std::make_shared<multiplex>(proto, option_.multiplex);
+        mux->heartbeat(config.keepalive);
+        co_return std::make_shared<channel>(channel{std::move(proto), std::move(mux), net::make_strand(ioc_),
+            std::chrono::steady_clock::now()});
+    }
+}
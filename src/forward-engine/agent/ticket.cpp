@@ -0,0 +1,296 @@
+#include <agent/ticket.hpp>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <openssl/rand.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/tls1.h>
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    #include <openssl/core_names.h>
+    #include <openssl/params.h>
+#else
+    #include <openssl/hmac.h>
+#endif
+
+namespace ngx::agent
+{
+    namespace
+    {
+        /**
+         * @brief 在 `SSL_CTX` 上挂载对象指针的扩展数据索引
+         */
+        int keyring_index()
+        {
+            static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+
+        int resumption_index()
+        {
+            static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+            return index;
+        }
+
+        keyring::key generate()
+        {
+            keyring::key result;
+            if (RAND_bytes(result.name.data(), static_cast<int>(result.name.size())) != 1
+                || RAND_bytes(result.cipher.data(), static_cast<int>(result.cipher.size())) != 1
+                || RAND_bytes(result.mac.data(), static_cast<int>(result.mac.size())) != 1)
+            {
+                throw std::runtime_error("RAND_bytes failed while generating ticket key");
+            }
+            return result;
+        }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        using mac_context = EVP_MAC_CTX;
+
+        bool init_mac(mac_context *mac, keyring::key &key)
+        {
+            char digest[] = "SHA256";
+            const OSSL_PARAM params[] = {
+                OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.mac.data(), key.mac.size()),
+                OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+                OSSL_PARAM_construct_end()
+            };
+            return EVP_MAC_CTX_set_params(mac, params) == 1;
+        }
+#else
+        using mac_context = HMAC_CTX;
+
+        bool init_mac(mac_context *mac, keyring::key &key)
+        {
+            return HMAC_Init_ex(mac, key.mac.data(), static_cast<int>(key.mac.size()), EVP_sha256(), nullptr) == 1;
+        }
+#endif
+
+        /**
+         * @brief OpenSSL 票据密钥回调
+         * @return 签发：1 成功；解密：0 未找到密钥（走完整握手），1 成功，2 成功但需换发票据，-1 出错
+         */
+        int ticket_callback(SSL *handle, unsigned char *name, unsigned char *iv, EVP_CIPHER_CTX *cipher,
+            mac_context *mac, const int encrypt)
+        {
+            auto *ring = static_cast<keyring *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(handle), keyring_index()));
+            if (!ring)
+            {
+                return -1;
+            }
+
+            if (encrypt)
+            {
+                auto key = ring->current();
+                if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1)
+                {
+                    return -1;
+                }
+                std::memcpy(name, key.name.data(), key.name.size());
+                if (EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.cipher.data(), iv) != 1 || !init_mac(mac, key))
+                {
+                    return -1;
+                }
+                return 1;
+            }
+
+            keyring::key key;
+            bool fresh = false;
+            if (!ring->find(name, key, fresh))
+            {
+                return 0;
+            }
+            if (EVP_DecryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.cipher.data(), iv) != 1 || !init_mac(mac, key))
+            {
+                return -1;
+            }
+            // TLS 1.3 票据只用一次，恢复后必须换发，否则客户端下次只能完整握手
+            return fresh && SSL_version(handle) < TLS1_3_VERSION ? 1 : 2;
+        }
+    }
+
+    /**
+     * @brief 配置服务端 TLS 版本范围
+     * @param context 由 `ssl::context::tls_server`（版本自适应方法）创建的上下文
+     */
+    void modernize(ssl::context &context)
+    {
+        SSL_CTX *handle = context.native_handle();
+        SSL_CTX_set_min_proto_version(handle, TLS1_2_VERSION);
+        SSL_CTX_set_max_proto_version(handle, 0); // 不设上限，可用时协商 TLS 1.3
+        SSL_CTX_clear_options(handle, SSL_OP_NO_TICKET);
+    }
+
+    keyring::keyring(const std::size_t keep)
+        : keep_(std::max<std::size_t>(keep, 1))
+    {
+        keys_.push_front(generate());
+    }
+
+    /**
+     * @brief 把密钥环安装到服务端上下文
+     * @details 票据状态完全由票据自身携带，因此关闭服务端会话缓存；TLS 1.3 下每次握手签发 2 张票据，
+     * 客户端可以各用一次。
+     * @note 密钥环的生命周期必须覆盖上下文。
+     */
+    void keyring::install(ssl::context &context)
+    {
+        SSL_CTX *handle = context.native_handle();
+        SSL_CTX_set_ex_data(handle, keyring_index(), this);
+        SSL_CTX_set_session_cache_mode(handle, SSL_SESS_CACHE_OFF);
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+        SSL_CTX_set_num_tickets(handle, 2);
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+        SSL_CTX_set_tlsext_ticket_key_evp_cb(handle, ticket_callback);
+#else
+        SSL_CTX_set_tlsext_ticket_key_cb(handle, ticket_callback);
+#endif
+    }
+
+    /**
+     * @brief 轮换密钥：生成新的签发密钥，超出保留数量的旧密钥被丢弃
+     */
+    void keyring::rotate()
+    {
+        auto fresh = generate();
+        std::lock_guard lock(mutex_);
+        keys_.push_front(fresh);
+        while (keys_.size() > keep_)
+        {
+            keys_.pop_back();
+        }
+    }
+
+    keyring::key keyring::current()
+    {
+        std::lock_guard lock(mutex_);
+        return keys_.front();
+    }
+
+    bool keyring::find(const unsigned char *name, key &result, bool &fresh)
+    {
+        std::lock_guard lock(mutex_);
+        for (std::size_t i = 0; i < keys_.size(); ++i)
+        {
+            if (std::memcmp(keys_[i].name.data(), name, keys_[i].name.size()) == 0)
+            {
+                result = keys_[i];
+                fresh = i == 0;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    resumption::resumption(const std::size_t capacity)
+        : capacity_(std::max<std::size_t>(capacity, 1))
+    {
+    }
+
+    resumption::~resumption()
+    {
+        for (auto &[host, session] : sessions_)
+        {
+            SSL_SESSION_free(session);
+        }
+    }
+
+    /**
+     * @brief 把会话缓存安装到客户端上下文
+     * @details 由缓存自行管理会话（`SSL_SESS_CACHE_NO_INTERNAL_STORE`），
+     * TLS 1.3 的票据在握手完成后才到达，因此通过新会话回调而不是握手后主动读取来收集。
+     * @note 缓存的生命周期必须覆盖上下文。
+     */
+    void resumption::install(ssl::context &context)
+    {
+        SSL_CTX *handle = context.native_handle();
+        SSL_CTX_set_ex_data(handle, resumption_index(), this);
+        SSL_CTX_set_session_cache_mode(handle, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+        SSL_CTX_sess_set_new_cb(handle, &resumption::on_session);
+    }
+
+    void resumption::resume(SSL *handle, const std::string_view host)
+    {
+        if (host.empty())
+        {
+            return;
+        }
+
+        auto *cache = static_cast<resumption *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(handle), resumption_index()));
+        if (!cache)
+        {
+            return;
+        }
+
+        if (SSL_SESSION *session = cache->take(host))
+        {
+            SSL_set_session(handle, session);
+            SSL_SESSION_free(session);
+        }
+    }
+
+    /**
+     * @brief 新会话回调
+     * @details 缓存保存的是会话副本：连接未发送 close_notify 就被释放时（超时、`abort` 等），
+     * OpenSSL 会把该连接上的会话标记为不可恢复，副本不受影响。
+     * @return 0 表示不接管 `session` 的引用计数
+     */
+    int resumption::on_session(SSL *handle, SSL_SESSION *session)
+    {
+        auto *cache = static_cast<resumption *>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(handle), resumption_index()));
+        const char *host = SSL_get_servername(handle, TLSEXT_NAMETYPE_host_name);
+        if (!cache || !host || SSL_SESSION_is_resumable(session) != 1)
+        {
+            return 0;
+        }
+
+        if (SSL_SESSION *copy = SSL_SESSION_dup(session))
+        {
+            cache->store(host, copy);
+        }
+        return 0;
+    }
+
+    void resumption::store(const std::string_view host, SSL_SESSION *session)
+    {
+        std::lock_guard lock(mutex_);
+        if (const auto it = sessions_.find(std::string(host)); it != sessions_.end())
+        {
+            SSL_SESSION_free(it->second);
+            it->second = session;
+            return;
+        }
+
+        if (sessions_.size() >= capacity_)
+        {   // 容量满时随意淘汰一项，缓存只是优化，丢失只会多一次完整握手
+            SSL_SESSION_free(sessions_.begin()->second);
+            sessions_.erase(sessions_.begin());
+        }
+        sessions_.emplace(host, session);
+    }
+
+    /**
+     * @brief 取出会话
+     * @details TLS 1.3 票据取出即移除（单次使用），TLS 1.2 会话可重复使用，返回一份副本，连接异常关闭时不会连累缓存中的会话。
+     */
+    SSL_SESSION *resumption::take(const std::string_view host)
+    {
+        std::lock_guard lock(mutex_);
+        const auto it = sessions_.find(std::string(host));
+        if (it == sessions_.end())
+        {
+            return nullptr;
+        }
+
+        SSL_SESSION *session = it->second;
+        if (SSL_SESSION_get_protocol_version(session) >= TLS1_3_VERSION)
+        {
+            sessions_.erase(it);
+            return session;
+        }
+
+        return SSL_SESSION_dup(session);
+    }
+}
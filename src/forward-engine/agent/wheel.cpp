@@ -0,0 +1,288 @@
+#include <agent/wheel.hpp>
+#include <algorithm>
+
+namespace ngx::agent
+{
+    wheel::entry::~entry()
+    {
+        if (auto *owner = owner_.load(std::memory_order_acquire))
+        {
+            owner->cancel(*this);
+        }
+    }
+
+    /**
+     * @brief 构造时间轮
+     * @param ioc 驱动刻度定时器的 `io_context`
+     * @param tick 刻度（时间精度），过小会增加空转唤醒，过大会放大超时误差
+     */
+    wheel::wheel(net::io_context &ioc, const std::chrono::milliseconds tick)
+        : timer_(ioc), tick_(std::max(tick, std::chrono::milliseconds(1))), origin_(std::chrono::steady_clock::now())
+    {
+    }
+
+    /**
+     * @brief 析构时间轮
+     * @details 仍挂在轮上的定时项只做解绑，不触发回调；之后它们析构时不会再访问本对象。
+     */
+    wheel::~wheel()
+    {
+        std::lock_guard lock(mutex_);
+        const auto release = [](entry *&head)
+        {
+            for (entry *item = detach(head); item != nullptr;)
+            {
+                entry *next = item->next_;
+                item->prev_ = item->next_ = nullptr;
+                item->head_ = nullptr;
+                item->owner_.store(nullptr, std::memory_order_release);
+                item = next;
+            }
+        };
+
+        for (auto &head : near_)
+        {
+            release(head);
+        }
+        for (auto &level : far_)
+        {
+            for (auto &head : level)
+            {
+                release(head);
+            }
+        }
+    }
+
+    /**
+     * @brief 启动刻度定时器
+     */
+    void wheel::start()
+    {
+        stopped_.store(false, std::memory_order_relaxed);
+        origin_ = std::chrono::steady_clock::now() - tick_ * static_cast<std::int64_t>(now());
+        schedule();
+    }
+
+    /**
+     * @brief 停止刻度定时器，已布防的定时项保持不变
+     * @details 刻度回调可能已经以成功状态排入队列，`cancel` 对它无效，
+     * 因此另设停止标志，回调在重新布防前检查。
+     */
+    void wheel::stop()
+    {
+        stopped_.store(true, std::memory_order_relaxed);
+        timer_.cancel();
+    }
+
+    /**
+     * @brief 布防或改期
+     * @param item 定时项
+     * @param deadline 到期刻度（绝对值，通常为 `now() + ticks(...)`）
+     * @details 已布防的定时项会先从原槽位摘除，整体仍为 O(1)。
+     */
+    void wheel::arm(entry &item, const std::uint64_t deadline)
+    {
+        std::lock_guard lock(mutex_);
+        if (item.owner_.load(std::memory_order_relaxed) == this)
+        {
+            unlink(item);
+        }
+        item.deadline_ = deadline;
+        item.owner_.store(this, std::memory_order_release);
+        place(item);
+    }
+
+    /**
+     * @brief 撤销定时项，未布防时为空操作
+     */
+    void wheel::cancel(entry &item)
+    {
+        std::lock_guard lock(mutex_);
+        if (item.owner_.load(std::memory_order_relaxed) != this)
+        {
+            return;
+        }
+        unlink(item);
+        item.owner_.store(nullptr, std::memory_order_release);
+    }
+
+    /**
+     * @brief 把时长换算成刻度数（向上取整，至少 1 个刻度）
+     */
+    std::uint64_t wheel::ticks(const std::chrono::milliseconds duration) const noexcept
+    {
+        const auto count = (duration.count() + tick_.count() - 1) / tick_.count();
+        return static_cast<std::uint64_t>(std::max<std::int64_t>(count, 1));
+    }
+
+    void wheel::schedule()
+    {
+        timer_.expires_at(origin_ + tick_ * static_cast<std::int64_t>(now()));
+        timer_.async_wait([this](const boost::system::error_code &ec)
+        {
+            if (ec || stopped_.load(std::memory_order_relaxed))
+            {   // 被取消（包括析构）时不能再访问成员
+                return;
+            }
+
+            const auto elapsed = std::chrono::steady_clock::now() - origin_;
+            advance(static_cast<std::uint64_t>(elapsed / tick_));
+            if (!stopped_.load(std::memory_order_relaxed))
+            {   // 到期回调里可能调用了 `stop`
+                schedule();
+            }
+        });
+    }
+
+    /**
+     * @brief 推进到指定刻度（含），并在锁外执行所有到期回调
+     * @details 事件循环卡顿时会一次补齐多个刻度，不会丢失到期项。
+     */
+    void wheel::advance(const std::uint64_t target)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            while (now() <= target)
+            {
+                step();
+            }
+        }
+
+        for (auto &callback : fired_)
+        {
+            if (callback)
+            {
+                callback();
+            }
+        }
+        fired_.clear();
+    }
+
+    /**
+     * @brief 处理当前刻度：必要时级联高层槽位，再触发近端槽位上的全部定时项
+     */
+    void wheel::step()
+    {
+        const std::uint64_t tick = now();
+        const auto index = static_cast<std::size_t>(tick & (near_size - 1));
+
+        if (index == 0)
+        {
+            for (std::size_t level = 0; level < far_levels; ++level)
+            {
+                const auto shift = near_bits + level * far_bits;
+                const auto slot = static_cast<std::size_t>((tick >> shift) & (far_size - 1));
+                cascade(level, slot);
+                if (slot != 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        for (entry *item = detach(near_[index]); item != nullptr;)
+        {
+            entry *next = item->next_;
+            item->prev_ = item->next_ = nullptr;
+            item->head_ = nullptr;
+
+            if (item->deadline_ > tick)
+            {   // 超出时间轮跨度而被截断的定时项，重新放回
+                place(*item);
+            }
+            else
+            {
+                item->owner_.store(nullptr, std::memory_order_release);
+                fired_.push_back(item->callback_);
+            }
+            item = next;
+        }
+
+        current_.store(tick + 1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 按剩余刻度选择槽位
+     * @details 已过期的定时项放进当前槽位，下一次推进即触发；超出总跨度的截断到最高层最远槽位。
+     */
+    void wheel::place(entry &item)
+    {
+        const std::uint64_t current = now();
+        const std::uint64_t deadline = std::max(item.deadline_, current);
+        const std::uint64_t delta = deadline - current;
+
+        if (delta < near_size)
+        {
+            push(near_[deadline & (near_size - 1)], item);
+            return;
+        }
+
+        for (std::size_t level = 0; level < far_levels; ++level)
+        {
+            const auto shift = near_bits + level * far_bits;
+            if (delta < (std::uint64_t{1} << (shift + far_bits)))
+            {
+                push(far_[level][(deadline >> shift) & (far_size - 1)], item);
+                return;
+            }
+        }
+
+        constexpr auto top = near_bits + (far_levels - 1) * far_bits;
+        const std::uint64_t clamped = current + (std::uint64_t{1} << (top + far_bits)) - 1;
+        push(far_[far_levels - 1][(clamped >> top) & (far_size - 1)], item);
+    }
+
+    void wheel::cascade(const std::size_t level, const std::size_t index)
+    {
+        for (entry *item = detach(far_[level][index]); item != nullptr;)
+        {
+            entry *next = item->next_;
+            item->prev_ = item->next_ = nullptr;
+            item->head_ = nullptr;
+            place(*item);
+            item = next;
+        }
+    }
+
+    void wheel::push(entry *&head, entry &item) noexcept
+    {
+        item.prev_ = nullptr;
+        item.next_ = head;
+        item.head_ = &head;
+        if (head)
+        {
+            head->prev_ = &item;
+        }
+        head = &item;
+    }
+
+    void wheel::unlink(entry &item) noexcept
+    {
+        if (item.prev_)
+        {
+            item.prev_->next_ = item.next_;
+        }
+        else if (item.head_)
+        {
+            *item.head_ = item.next_;
+        }
+
+        if (item.next_)
+        {
+            item.next_->prev_ = item.prev_;
+        }
+
+        item.prev_ = item.next_ = nullptr;
+        item.head_ = nullptr;
+    }
+
+    /**
+     * @brief 整条链表摘下，返回原链表头
+     */
+    wheel::entry *wheel::detach(entry *&head) noexcept
+    {
+        entry *first = head;
+        head = nullptr;
+        return first;
+    }
+}
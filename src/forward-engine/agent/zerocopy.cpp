@@ -0,0 +1,290 @@
+#include <agent/zerocopy.hpp>
+#include <algorithm>
+#include <chrono>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) && defined(SO_EE_ORIGIN_ZEROCOPY)
+#define FORWARD_ZEROCOPY 1
+#endif
+#endif
+
+namespace ngx::agent
+{
+    namespace
+    {
+        // 收尾时等待内核释放全部发送块的上限，超时后以 RST 中止连接
+        constexpr auto drain_limit = std::chrono::seconds(1);
+    }
+
+    zerocopy::zerocopy(tcp::socket &socket, const option::zerocopy_option &opt)
+        : socket_(socket), timer_(socket.get_executor()), threshold_(opt.threshold),
+          block_size_(std::max<std::size_t>(opt.block, 1)), blocks_(std::max<std::size_t>(opt.depth, 1))
+    {
+        for (auto &item : blocks_)
+        {
+            item.data = std::make_unique<std::byte[]>(block_size_);
+        }
+        inflight_.reserve(blocks_.size() * 2);
+
+#ifdef FORWARD_ZEROCOPY
+        int one = 1;
+        active_ = ::setsockopt(socket_.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+#endif
+    }
+
+    /**
+     * @brief 析构发送器
+     * @details 发送块随发送器一起释放。仍有块被内核引用时（协程被取消、未经 `drain` 就退出），
+     * 先非阻塞地收取一次通知，仍未释放完则以 RST 中止连接，内核丢弃发送队列后不会再读取这些页面。
+     */
+    zerocopy::~zerocopy()
+    {
+        reap();
+        if (!inflight_.empty())
+        {
+            reset();
+        }
+    }
+
+    /**
+     * @brief 当前平台是否编译了零拷贝发送路径
+     */
+    bool zerocopy::supported() noexcept
+    {
+#ifdef FORWARD_ZEROCOPY
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief 后续发送是否仍会尝试 `MSG_ZEROCOPY`
+     * @details 内核回报退化为拷贝（例如回环地址）后会自动关闭，避免白白付出通知开销。
+     */
+    bool zerocopy::active() const noexcept
+    {
+        return active_;
+    }
+
+    /**
+     * @brief 获取下一个可写入的发送块
+     * @param ec 错误码（socket 被关闭等情况）
+     * @return 发送块缓冲区；若该块仍被内核引用，会等待其释放后再返回
+     */
+    net::awaitable<net::mutable_buffer> zerocopy::acquire(boost::system::error_code &ec)
+    {
+        auto &current = blocks_[cursor_];
+        while (current.remaining != 0)
+        {
+            if (reap())
+            {
+                continue;
+            }
+
+            if (!socket_.is_open())
+            {
+                ec = net::error::bad_descriptor;
+                co_return net::mutable_buffer{};
+            }
+
+            // 错误队列非空时 socket 上报 `EPOLLERR`，对应 `wait_error`；
+            // 登记等待时 reactor 会重新评估就绪状态，上面 `reap` 之后才到达的通知不会丢失
+            co_await socket_.async_wait(tcp::socket::wait_error, net::redirect_error(net::use_awaitable, ec));
+            if (ec)
+            {
+                co_return net::mutable_buffer{};
+            }
+        }
+
+        co_return net::mutable_buffer(current.data.get(), block_size_);
+    }
+
+    /**
+     * @brief 等待内核释放全部在途发送块
+     * @details 关闭 socket 之前调用：正常关闭后内核仍会从这些页面发送剩余数据，
+     * 发送块必须在此之前全部收回。最多等待 `drain_limit`，超时则以 RST 中止连接。
+     */
+    net::awaitable<void> zerocopy::drain()
+    {
+        using namespace boost::asio::experimental::awaitable_operators;
+
+        timer_.expires_after(drain_limit);
+        while (!inflight_.empty())
+        {
+            if (reap())
+            {
+                continue;
+            }
+            if (!socket_.is_open())
+            {
+                break;
+            }
+
+            boost::system::error_code wait_ec;
+            boost::system::error_code timer_ec;
+            const auto result = co_await (
+                socket_.async_wait(tcp::socket::wait_error, net::redirect_error(net::use_awaitable, wait_ec))
+                || timer_.async_wait(net::redirect_error(net::use_awaitable, timer_ec)));
+            if (result.index() == 1 || wait_ec)
+            {   // 超时，或 socket 已出错
+                reap();
+                break;
+            }
+        }
+
+        if (!inflight_.empty())
+        {
+            reset();
+        }
+    }
+
+    /**
+     * @brief 发送最近一次 `acquire` 得到的块中的前 `n` 字节
+     * @param n 要发送的字节数
+     * @param ec 错误码
+     * @details 达到阈值时使用 `MSG_ZEROCOPY`，块会被标记为在途直到内核释放；
+     * 否则走普通写入，返回时块即可复用。无论哪种方式，返回后数据都已全部交给内核。
+     */
+    net::awaitable<void> zerocopy::async_send(const std::size_t n, boost::system::error_code &ec)
+    {
+        const std::size_t index = cursor_;
+        cursor_ = (cursor_ + 1) % blocks_.size();
+
+        auto *data = blocks_[index].data.get();
+        auto token = net::redirect_error(net::use_awaitable, ec);
+
+#ifdef FORWARD_ZEROCOPY
+        if (active_ && n >= threshold_)
+        {
+            std::size_t offset = 0;
+            while (offset < n)
+            {
+                const auto sent = ::send(socket_.native_handle(), data + offset, n - offset,
+                    MSG_ZEROCOPY | MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (sent >= 0)
+                {   // 每次成功的 `MSG_ZEROCOPY` 调用占用一个通知序号
+                    inflight_.push_back({sequence_++, index});
+                    ++blocks_[index].remaining;
+                    offset += static_cast<std::size_t>(sent);
+                    continue;
+                }
+
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    co_await socket_.async_wait(tcp::socket::wait_write, token);
+                    if (ec)
+                    {
+                        co_return;
+                    }
+                    continue;
+                }
+
+                if (errno == ENOBUFS)
+                {   // 通知占用的 optmem 超限：剩余部分退化为普通写入
+                    co_await net::async_write(socket_, net::buffer(data + offset, n - offset), token);
+                    co_return;
+                }
+
+                ec.assign(errno, boost::system::system_category());
+                co_return;
+            }
+            co_return;
+        }
+#endif
+
+        co_await net::async_write(socket_, net::buffer(data, n), token);
+    }
+
+    /**
+     * @brief 以 RST 中止连接
+     * @details `SO_LINGER` 为 0 时关闭会清空发送队列，内核随即解除对发送块页面的引用。
+     */
+    void zerocopy::reset() noexcept
+    {
+        boost::system::error_code ec;
+        if (socket_.is_open())
+        {
+            socket_.set_option(net::socket_base::linger(true, 0), ec);
+            socket_.close(ec);
+        }
+    }
+
+    /**
+     * @brief 非阻塞地读取错误队列中的零拷贝完成通知
+     * @return 是否有发送块被释放
+     */
+    bool zerocopy::reap()
+    {
+#ifdef FORWARD_ZEROCOPY
+        bool progressed = false;
+        while (true)
+        {
+            alignas(cmsghdr) char control[128];
+            msghdr message{};
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+
+            if (::recvmsg(socket_.native_handle(), &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+            {
+                break;
+            }
+
+            for (cmsghdr *cm = CMSG_FIRSTHDR(&message); cm != nullptr; cm = CMSG_NXTHDR(&message, cm))
+            {
+                const bool v4 = cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR;
+                const bool v6 = cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR;
+                if (!v4 && !v6)
+                {
+                    continue;
+                }
+
+                const auto *err = reinterpret_cast<const sock_extended_err *>(CMSG_DATA(cm));
+                if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                {
+                    continue;
+                }
+
+                if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+                {   // 内核实际做了拷贝，继续零拷贝只剩通知开销
+                    active_ = false;
+                }
+
+                release(err->ee_info, err->ee_data);
+                progressed = true;
+            }
+        }
+        return progressed;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief 释放通知区间 `[low, high]` 覆盖的在途发送
+     * @details 通知区间可能乱序到达，因此按序号逐个核销，序号回绕按无符号差值处理。
+     */
+    void zerocopy::release(const std::uint32_t low, const std::uint32_t high)
+    {
+        const std::uint32_t span = high - low;
+        std::erase_if(inflight_, [&](const inflight &item)
+        {
+            if (static_cast<std::uint32_t>(item.sequence - low) > span)
+            {
+                return false;
+            }
+            --blocks_[item.index].remaining;
+            return true;
+        });
+    }
+}
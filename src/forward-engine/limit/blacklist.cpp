@@ -1,5 +1,5 @@
 #include <rule/blacklist.hpp>
-#include <algorithm>
+#include <utility>
 
 
 namespace ngx::limit
@@ -14,18 +14,23 @@ namespace ngx::limit
     {
 
         ips_.clear();
+        ips_.reserve(ips.size());
         for (const auto &ip : ips)
         {
             ips_.insert(ip);
         }
 
         domains_.clear();
+        std::size_t bytes = 0;
         for (const auto &domain : domains)
         {
-            // 存入时统一转小写，方便后续不区分大小写比较
-            std::string d = domain;
-            std::ranges::transform(d, d.begin(), ::tolower);
-            domains_.insert(d);
+            bytes += domain.size();
+        }
+        // 一次预留到位，百万级条目加载时不反复扩容
+        domains_.reserve(domains.size(), bytes);
+        for (const auto &domain : domains)
+        {
+            domains_.insert(domain, 0, true);
         }
     }
 
@@ -38,55 +43,52 @@ namespace ngx::limit
     {
         if (ips_.empty())
             return false;
-        // string_view 转 string 可能会有分配，但在 set find 中 C++20 支持异构查找
-        return ips_.contains(std::string(endpoint_value));
+        // 透明哈希，string_view 直接异构查找，不构造 string
+        return ips_.contains(endpoint_value);
     }
 
+    /**
+     * @brief  检查域名或它的任一上级域名在不在黑名单
+     * @param host_value 要检测的主机名，忽略大小写
+     * @details 策略：从后往前扫描一遍主机名，每到一个标签边界就查一次，
+     * map.baidu.com -> 查 "com" -> 查 "baidu.com" (命中!)
+     */
     bool blacklist::domain(const std::string_view host_value) const
     {
-        if (domains_.empty())
-            return false;
-
-        std::string domain(host_value);
-        std::ranges::transform(domain, domain.begin(), ::tolower);
-
-        // 策略：从后往前剥离域名进行匹配
-        // map.baidu.com -> 查 "map.baidu.com"
-        //               -> 查 "baidu.com" (命中!)
-        //               -> 查 "com"
-
-        std::string_view view = domain;
-        while (true)
+        if (domains_.find(host_value) != rule::npos)
         {
-            // C++20 contains
-            if (domains_.contains(std::string(view)))
-            {
-                return true;
-            }
-
-            // 找下一个点号
-            const auto pos = view.find('.');
-            if (pos == std::string_view::npos)
-            {
-                break;
-            }
-            // 移动 view 到下一个子段，例如 "map.baidu.com" -> "baidu.com"
-            view.remove_prefix(pos + 1);
+            return true;
         }
+        return mapped_ && mapped_->domain(host_value);
+    }
+
+    /**
+     * @brief  检查地址在不在挂载的预编译列表的网段内
+     * @param address_value 解析后的目标地址
+     */
+    bool blacklist::address(const boost::asio::ip::address &address_value) const
+    {
+        return mapped_ && mapped_->address(address_value);
+    }
 
-        return false;
+    /**
+     * @brief  挂载预编译的拦截列表
+     * @param mapped 由 `rule::blocklist::open` 映射的列表，空指针表示卸载
+     */
+    void blacklist::attach(std::shared_ptr<const rule::blocklist> mapped)
+    {
+        mapped_ = std::move(mapped);
     }
-    void blacklist::insert_endpoint(std::string& endpoint_value)
+
+    void blacklist::insert_endpoint(const std::string_view endpoint_value)
     {
         ips_.emplace(endpoint_value);
     }
 
     void blacklist::insert_domain(const std::string_view domain)
     {
-        std::string d(domain);
-        // 强制转小写，确保匹配时不区分大小写
-        std::ranges::transform(d, d.begin(), ::tolower);
-        domains_.emplace(std::move(d));
+        // 存入时统一转小写，匹配时不区分大小写
+        domains_.insert(domain, 0, true);
     }
 
     /**
@@ -97,5 +99,6 @@ namespace ngx::limit
     {
         ips_.clear();
         domains_.clear();
+        mapped_.reset();
     }
 }
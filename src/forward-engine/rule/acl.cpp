@@ -0,0 +1,61 @@
+#include <rule/acl.hpp>
+#include <abnormal.hpp>
+
+namespace ngx::rule
+{
+    /**
+     * @brief 编译访问控制规则
+     * @param rules 规则，按优先级从高到低
+     * @param allow 没有规则命中时是否放行
+     * @throws abnormal::protocol_error 规则格式无效时抛出
+     */
+    void acl::compile(const std::vector<std::string> &rules, const bool allow)
+    {
+        networks_.clear();
+        allows_.clear();
+        fallback_ = allow;
+
+        for (std::uint32_t index = 0; index < rules.size(); ++index)
+        {
+            const std::string_view line = rules[index];
+            const auto space = line.find(' ');
+            const auto verb = line.substr(0, space);
+            auto target = space == std::string_view::npos ? std::string_view{} : line.substr(space + 1);
+            while (target.starts_with(' '))
+            {
+                target.remove_prefix(1);
+            }
+            if (verb != "allow" && verb != "deny")
+            {
+                throw abnormal::protocol_error("Invalid ACL rule: {}", line);
+            }
+            allows_.push_back(verb == "allow");
+
+            if (target == "all")
+            {   // 整个 IPv6 空间，IPv4 映射地址也在其中
+                networks_.insert(address_key{}, address_key{~0ull, ~0ull}, index);
+                continue;
+            }
+            address_key first, last;
+            if (!parse_network(target, first, last))
+            {
+                throw abnormal::protocol_error("Invalid ACL rule: {}", line);
+            }
+            networks_.insert(first, last, index);
+        }
+        networks_.compile();
+    }
+
+    /**
+     * @brief 地址是否放行
+     */
+    bool acl::permit(const net::ip::address &address) const noexcept
+    {
+        if (networks_.empty())
+        {
+            return fallback_;
+        }
+        const auto index = networks_.find(address_key::from(address));
+        return index == npos ? fallback_ : allows_[index];
+    }
+}
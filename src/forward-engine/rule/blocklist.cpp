@@ -0,0 +1,215 @@
+#include <rule/blocklist.hpp>
+#include <abnormal.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace ngx::rule
+{
+    namespace
+    {
+        constexpr char blocklist_magic[8] = {'F', 'E', 'B', 'L', 'O', 'C', 'K', '\0'};
+        constexpr std::uint32_t blocklist_version = 1;
+        constexpr std::uint32_t blocklist_order = 0x01020304;
+
+        static_assert(sizeof(address_key) == 16);
+
+        [[nodiscard]] constexpr std::uint64_t align(const std::uint64_t offset) noexcept
+        {
+            return (offset + 7) & ~std::uint64_t{7};
+        }
+
+        /**
+         * @brief 段是否完整落在文件内且按 8 字节对齐
+         */
+        [[nodiscard]] bool within(const std::uint64_t offset, const std::uint64_t count, const std::uint64_t unit, const std::uint64_t size) noexcept
+        {
+            if (offset % 8 != 0 || offset > size)
+            {
+                return false;
+            }
+            return count <= (size - offset) / unit;
+        }
+    }
+
+    /**
+     * @brief 映射预编译的拦截列表
+     * @param path 由 `compile`（或离线工具）生成的文件
+     * @return 只读的拦截列表
+     * @throws abnormal::protocol_error 文件无法映射、格式或版本不符、段越界时抛出
+     * @note 只校验文件头与各段边界，不逐项检查内容，耗时与列表大小无关；文件内容须来自 `compile`
+     */
+    std::shared_ptr<const blocklist> blocklist::open(const std::string &path)
+    {
+        namespace ipc = boost::interprocess;
+
+        std::shared_ptr<blocklist> result(new blocklist());
+        try
+        {
+            result->file_ = ipc::file_mapping(path.c_str(), ipc::read_only);
+            result->region_ = ipc::mapped_region(result->file_, ipc::read_only);
+        }
+        catch (const ipc::interprocess_exception &e)
+        {
+            throw abnormal::protocol_error("Cannot map blocklist {}: {}", path, e.what());
+        }
+        // 查询是随机访问，关掉预读
+        static_cast<void>(result->region_.advise(ipc::mapped_region::advice_random));
+
+        const auto *base = static_cast<const char *>(result->region_.get_address());
+        const std::uint64_t size = result->region_.get_size();
+        blocklist_header header{};
+        if (size < sizeof(header))
+        {
+            throw abnormal::protocol_error("Blocklist {} is truncated", path);
+        }
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, blocklist_magic, sizeof(blocklist_magic)) != 0 || header.order != blocklist_order)
+        {
+            throw abnormal::protocol_error("Not a blocklist file: {}", path);
+        }
+        if (header.version != blocklist_version)
+        {
+            throw abnormal::protocol_error("Unsupported blocklist version {} in {}", header.version, path);
+        }
+
+        const bool valid = header.size == size &&
+                           (header.capacity == 0 ? header.domains == 0 : std::has_single_bit(header.capacity) && header.domains < header.capacity) &&
+                           within(header.slots, header.capacity, sizeof(suffix_slot), size) &&
+                           within(header.names, header.names_size, 1, size) &&
+                           (header.bloom == 0 || (std::has_single_bit(header.bloom_words) && within(header.bloom, header.bloom_words, sizeof(std::uint64_t), size))) &&
+                           within(header.starts, header.ranges, sizeof(address_key), size) &&
+                           within(header.values, header.ranges, sizeof(std::uint32_t), size);
+        if (!valid)
+        {
+            throw abnormal::protocol_error("Corrupted blocklist: {}", path);
+        }
+
+        result->view_ = suffix_view(reinterpret_cast<const suffix_slot *>(base + header.slots), header.capacity, base + header.names,
+            header.names_size, header.domains, header.bloom == 0 ? nullptr : reinterpret_cast<const std::uint64_t *>(base + header.bloom), header.bloom_words);
+        result->starts_ = reinterpret_cast<const address_key *>(base + header.starts);
+        result->values_ = reinterpret_cast<const std::uint32_t *>(base + header.values);
+        result->ranges_ = header.ranges;
+        return result;
+    }
+
+    /**
+     * @brief 编译拦截列表并写入文件
+     * @param domains 域名，同时拦截子域名；`*.` 或 `.` 前缀与没有前缀等价，空行被忽略
+     * @param networks 地址、网段（`10.0.0.0/8`）或地址范围（`1.0.0.0-1.0.0.255`），无效项被忽略
+     * @param path 输出文件；先写入同目录的临时文件再改名替换，已映射旧文件的进程不受影响
+     * @param bloom 是否生成布隆过滤器（每个域名约 16 位）
+     * @throws abnormal::protocol_error 写入失败时抛出
+     */
+    void blocklist::compile(const std::vector<std::string> &domains, const std::vector<std::string> &networks, const std::string &path, const bool bloom)
+    {
+        suffix_table table;
+        std::size_t bytes = 0;
+        for (const auto &item : domains)
+        {
+            bytes += item.size();
+        }
+        table.reserve(domains.size(), bytes);
+        for (const auto &item : domains)
+        {
+            static_cast<void>(table.insert(item, 0, true));
+        }
+
+        interval_map<address_key> addresses;
+        for (const auto &item : networks)
+        {
+            if (address_key first, last; parse_network(item, first, last))
+            {
+                addresses.insert(first, last, 0);
+            }
+        }
+        addresses.compile();
+
+        std::vector<std::uint64_t> filter;
+        if (bloom && table.size() != 0)
+        {
+            filter.resize(std::bit_ceil(std::max<std::size_t>(table.size() / 4, 1)));
+            for (const auto &slot : table.slots())
+            {
+                if (slot.length != 0)
+                {
+                    suffix_view::mark(filter.data(), filter.size(), slot.hash);
+                }
+            }
+        }
+
+        // 布局
+        blocklist_header header{};
+        std::memcpy(header.magic, blocklist_magic, sizeof(blocklist_magic));
+        header.version = blocklist_version;
+        header.order = blocklist_order;
+        header.domains = table.size();
+        header.capacity = table.slots().size();
+        header.slots = align(sizeof(header));
+        header.names = align(header.slots + header.capacity * sizeof(suffix_slot));
+        header.names_size = table.names().size();
+        auto offset = align(header.names + header.names_size);
+        if (!filter.empty())
+        {
+            header.bloom = offset;
+            header.bloom_words = filter.size();
+            offset = align(header.bloom + header.bloom_words * sizeof(std::uint64_t));
+        }
+        header.ranges = addresses.starts().size();
+        header.starts = offset;
+        header.values = align(header.starts + header.ranges * sizeof(address_key));
+        header.size = align(header.values + header.ranges * sizeof(std::uint32_t));
+
+        const auto temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            const auto put = [&file](const std::uint64_t at, const void *data, const std::size_t length)
+            {
+                file.seekp(static_cast<std::streamoff>(at));
+                file.write(static_cast<const char *>(data), static_cast<std::streamsize>(length));
+            };
+            put(0, &header, sizeof(header));
+            put(header.slots, table.slots().data(), table.slots().size() * sizeof(suffix_slot));
+            put(header.names, table.names().data(), table.names().size());
+            put(header.bloom, filter.data(), filter.size() * sizeof(std::uint64_t));
+            put(header.starts, addresses.starts().data(), addresses.starts().size() * sizeof(address_key));
+            put(header.values, addresses.values().data(), addresses.values().size() * sizeof(std::uint32_t));
+            // 补齐到 `size`，末尾的对齐填充也落盘
+            static constexpr char zero[8] = {};
+            const auto end = static_cast<std::uint64_t>(file.seekp(0, std::ios::end).tellp());
+            file.write(zero, static_cast<std::streamsize>(header.size - end));
+            if (!file.flush())
+            {
+                throw abnormal::protocol_error("Cannot write blocklist: {}", temporary);
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temporary, path, ec);
+        if (ec)
+        {
+            std::filesystem::remove(temporary, ec);
+            throw abnormal::protocol_error("Cannot replace blocklist {}", path);
+        }
+    }
+
+    /**
+     * @brief 主机名或它的任一上级域名是否被拦截
+     */
+    bool blocklist::domain(const std::string_view host) const noexcept
+    {
+        return view_.find(host) != npos;
+    }
+
+    /**
+     * @brief 地址是否落在被拦截的网段内
+     */
+    bool blocklist::address(const net::ip::address &address) const noexcept
+    {
+        const auto key = address_key::from(address);
+        const auto *it = std::upper_bound(starts_, starts_ + ranges_, key);
+        return it != starts_ && values_[it - starts_ - 1] != npos;
+    }
+}
@@ -0,0 +1,487 @@
+#include <rule/matcher.hpp>
+#include <bit>
+#include <charconv>
+#include <deque>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace ngx::rule
+{
+    namespace
+    {
+        constexpr std::uint64_t fnv_basis = 14695981039346656037ull;
+        constexpr std::uint64_t fnv_prime = 1099511628211ull;
+
+        [[nodiscard]] constexpr char fold(const char c) noexcept
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+        }
+
+        /**
+         * @brief 比较已小写的 `lower` 与任意大小写的 `text` 的前 `length` 个字节
+         * @details x86-64 上每次 16 字节：把 `A`-`Z` 范围内的字节加上 0x20 后整块比较，不足 16 字节的尾部逐字节处理。
+         */
+        [[nodiscard]] bool equal_folded(const char *lower, const char *text, std::size_t length) noexcept
+        {
+#if defined(__SSE2__) || defined(_M_X64)
+            const auto bias = _mm_set1_epi8(static_cast<char>(0x80 - 'A')); // 把 'A' 平移到有符号最小值
+            const auto limit = _mm_set1_epi8(static_cast<char>(0x80 + 25));   // 'Z' 平移后的值
+            const auto flip = _mm_set1_epi8(0x20);
+            for (; length >= 16; length -= 16, lower += 16, text += 16)
+            {
+                const auto raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text));
+                const auto upper = _mm_cmpgt_epi8(_mm_add_epi8(raw, bias), limit); // 真表示不是大写字母
+                const auto folded = _mm_add_epi8(raw, _mm_andnot_si128(upper, flip));
+                const auto expect = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lower));
+                if (_mm_movemask_epi8(_mm_cmpeq_epi8(folded, expect)) != 0xffff)
+                {
+                    return false;
+                }
+            }
+#endif
+            for (std::size_t i = 0; i < length; ++i)
+            {
+                if (lower[i] != fold(text[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief 把哈希值打散到槽位序号（murmur3 的收尾混合）
+         */
+        [[nodiscard]] constexpr std::uint64_t mix(std::uint64_t hash) noexcept
+        {
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdull;
+            hash ^= hash >> 33;
+            return hash;
+        }
+
+        /**
+         * @brief 去掉通配前缀与结尾的点，`*.example.com`、`.example.com` 与 `example.com.` 都视为 `example.com`
+         */
+        [[nodiscard]] std::string_view trim(std::string_view domain) noexcept
+        {
+            if (domain.starts_with("*."))
+            {
+                domain.remove_prefix(2);
+            }
+            else if (domain.starts_with('.'))
+            {
+                domain.remove_prefix(1);
+            }
+            if (domain.ends_with('.'))
+            {
+                domain.remove_suffix(1);
+            }
+            return domain;
+        }
+    }
+
+    /**
+     * @brief 查找主机名或它的任一上级域名
+     * @return 命中的最小值，未命中为 `npos`
+     */
+    std::uint32_t suffix_view::find(std::string_view host) const noexcept
+    {
+        if (count_ == 0)
+        {
+            return npos;
+        }
+        if (host.ends_with('.'))
+        {
+            host.remove_suffix(1);
+        }
+
+        std::uint32_t best = npos;
+        std::uint64_t hash = fnv_basis;
+        for (std::size_t i = host.size(); i > 0; --i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(fold(host[i - 1]))) * fnv_prime;
+            if (i != 1 && host[i - 2] != '.')
+            {
+                continue;
+            }
+            if (bloom_ && !maybe(hash))
+            {
+                continue;
+            }
+            const auto index = probe(hash, host, i - 1);
+            if (index == capacity_)
+            {
+                continue;
+            }
+            if (const auto &item = slots_[index]; item.length != 0)
+            {
+                best = std::min(best, item.suffix);
+                if (i == 1)
+                {
+                    best = std::min(best, item.exact);
+                }
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @brief 计算域名的哈希（折叠大小写、从后往前），与 `find` 在标签边界处得到的值一致
+     */
+    std::uint64_t suffix_view::hash(const std::string_view domain) noexcept
+    {
+        std::uint64_t hash = fnv_basis;
+        for (auto it = domain.rbegin(); it != domain.rend(); ++it)
+        {
+            hash = (hash ^ static_cast<unsigned char>(fold(*it))) * fnv_prime;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief 在布隆过滤器中登记一个哈希
+     * @details 同一个 64 位字里置 3 位，查询只需读一个字（一条缓存行）
+     */
+    void suffix_view::mark(std::uint64_t *bloom, const std::size_t words, const std::uint64_t hash) noexcept
+    {
+        const auto mixed = mix(hash ^ 0x9e3779b97f4a7c15ull);
+        bloom[mixed & (words - 1)] |= 1ull << (mixed >> 40 & 63) | 1ull << (mixed >> 46 & 63) | 1ull << (mixed >> 52 & 63);
+    }
+
+    bool suffix_view::maybe(const std::uint64_t hash) const noexcept
+    {
+        const auto mixed = mix(hash ^ 0x9e3779b97f4a7c15ull);
+        const auto bits = 1ull << (mixed >> 40 & 63) | 1ull << (mixed >> 46 & 63) | 1ull << (mixed >> 52 & 63);
+        return (bloom_[mixed & (bloom_words_ - 1)] & bits) == bits;
+    }
+
+    /**
+     * @brief 线性探测
+     * @param from 后缀在 `host` 中的起点
+     * @return 匹配的槽位，或探测序列上的第一个空槽；走满一圈仍未找到时返回 `capacity_`
+     * @details 槽位可能来自未经逐项校验的文件，比较前确认它引用的名字在名字池内。
+     */
+    std::size_t suffix_view::probe(const std::uint64_t hash, const std::string_view host, const std::size_t from) const noexcept
+    {
+        const auto mask = capacity_ - 1;
+        const auto length = host.size() - from;
+        auto index = mix(hash) & mask;
+        for (std::size_t step = 0; step < capacity_; ++step, index = (index + 1) & mask)
+        {
+            const auto &item = slots_[index];
+            if (item.length == 0)
+            {
+                return index;
+            }
+            if (item.hash != hash || item.length != length)
+            {
+                continue;
+            }
+            if (std::size_t{item.offset} + item.length > names_size_)
+            {
+                continue;
+            }
+            if (equal_folded(names_ + item.offset, host.data() + from, length))
+            {
+                return index;
+            }
+        }
+        return capacity_;
+    }
+
+    /**
+     * @brief 添加域名
+     * @param domain 域名，忽略大小写
+     * @param value 命中时的值
+     * @param subdomains 是否同时匹配子域名
+     * @return 域名为空时为 `false`
+     * @note 同一域名重复添加时各自保留较小的值
+     */
+    bool suffix_table::insert(std::string_view domain, const std::uint32_t value, const bool subdomains)
+    {
+        domain = trim(domain);
+        if (domain.empty() || names_.size() + domain.size() > std::numeric_limits<std::uint32_t>::max())
+        {
+            return false;
+        }
+
+        if ((count_ + 1) * 4 > slots_.size() * 3)
+        {
+            rehash(std::max<std::size_t>(slots_.size() * 2, 16));
+        }
+
+        const auto hash = suffix_view::hash(domain);
+        auto &found = slots_[view().probe(hash, domain, 0)];
+        if (found.length == 0)
+        {
+            found.hash = hash;
+            found.offset = static_cast<std::uint32_t>(names_.size());
+            found.length = static_cast<std::uint32_t>(domain.size());
+            for (const auto c : domain)
+            {
+                names_.push_back(fold(c));
+            }
+            ++count_;
+        }
+        auto &target = subdomains ? found.suffix : found.exact;
+        target = std::min(target, value);
+        return true;
+    }
+
+    /**
+     * @brief 预留容量，批量添加前调用可避免反复扩容
+     * @param count 域名数
+     * @param bytes 域名总长度
+     */
+    void suffix_table::reserve(const std::size_t count, const std::size_t bytes)
+    {
+        const auto capacity = std::bit_ceil(std::max<std::size_t>(count * 4 / 3 + 1, 16));
+        if (capacity > slots_.size())
+        {
+            rehash(capacity);
+        }
+        names_.reserve(bytes);
+    }
+
+    void suffix_table::clear() noexcept
+    {
+        slots_.clear();
+        names_.clear();
+        count_ = 0;
+    }
+
+    void suffix_table::rehash(const std::size_t capacity)
+    {
+        std::vector<suffix_slot> previous(capacity);
+        previous.swap(slots_);
+        const auto mask = capacity - 1;
+        for (const auto &item : previous)
+        {
+            if (item.length == 0)
+            {
+                continue;
+            }
+            auto index = mix(item.hash) & mask;
+            while (slots_[index].length != 0)
+            {
+                index = (index + 1) & mask;
+            }
+            slots_[index] = item;
+        }
+    }
+
+    /**
+     * @brief 添加关键字，忽略大小写
+     * @note 添加后须重新 `compile`
+     */
+    void keyword_automaton::insert(const std::string_view keyword, const std::uint32_t value)
+    {
+        if (keyword.empty())
+        {
+            return;
+        }
+        std::string folded;
+        folded.reserve(keyword.size());
+        for (const auto c : keyword)
+        {
+            folded.push_back(fold(c));
+        }
+        keywords_.push_back(std::move(folded));
+        values_.push_back(value);
+    }
+
+    /**
+     * @brief 构建转移表
+     */
+    void keyword_automaton::compile()
+    {
+        if (keywords_.empty())
+        {
+            clear();
+            return;
+        }
+
+        // 1. 字符归类：0 为未在任何关键字中出现的字符
+        classes_.fill(0);
+        width_ = 1;
+        for (const auto &keyword : keywords_)
+        {
+            for (const auto c : keyword)
+            {
+                auto &id = classes_[static_cast<unsigned char>(c)];
+                if (id == 0)
+                {
+                    id = static_cast<std::uint8_t>(width_++);
+                }
+            }
+        }
+        for (int c = 'A'; c <= 'Z'; ++c)
+        {
+            classes_[c] = classes_[c - 'A' + 'a'];
+        }
+
+        // 2. 关键字前缀树，直接写在转移表里；0 号状态为根，转移为 0 表示尚无子节点
+        transition_.assign(width_, 0);
+        output_.assign(1, npos);
+        for (std::size_t k = 0; k < keywords_.size(); ++k)
+        {
+            std::uint32_t state = 0;
+            for (const auto c : keywords_[k])
+            {
+                const auto id = classes_[static_cast<unsigned char>(c)];
+                auto next = transition_[state * width_ + id];
+                if (next == 0)
+                {
+                    next = static_cast<std::uint32_t>(output_.size());
+                    transition_[state * width_ + id] = next;
+                    transition_.resize(transition_.size() + width_, 0);
+                    output_.push_back(npos);
+                }
+                state = next;
+            }
+            output_[state] = std::min(output_[state], values_[k]);
+        }
+
+        // 3. 按广度优先补全失败转移，并把失败链上的输出合并进来
+        std::vector<std::uint32_t> fail(output_.size(), 0);
+        std::deque<std::uint32_t> queue;
+        for (std::size_t id = 0; id < width_; ++id)
+        {
+            if (const auto next = transition_[id]; next != 0)
+            {
+                queue.push_back(next);
+            }
+        }
+        while (!queue.empty())
+        {
+            const auto state = queue.front();
+            queue.pop_front();
+            output_[state] = std::min(output_[state], output_[fail[state]]);
+            for (std::size_t id = 0; id < width_; ++id)
+            {
+                auto &next = transition_[state * width_ + id];
+                const auto fallback = transition_[fail[state] * width_ + id];
+                if (next == 0)
+                {
+                    next = fallback;
+                }
+                else
+                {
+                    fail[next] = fallback;
+                    queue.push_back(next);
+                }
+            }
+        }
+
+        keywords_.clear();
+        keywords_.shrink_to_fit();
+        values_.clear();
+        values_.shrink_to_fit();
+    }
+
+    /**
+     * @brief 在文本中查找关键字
+     * @return 出现过的关键字中最小的值，未命中为 `npos`
+     */
+    std::uint32_t keyword_automaton::find(const std::string_view text) const noexcept
+    {
+        if (output_.empty())
+        {
+            return npos;
+        }
+        std::uint32_t best = npos;
+        std::uint32_t state = 0;
+        for (const auto c : text)
+        {
+            state = transition_[state * width_ + classes_[static_cast<unsigned char>(c)]];
+            best = std::min(best, output_[state]);
+        }
+        return best;
+    }
+
+    void keyword_automaton::clear() noexcept
+    {
+        keywords_.clear();
+        values_.clear();
+        transition_.clear();
+        output_.clear();
+        width_ = 1;
+    }
+
+    address_key address_key::from(const net::ip::address &address) noexcept
+    {
+        address_key key;
+        if (address.is_v4())
+        {
+            key.low = 0xffff00000000ull | address.to_v4().to_uint();
+            return key;
+        }
+        const auto bytes = address.to_v6().to_bytes();
+        for (std::size_t i = 0; i < 8; ++i)
+        {
+            key.high = key.high << 8 | bytes[i];
+            key.low = key.low << 8 | bytes[i + 8];
+        }
+        return key;
+    }
+
+    /**
+     * @brief 解析网段
+     * @param text `10.0.0.1`、`10.0.0.0/8`、`fc00::/7` 或 `1.0.0.0-1.0.0.255`
+     * @param first 网段的第一个地址
+     * @param last 网段的最后一个地址
+     * @return 格式无效时为 `false`
+     */
+    bool parse_network(const std::string_view text, address_key &first, address_key &last)
+    {
+        boost::system::error_code ec;
+        if (const auto dash = text.find('-'); dash != std::string_view::npos)
+        {
+            const auto begin = net::ip::make_address(std::string(text.substr(0, dash)), ec);
+            if (ec)
+            {
+                return false;
+            }
+            const auto end = net::ip::make_address(std::string(text.substr(dash + 1)), ec);
+            if (ec || begin.is_v4() != end.is_v4())
+            {
+                return false;
+            }
+            first = address_key::from(begin);
+            last = address_key::from(end);
+            return !(last < first);
+        }
+
+        const auto slash = text.find('/');
+        const auto address = net::ip::make_address(std::string(text.substr(0, slash)), ec);
+        if (ec)
+        {
+            return false;
+        }
+        const unsigned width = address.is_v4() ? 32 : 128;
+        unsigned length = width;
+        if (slash != std::string_view::npos)
+        {
+            const auto digits = text.substr(slash + 1);
+            const auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), length);
+            if (error != std::errc{} || end != digits.data() + digits.size() || length > width)
+            {
+                return false;
+            }
+        }
+
+        // 前缀长度换算到 128 位空间后生成掩码
+        const auto bits = length + (128 - width);
+        const auto high_mask = bits >= 64 ? ~0ull : (bits == 0 ? 0ull : ~0ull << (64 - bits));
+        const auto low_mask = bits <= 64 ? 0ull : (bits == 128 ? ~0ull : ~0ull << (128 - bits));
+        first = address_key::from(address);
+        first.high &= high_mask;
+        first.low &= low_mask;
+        last = first;
+        last.high |= ~high_mask;
+        last.low |= ~low_mask;
+        return true;
+    }
+}
@@ -0,0 +1,245 @@
+#include <rule/policy.hpp>
+#include <abnormal.hpp>
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <utility>
+
+namespace ngx::rule
+{
+    namespace
+    {
+        [[nodiscard]] std::string_view strip(std::string_view text) noexcept
+        {
+            while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            {
+                text.remove_prefix(1);
+            }
+            while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+            {
+                text.remove_suffix(1);
+            }
+            return text;
+        }
+
+        /**
+         * @brief 按逗号切分，去掉每段首尾的空白
+         */
+        [[nodiscard]] std::vector<std::string_view> split(std::string_view line)
+        {
+            std::vector<std::string_view> fields;
+            while (true)
+            {
+                const auto comma = line.find(',');
+                fields.push_back(strip(line.substr(0, comma)));
+                if (comma == std::string_view::npos)
+                {
+                    break;
+                }
+                line.remove_prefix(comma + 1);
+            }
+            return fields;
+        }
+
+        [[nodiscard]] bool parse_port(const std::string_view text, std::uint16_t &value) noexcept
+        {
+            const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc{} && end == text.data() + text.size();
+        }
+
+        [[nodiscard]] bool equal_folded(const std::string_view left, const std::string_view right) noexcept
+        {
+            return std::ranges::equal(left, right, [](const char l, const char r)
+            {
+                return (l >= 'a' && l <= 'z' ? l - 'a' + 'A' : l) == (r >= 'a' && r <= 'z' ? r - 'a' + 'A' : r);
+            });
+        }
+    }
+
+    /**
+     * @brief 编译规则集
+     * @param rules 规则，按优先级从高到低
+     * @param parents 上级代理名，规则目标中的名字按它换算为序号
+     * @param geoip `GEOIP` 规则使用的地址库文件，没有 `GEOIP` 规则时不读取
+     * @throws abnormal::protocol_error 规则格式无效、目标未知或地址库无法读取时抛出
+     */
+    void policy::compile(const std::vector<std::string> &rules, const std::vector<std::string> &parents, const std::string &geoip)
+    {
+        domains_.clear();
+        keywords_.clear();
+        ports_.clear();
+        addresses_.clear();
+        fallback_ = npos;
+        first_address_ = npos;
+        targets_.clear();
+        targets_.reserve(rules.size());
+
+        std::vector<std::pair<std::string_view, std::uint32_t>> regions;
+        for (std::uint32_t index = 0; index < rules.size(); ++index)
+        {
+            const auto fields = split(rules[index]);
+            const auto type = fields.front();
+            const bool fallback = type == "MATCH" || type == "FINAL";
+            if (fields.size() < (fallback ? 2u : 3u))
+            {
+                throw abnormal::protocol_error("Invalid policy rule: {}", rules[index]);
+            }
+
+            // 目标
+            const auto name = fallback ? fields[1] : fields[2];
+            target destination;
+            if (name == "DIRECT")
+            {
+                destination.kind = action::direct;
+            }
+            else if (name == "REJECT")
+            {
+                destination.kind = action::reject;
+            }
+            else if (const auto it = std::ranges::find(parents, name); it != parents.end())
+            {
+                destination.kind = action::parent;
+                destination.parent = static_cast<std::uint32_t>(it - parents.begin());
+            }
+            else
+            {
+                throw abnormal::protocol_error("Unknown policy target: {}", name);
+            }
+            targets_.push_back(destination);
+
+            // 条件
+            bool valid = true;
+            if (fallback)
+            {
+                fallback_ = std::min(fallback_, index);
+            }
+            else if (type == "DOMAIN" || type == "DOMAIN-SUFFIX")
+            {
+                valid = domains_.insert(fields[1], index, type == "DOMAIN-SUFFIX");
+            }
+            else if (type == "DOMAIN-KEYWORD")
+            {
+                valid = !fields[1].empty();
+                keywords_.insert(fields[1], index);
+            }
+            else if (type == "IP-CIDR" || type == "IP-CIDR6" || type == "IP-RANGE")
+            {
+                address_key first, last;
+                valid = parse_network(fields[1], first, last);
+                addresses_.insert(first, last, index);
+                first_address_ = std::min(first_address_, index);
+            }
+            else if (type == "GEOIP")
+            {
+                valid = !fields[1].empty();
+                regions.emplace_back(fields[1], index);
+                first_address_ = std::min(first_address_, index);
+            }
+            else if (type == "DST-PORT")
+            {
+                const auto dash = fields[1].find('-');
+                std::uint16_t first = 0, last = 0;
+                valid = parse_port(fields[1].substr(0, dash), first) &&
+                        parse_port(dash == std::string_view::npos ? fields[1] : fields[1].substr(dash + 1), last) &&
+                        first <= last;
+                ports_.insert(first, last, index);
+            }
+            else
+            {
+                valid = false;
+            }
+
+            if (!valid)
+            {
+                throw abnormal::protocol_error("Invalid policy rule: {}", rules[index]);
+            }
+        }
+
+        // 地址库：只读入被规则引用的地区
+        if (!regions.empty())
+        {
+            std::ifstream file(geoip);
+            if (!file)
+            {
+                throw abnormal::protocol_error("Cannot open GeoIP database: {}", geoip);
+            }
+            std::string line;
+            while (std::getline(file, line))
+            {
+                const auto fields = split(line);
+                if (fields.size() < 3 || fields[0].empty() || fields[0].front() == '#')
+                {
+                    continue;
+                }
+                address_key first, last;
+                std::string network(fields[0]);
+                network.push_back('-');
+                network.append(fields[1]);
+                if (!parse_network(network, first, last))
+                {
+                    continue;
+                }
+                for (const auto &[region, index] : regions)
+                {
+                    if (equal_folded(region, fields[2]))
+                    {
+                        addresses_.insert(first, last, index);
+                    }
+                }
+            }
+        }
+
+        keywords_.compile();
+        ports_.compile();
+        addresses_.compile();
+    }
+
+    /**
+     * @brief 不看目标地址的判定
+     * @param host 目标主机名
+     * @param port 目标端口
+     * @return 若某条地址类规则排在所有已命中的规则之前，结果的 `resolve` 为真，
+     * 此时须解析目标地址后改用带地址的重载；否则即为最终结果
+     */
+    policy::verdict policy::decide(const std::string_view host, const std::uint16_t port) const noexcept
+    {
+        const auto rule = prematch(host, port);
+        if (first_address_ < rule)
+        {
+            verdict result;
+            result.resolve = true;
+            return result;
+        }
+        return conclude(rule);
+    }
+
+    /**
+     * @brief 带目标地址的完整判定
+     */
+    policy::verdict policy::decide(const std::string_view host, const std::uint16_t port, const net::ip::address &address) const noexcept
+    {
+        auto rule = prematch(host, port);
+        if (first_address_ < rule)
+        {
+            rule = std::min(rule, addresses_.find(address_key::from(address)));
+        }
+        return conclude(rule);
+    }
+
+    std::uint32_t policy::prematch(const std::string_view host, const std::uint16_t port) const noexcept
+    {
+        return std::min({domains_.find(host), keywords_.find(host), ports_.find(port), fallback_});
+    }
+
+    policy::verdict policy::conclude(const std::uint32_t rule) const noexcept
+    {
+        verdict result;
+        if (rule != npos)
+        {
+            result.kind = targets_[rule].kind;
+            result.parent = targets_[rule].parent;
+            result.rule = rule;
+        }
+        return result;
+    }
+}
@@ -1,5 +1,7 @@
 #include <agent.hpp>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <thread>
 #include <http.hpp>
 #include <agent.hpp>
@@ -15,19 +17,47 @@ constexpr  std::string_view key_path = "C:\\Users\\C1373\\Desktop\\ForwardEngine
 
 
 // TODO: add more tests
-int main()
+int main(int argc, char *argv[])
 {
-    constexpr unsigned short port = 8080;
+    // 用法：ForwardEngine [--ingress] [配置文件]
+    // 默认作为服务端运行；--ingress 以同一份可执行程序在客户端侧启动本地接入，经 obscura 连接池转发到远端
+    bool ingress_mode = false;
+    std::string config_path = "src/configuration.json";
+    for (int i = 1; i < argc; ++i)
+    {
+        if (const std::string_view arg = argv[i]; arg == "--ingress")
+        {
+            ingress_mode = true;
+        }
+        else
+        {
+            config_path = arg;
+        }
+    }
+
     auto threads_count = std::thread::hardware_concurrency();
     if (threads_count == 0)
     {
         threads_count = 1;
     }
 
+    if (ingress_mode)
+    {
+        agent::ingress in;
+        in.load_option(config_path);
+        std::cout << "Starting ForwardEngine ingress with " << threads_count << " threads on "
+                  << agent::reactor_backend() << " reactor..." << std::endl;
+        in.run(threads_count);
+        return 0;
+    }
+
+    constexpr unsigned short port = 8080;
     std::cout << "Starting ForwardEngine on port " << port
-              << " with " << threads_count << " threads..." << std::endl;
+              << " with " << threads_count << " threads on "
+              << agent::reactor_backend() << " reactor..." << std::endl;
 
     agent::worker w(port, {cert_path.data()}, {key_path.data()});
-    w.load_reverse_map("src/configuration.json");
+    w.load_option(config_path);
+    w.load_reverse_map(config_path);
     w.run(threads_count);
 }
@@ -0,0 +1,152 @@
+#include <rule/acl.hpp>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace net = boost::asio;
+using ngx::rule::acl;
+
+/**
+ * @brief 解析地址文本
+ */
+net::ip::address address(const char *text)
+{
+    return net::ip::make_address(text);
+}
+
+/**
+ * @brief 测试空表取默认动作
+ */
+void test_default_action()
+{
+    std::cout << "=== 开始默认动作测试 ===" << std::endl;
+    acl open;
+    assert(open.empty());
+    assert(open.permit(address("192.0.2.1")));
+
+    acl closed;
+    closed.compile({}, false);
+    assert(!closed.permit(address("192.0.2.1")));
+
+    std::cout << "默认动作测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试第一条命中的规则生效
+ */
+void test_first_match()
+{
+    std::cout << "=== 开始首条命中测试 ===" << std::endl;
+    acl table;
+    table.compile({"allow 10.1.2.0/24", "deny 10.0.0.0/8", "deny  203.0.113.7", "deny 1.0.0.0-1.0.0.255",
+                   "allow 2001:db8::1", "deny 2001:db8::/32"});
+
+    assert(table.permit(address("10.1.2.200")));
+    assert(!table.permit(address("10.1.3.1")));
+    assert(!table.permit(address("10.255.255.255")));
+    assert(table.permit(address("11.0.0.0")));
+    assert(!table.permit(address("203.0.113.7")));
+    assert(table.permit(address("203.0.113.8")));
+    assert(!table.permit(address("1.0.0.77")));
+    assert(table.permit(address("2001:db8::1")));
+    assert(!table.permit(address("2001:db8::2")));
+    assert(table.permit(address("2001:db9::1")));
+
+    // IPv4 映射的 IPv6 地址与 IPv4 同等对待
+    assert(!table.permit(address("::ffff:10.0.0.1")));
+
+    std::cout << "首条命中测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试白名单模式，`deny all` 兜底
+ */
+void test_allow_list()
+{
+    std::cout << "=== 开始白名单模式测试 ===" << std::endl;
+    acl table;
+    table.compile({"allow 127.0.0.1", "allow ::1", "deny all"});
+
+    assert(table.permit(address("127.0.0.1")));
+    assert(table.permit(address("::1")));
+    assert(!table.permit(address("127.0.0.2")));
+    assert(!table.permit(address("8.8.8.8")));
+    assert(!table.permit(address("2001:4860::8888")));
+
+    std::cout << "白名单模式测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试格式错误的规则被拒绝
+ */
+void test_invalid_rules()
+{
+    std::cout << "=== 开始无效规则测试 ===" << std::endl;
+    for (const std::string bad : {"block 10.0.0.0/8", "deny", "allow 10.0.0.0/33", "deny example.com"})
+    {
+        acl table;
+        bool thrown = false;
+        try
+        {
+            table.compile({bad});
+        }
+        catch (const std::exception &)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    std::cout << "无效规则测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试大表中每段区间的边界都能正确命中
+ */
+void test_large_table()
+{
+    std::cout << "=== 开始大表测试 ===" << std::endl;
+    std::vector<std::string> rules;
+    rules.reserve(100000);
+    for (int i = 0; i < 100000; ++i)
+    {
+        rules.push_back("deny " + std::to_string(20 + i / 65536) + "." + std::to_string(i / 256 % 256) + "." +
+                        std::to_string(i % 256) + ".0/24");
+    }
+    acl table;
+    table.compile(rules);
+
+    assert(!table.permit(address("20.0.5.9")));
+    assert(!table.permit(address("20.0.0.0")));
+    assert(!table.permit(address("21.3.7.1")));
+    assert(!table.permit(address("21.134.159.255")));
+    assert(table.permit(address("21.134.160.0")));
+    assert(table.permit(address("19.255.255.255")));
+    assert(table.permit(address("30.0.0.1")));
+
+    std::cout << "大表测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "客户端访问控制模块测试启动..." << std::endl;
+
+    try
+    {
+        test_default_action();
+        test_first_match();
+        test_allow_list();
+        test_invalid_rules();
+        test_large_table();
+
+        std::cout << "\n所有客户端访问控制测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include <agent/admission.hpp>
+#include <boost/asio.hpp>
+#include <cassert>
+#include <iostream>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace net = boost::asio;
+using ngx::agent::admission;
+using ngx::agent::option;
+
+/**
+ * @brief 测试会话数达到上限时拒绝，释放后恢复
+ */
+void test_session_limit()
+{
+    std::cout << "=== 开始会话数上限测试 ===" << std::endl;
+    net::io_context ioc;
+    option::admission_option opt;
+    opt.soft_sessions = 2;
+    opt.hard_sessions = 3;
+    admission gate(ioc, opt);
+
+    std::vector<admission::ticket> tickets;
+    assert(gate.judge() == admission::verdict::admit);
+
+    tickets.push_back(gate.admit(0));
+    assert(gate.sessions() == 1);
+    assert(gate.judge() == admission::verdict::admit);
+
+    // 达到软上限：快速拒绝
+    tickets.push_back(gate.admit(0));
+    assert(gate.judge() == admission::verdict::shed);
+
+    // 达到硬上限：暂停接入
+    tickets.push_back(gate.admit(0));
+    assert(gate.judge() == admission::verdict::pause);
+
+    // 凭证析构后逐级恢复
+    tickets.pop_back();
+    assert(gate.judge() == admission::verdict::shed);
+    tickets.clear();
+    assert(gate.sessions() == 0);
+    assert(gate.judge() == admission::verdict::admit);
+
+    std::cout << "会话数上限测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试缓冲内存达到上限时拒绝，追加与归还计入后恢复
+ */
+void test_memory_limit()
+{
+    std::cout << "=== 开始缓冲内存上限测试 ===" << std::endl;
+    net::io_context ioc;
+    option::admission_option opt;
+    opt.soft_memory = 100000;
+    opt.hard_memory = 200000;
+    admission gate(ioc, opt);
+
+    std::optional<admission::ticket> first = gate.admit(16384);
+    assert(gate.memory() == 16384);
+    assert(gate.judge() == admission::verdict::admit);
+
+    // 会话启用合批缓冲与多路复用队列后追加计入
+    first->charge(65536);
+    first->charge(32768);
+    assert(gate.memory() == 16384 + 65536 + 32768);
+    assert(gate.judge() == admission::verdict::shed);
+
+    auto second = gate.admit(100000);
+    assert(gate.judge() == admission::verdict::pause);
+
+    // 多路复用的流关闭后归还；归还超过已计入的部分按已计入处理
+    first->refund(32768);
+    assert(gate.memory() == 16384 + 65536 + 100000);
+    assert(gate.judge() == admission::verdict::shed);
+    first->refund(1 << 20);
+    assert(gate.memory() == 100000);
+
+    first.reset();
+    assert(gate.sessions() == 1);
+    assert(gate.memory() == 100000);
+    {
+        const auto released = std::move(second);
+    }
+    assert(gate.sessions() == 0);
+    assert(gate.memory() == 0);
+    assert(gate.judge() == admission::verdict::admit);
+
+    std::cout << "缓冲内存上限测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试凭证移动后计数只归还一次
+ */
+void test_ticket_move()
+{
+    std::cout << "=== 开始凭证移动测试 ===" << std::endl;
+    net::io_context ioc;
+    option::admission_option opt;
+    admission gate(ioc, opt);
+
+    {
+        auto origin = gate.admit(1024);
+        admission::ticket moved(std::move(origin));
+        admission::ticket assigned;
+        assigned = std::move(moved);
+        assigned.charge(1024);
+        assert(gate.sessions() == 1);
+        assert(gate.memory() == 2048);
+
+        // 空凭证的追加与归还都是空操作
+        origin.charge(4096);
+        origin.refund(4096);
+        assert(gate.memory() == 2048);
+    }
+    assert(gate.sessions() == 0);
+    assert(gate.memory() == 0);
+
+    std::cout << "凭证移动测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "准入控制模块测试启动..." << std::endl;
+
+    try
+    {
+        test_session_limit();
+        test_memory_limit();
+        test_ticket_move();
+
+        std::cout << "\n所有准入控制测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include <agent/balancer.hpp>
+#include <cassert>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace net = boost::asio;
+using ngx::agent::affinity;
+using ngx::agent::backend;
+using ngx::agent::balancer;
+
+/**
+ * @brief 按权重构造一组后端，地址依次为 10.0.0.1、10.0.0.2……
+ */
+std::vector<backend> make_backends(const std::vector<std::uint32_t> &weights)
+{
+    std::vector<backend> result;
+    for (std::size_t i = 0; i < weights.size(); ++i)
+    {
+        backend item;
+        item.endpoint = net::ip::tcp::endpoint(net::ip::make_address("10.0.0." + std::to_string(i + 1)), 80);
+        item.weight = weights[i];
+        result.push_back(std::move(item));
+    }
+    return result;
+}
+
+/**
+ * @brief 测试平滑加权轮询一整轮内按权重分配，且权重最大的后端不会连续集中命中
+ */
+void test_smooth_weighted_round_robin()
+{
+    std::cout << "=== 开始平滑加权轮询测试 ===" << std::endl;
+    auto group = balancer::make(balancer::strategy::swrr, make_backends({5, 1, 1}));
+
+    std::map<unsigned short, int> hits;
+    std::vector<const backend *> order;
+    for (int i = 0; i < 7; ++i)
+    {
+        const auto &chosen = group->select({});
+        order.push_back(&chosen);
+        ++hits[chosen.endpoint.address().to_v4().to_bytes()[3]];
+    }
+    assert(hits[1] == 5 && hits[2] == 1 && hits[3] == 1);
+
+    // nginx 序列：a a b a c a a
+    assert(order[0] == order[1] && order[1] != order[2]);
+
+    std::cout << "平滑加权轮询测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试最少在途总是选择在途数与权重之比最小的后端
+ */
+void test_least_outstanding()
+{
+    std::cout << "=== 开始最少在途测试 ===" << std::endl;
+    auto group = balancer::make(balancer::strategy::least, make_backends({1, 1, 1}));
+    group->backends()[0].state->outstanding.store(4);
+    group->backends()[1].state->outstanding.store(1);
+    group->backends()[2].state->outstanding.store(3);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        assert(&group->select({}) == &group->backends()[1]);
+    }
+
+    std::cout << "最少在途测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试两次随机选择永远不会选中负载最重的后端
+ */
+void test_power_of_two_choices()
+{
+    std::cout << "=== 开始两次随机选择测试 ===" << std::endl;
+    auto group = balancer::make(balancer::strategy::p2c, make_backends({1, 1, 1, 1}));
+    group->backends()[2].state->outstanding.store(100);
+
+    for (int i = 0; i < 256; ++i)
+    {
+        assert(&group->select({}) != &group->backends()[2]);
+    }
+
+    std::cout << "两次随机选择测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试不可用的后端被跳过，全部不可用时照常选择
+ */
+void test_unavailable_backends()
+{
+    std::cout << "=== 开始不可用后端测试 ===" << std::endl;
+    auto group = balancer::make(balancer::strategy::swrr, make_backends({1, 1}));
+    group->backends()[0].state->up.store(false);
+
+    for (int i = 0; i < 8; ++i)
+    {
+        assert(&group->select({}) == &group->backends()[1]);
+    }
+
+    group->backends()[1].state->up.store(false);
+    const auto &fallback = group->select({});
+    assert(&fallback == &group->backends()[0] || &fallback == &group->backends()[1]);
+
+    std::cout << "不可用后端测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试 Maglev 同一键稳定映射，去掉一个后端后原本不在它上面的键大多保持不变
+ */
+void test_maglev_consistency()
+{
+    std::cout << "=== 开始 Maglev 一致性测试 ===" << std::endl;
+    auto full = balancer::make(balancer::strategy::maglev, make_backends({1, 1, 1, 1}), balancer::hash_key::path);
+    auto reduced = balancer::make(balancer::strategy::maglev, make_backends({1, 1, 1}), balancer::hash_key::path);
+
+    int kept = 0;
+    int candidates = 0;
+    for (int i = 0; i < 1000; ++i)
+    {
+        const auto path = "/item/" + std::to_string(i);
+        const affinity hint{{}, path};
+        const auto &first = full->select(hint);
+        assert(&first == &full->select(hint));
+
+        if (first.endpoint.address() == full->backends()[3].endpoint.address())
+        {
+            continue;
+        }
+        ++candidates;
+        if (reduced->select(hint).endpoint == first.endpoint)
+        {
+            ++kept;
+        }
+    }
+    assert(kept * 10 >= candidates * 9);
+
+    std::cout << "Maglev 一致性测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "负载均衡模块测试启动..." << std::endl;
+
+    try
+    {
+        test_smooth_weighted_round_robin();
+        test_least_outstanding();
+        test_power_of_two_choices();
+        test_unavailable_backends();
+        test_maglev_consistency();
+
+        std::cout << "\n所有负载均衡测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
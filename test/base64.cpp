@@ -0,0 +1,95 @@
+#include <agent/base64.hpp>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using ngx::agent::base64;
+
+/**
+ * @brief 测试 RFC 4648 给出的标准向量
+ */
+void test_vectors()
+{
+    std::cout << "=== 开始标准向量测试 ===" << std::endl;
+    const std::pair<std::string, std::string> vectors[] = {
+        {"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"},
+        {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"}};
+
+    for (const auto &[plain, text] : vectors)
+    {
+        assert(base64::encode(plain) == text);
+        std::string data = "stale";
+        assert(base64::decode(text, data));
+        assert(data == plain);
+    }
+    assert(base64::encode(std::string("\xfb\xff", 2)) == "+/8=");
+
+    std::cout << "标准向量测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试任意字节（含 0 与高位字节）在各种长度下往返一致
+ */
+void test_round_trip()
+{
+    std::cout << "=== 开始往返测试 ===" << std::endl;
+    std::mt19937 engine(42);
+    std::uniform_int_distribution<int> byte(0, 255);
+    for (std::size_t size = 0; size <= 4096; size += size < 64 ? 1 : 97)
+    {
+        std::string plain(size, '\0');
+        for (auto &c : plain)
+        {
+            c = static_cast<char>(byte(engine));
+        }
+
+        const auto text = base64::encode(plain);
+        assert(text.size() == (size + 2) / 3 * 4);
+        std::string data;
+        assert(base64::decode(text, data));
+        assert(data == plain);
+    }
+
+    std::cout << "往返测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试格式错误的输入被拒绝
+ */
+void test_malformed()
+{
+    std::cout << "=== 开始格式错误测试 ===" << std::endl;
+    const std::vector<std::string> inputs = {"Zg=", "Zm9vY", "Zm9v!A==", "Zm 9", "Z===", "====", "=Zg=", "Zm=8",
+                                             "Zg==Zm8=", "Zm9v\nYmFy", "Zm9v-_==", std::string("Zm\0v", 4)};
+    for (const auto &bad : inputs)
+    {
+        std::string data;
+        assert(!base64::decode(bad, data));
+    }
+
+    std::cout << "格式错误测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "base64 模块测试启动..." << std::endl;
+
+    try
+    {
+        test_vectors();
+        test_round_trip();
+        test_malformed();
+
+        std::cout << "\n所有 base64 测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
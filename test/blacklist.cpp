@@ -0,0 +1,153 @@
+#include <rule/blacklist.hpp>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::size_t allocations = 0;
+}
+
+void *operator new(const std::size_t size)
+{
+    ++allocations;
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+/**
+ * @brief 构造一份包含大量域名的黑名单
+ */
+void load_bulk(ngx::limit::blacklist &list)
+{
+    constexpr std::size_t count = 100000;
+    std::vector<std::string> domains;
+    domains.reserve(count + 2);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        domains.push_back("tracker-" + std::to_string(i) + ".ads.example");
+    }
+    domains.push_back("Baidu.com");
+    domains.push_back("*.wild.org");
+    list.load({"10.0.0.1", "192.168.1.1:8080"}, domains);
+}
+
+/**
+ * @brief 测试域名后缀匹配：忽略大小写与结尾的点，子域名命中，相似域名不命中
+ */
+void test_domain_suffix()
+{
+    std::cout << "=== 开始域名后缀匹配测试 ===" << std::endl;
+    ngx::limit::blacklist list;
+    assert(!list.domain("example.com"));
+    load_bulk(list);
+
+    assert(list.domain("baidu.com"));
+    assert(list.domain("MAP.BAIDU.COM"));
+    assert(list.domain("map.baidu.com."));
+    assert(!list.domain("notbaidu.com"));
+    assert(!list.domain("com"));
+    assert(list.domain("x.wild.org"));
+    assert(list.domain("wild.org"));
+    assert(list.domain("A-Very-Long-Subdomain-Label-For-Simd.Tracker-99999.ADS.example"));
+    assert(list.domain("cdn.Tracker-12345.ads.example"));
+    assert(list.domain("tracker-0.ads.example"));
+    assert(!list.domain("tracker-100000.ads.example"));
+    assert(!list.domain(""));
+
+    std::cout << "域名后缀匹配测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试地址与端点精确匹配
+ */
+void test_endpoint()
+{
+    std::cout << "=== 开始端点匹配测试 ===" << std::endl;
+    ngx::limit::blacklist list;
+    load_bulk(list);
+
+    assert(list.endpoint("10.0.0.1"));
+    assert(list.endpoint(std::string_view("192.168.1.1:8080")));
+    assert(!list.endpoint("10.0.0.2"));
+
+    std::cout << "端点匹配测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试查询过程不分配内存
+ */
+void test_lookup_without_allocation()
+{
+    std::cout << "=== 开始查询零分配测试 ===" << std::endl;
+    ngx::limit::blacklist list;
+    load_bulk(list);
+
+    const std::string long_host = "A-Very-Long-Subdomain-Label-For-Simd.Tracker-99999.ADS.example";
+    const auto before = allocations;
+    static_cast<void>(list.domain("MAP.BAIDU.COM"));
+    static_cast<void>(list.domain("notbaidu.com"));
+    static_cast<void>(list.domain(long_host));
+    static_cast<void>(list.endpoint("10.0.0.1"));
+    static_cast<void>(list.endpoint(std::string_view("192.168.1.1:8080")));
+    assert(allocations == before);
+
+    std::cout << "查询零分配测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试逐条追加与清空
+ */
+void test_insert_and_clear()
+{
+    std::cout << "=== 开始追加与清空测试 ===" << std::endl;
+    ngx::limit::blacklist list;
+    load_bulk(list);
+
+    list.insert_domain("Later.NET");
+    assert(list.domain("a.later.net"));
+    list.clear();
+    assert(!list.domain("baidu.com"));
+    assert(!list.domain("a.later.net"));
+    assert(!list.endpoint("10.0.0.1"));
+
+    std::cout << "追加与清空测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "黑名单模块测试启动..." << std::endl;
+
+    try
+    {
+        test_domain_suffix();
+        test_endpoint();
+        test_lookup_without_allocation();
+        test_insert_and_clear();
+
+        std::cout << "\n所有黑名单测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <rule/blocklist.hpp>
+#include <rule/blacklist.hpp>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace net = boost::asio;
+using ngx::rule::blocklist;
+
+namespace
+{
+    const std::string path = "blocklist_test.bin";
+    constexpr std::size_t count = 100000;
+}
+
+/**
+ * @brief 构造大量域名，另含一条通配与一条空行
+ */
+std::vector<std::string> make_domains()
+{
+    std::vector<std::string> domains;
+    domains.reserve(count + 2);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        domains.push_back("ad" + std::to_string(i) + ".Tracker.example");
+    }
+    domains.push_back("*.wild.org");
+    domains.push_back("");
+    return domains;
+}
+
+/**
+ * @brief 断言 `open` 抛出异常
+ */
+void expect_rejected()
+{
+    bool thrown = false;
+    try
+    {
+        static_cast<void>(blocklist::open(path));
+    }
+    catch (const std::exception &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+/**
+ * @brief 测试带布隆过滤器的列表：域名后缀与地址区间匹配
+ */
+void test_with_filter()
+{
+    std::cout << "=== 开始布隆过滤器列表测试 ===" << std::endl;
+    const std::vector<std::string> networks = {"10.0.0.0/8", "203.0.113.7", "1.0.0.0-1.0.0.255", "2001:db8::/32", "bogus"};
+    blocklist::compile(make_domains(), networks, path);
+    const auto list = blocklist::open(path);
+
+    assert(list->domains() == count + 1);
+    assert(list->ranges() > 0);
+    assert(list->domain("ad0.tracker.example"));
+    assert(list->domain("x.AD99999.TRACKER.EXAMPLE"));
+    assert(!list->domain("ad100000.tracker.example"));
+    assert(!list->domain("tracker.example"));
+    assert(!list->domain("www.clean-site.example.com"));
+    assert(list->domain("wild.org"));
+    assert(list->domain("a.b.wild.org."));
+    assert(!list->domain("example.org"));
+
+    assert(list->address(net::ip::make_address("10.200.0.1")));
+    assert(list->address(net::ip::make_address("203.0.113.7")));
+    assert(!list->address(net::ip::make_address("203.0.113.8")));
+    assert(list->address(net::ip::make_address("1.0.0.128")));
+    assert(!list->address(net::ip::make_address("1.0.1.0")));
+    assert(list->address(net::ip::make_address("2001:db8::1")));
+    assert(!list->address(net::ip::make_address("2001:db9::1")));
+
+    std::cout << "布隆过滤器列表测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试挂到黑名单上后与配置条目同时生效
+ */
+void test_attach_to_blacklist()
+{
+    std::cout << "=== 开始挂载黑名单测试 ===" << std::endl;
+    blocklist::compile(make_domains(), {"10.0.0.0/8"}, path);
+    const auto list = blocklist::open(path);
+
+    ngx::limit::blacklist black;
+    black.load({}, {"local.test"});
+    black.attach(list);
+    assert(black.domain("local.test"));
+    assert(black.domain("ad5.tracker.example"));
+    assert(black.address(net::ip::make_address("10.0.0.1")));
+    assert(!black.domain("clean.example"));
+
+    std::cout << "挂载黑名单测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试没有布隆过滤器时结果一致
+ */
+void test_without_filter()
+{
+    std::cout << "=== 开始无过滤器列表测试 ===" << std::endl;
+    blocklist::compile(make_domains(), {}, path, false);
+    const auto list = blocklist::open(path);
+
+    assert(list->ranges() == 0);
+    assert(list->domain("ad42.tracker.example"));
+    assert(!list->domain("ad42.tracker.example.com"));
+    assert(!list->address(net::ip::make_address("10.0.0.1")));
+
+    std::cout << "无过滤器列表测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试截断或格式不符的文件被拒绝
+ */
+void test_corrupt_file()
+{
+    std::cout << "=== 开始损坏文件测试 ===" << std::endl;
+    blocklist::compile(make_domains(), {}, path);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8);
+    expect_rejected();
+
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "not a blocklist file, definitely not one at all, just some text padding here";
+    }
+    expect_rejected();
+
+    std::cout << "损坏文件测试通过！" << std::endl;
+}
+
+/**
+ * @brief 按文件头读出全部槽位，修改后写回
+ */
+template <typename Patch>
+void patch_slots(Patch patch)
+{
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    ngx::rule::blocklist_header header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+    std::vector<ngx::rule::suffix_slot> slots(header.capacity);
+    file.seekg(static_cast<std::streamoff>(header.slots));
+    file.read(reinterpret_cast<char *>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(ngx::rule::suffix_slot)));
+    patch(header, slots);
+    file.seekp(static_cast<std::streamoff>(header.slots));
+    file.write(reinterpret_cast<const char *>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(ngx::rule::suffix_slot)));
+}
+
+/**
+ * @brief 测试头部合法但槽位损坏的文件：越出名字池的槽位不匹配，没有空槽时查找仍然结束
+ */
+void test_corrupt_slots()
+{
+    std::cout << "=== 开始损坏槽位测试 ===" << std::endl;
+    blocklist::compile({"ads.example", "tracker.example"}, {}, path, false);
+
+    // 槽位引用的名字越出名字池
+    patch_slots([](const ngx::rule::blocklist_header &header, std::vector<ngx::rule::suffix_slot> &slots)
+    {
+        for (auto &slot : slots)
+        {
+            if (slot.length != 0)
+            {
+                slot.offset = static_cast<std::uint32_t>(header.names_size);
+            }
+        }
+    });
+    {
+        const auto list = blocklist::open(path);
+        assert(!list->domain("ads.example"));
+        assert(!list->domain("www.tracker.example"));
+    }
+
+    // 槽位数组没有空槽
+    patch_slots([](const ngx::rule::blocklist_header &, std::vector<ngx::rule::suffix_slot> &slots)
+    {
+        for (auto &slot : slots)
+        {
+            slot.length = 1;
+        }
+    });
+    {
+        const auto list = blocklist::open(path);
+        assert(!list->domain("ads.example"));
+        assert(!list->domain("clean.example"));
+    }
+
+    std::cout << "损坏槽位测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "预编译拦截列表模块测试启动..." << std::endl;
+
+    try
+    {
+        test_with_filter();
+        test_attach_to_blacklist();
+        test_without_filter();
+        test_corrupt_file();
+        test_corrupt_slots();
+
+        std::remove(path.c_str());
+        std::cout << "\n所有预编译拦截列表测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::remove(path.c_str());
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
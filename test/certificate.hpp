@@ -0,0 +1,43 @@
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <boost/asio/ssl.hpp>
+#include <openssl/ec.h>
+#include <openssl/evp.h>
+#include <openssl/obj_mac.h>
+#include <openssl/x509.h>
+
+/**
+ * @brief 为服务端上下文签发一张内存中的自签名证书（P-256）
+ * @param context 服务端 SSL 上下文
+ * @details 测试不依赖磁盘上的证书文件，客户端需关闭证书校验。
+ */
+inline void issue(boost::asio::ssl::context &context)
+{
+    const std::unique_ptr<EVP_PKEY_CTX, decltype(&EVP_PKEY_CTX_free)> generator(EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr), &EVP_PKEY_CTX_free);
+    EVP_PKEY *raw = nullptr;
+    if (!generator || EVP_PKEY_keygen_init(generator.get()) != 1
+        || EVP_PKEY_CTX_set_ec_paramgen_curve_nid(generator.get(), NID_X9_62_prime256v1) != 1
+        || EVP_PKEY_keygen(generator.get(), &raw) != 1)
+    {
+        throw std::runtime_error("生成测试密钥失败");
+    }
+    const std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(raw, &EVP_PKEY_free);
+
+    const std::unique_ptr<X509, decltype(&X509_free)> cert(X509_new(), &X509_free);
+    X509_set_version(cert.get(), 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert.get()), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert.get()), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert.get()), 86400);
+    X509_NAME *name = X509_get_subject_name(cert.get());
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("127.0.0.1"), -1, -1, 0);
+    X509_set_issuer_name(cert.get(), name);
+    X509_set_pubkey(cert.get(), key.get());
+    if (X509_sign(cert.get(), key.get(), EVP_sha256()) == 0
+        || SSL_CTX_use_certificate(context.native_handle(), cert.get()) != 1
+        || SSL_CTX_use_PrivateKey(context.native_handle(), key.get()) != 1)
+    {
+        throw std::runtime_error("签发测试证书失败");
+    }
+}
@@ -0,0 +1,42 @@
+#include <agent/frame.hpp>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+using namespace ngx::agent;
+
+int main()
+{
+    std::cout << "[Test] frame codec" << std::endl;
+
+    // 旧接口：序列化后再反序列化
+    const frame original(frame::type::data, 0x01020304, "payload");
+    const std::string wire = serialize(original);
+    assert(wire.size() == 5 + 7);
+
+    frame restored(frame::type::keepalive, 0, {});
+    assert(deserialize(wire, restored));
+    assert(restored.type() == frame::type::data);
+    assert(restored.stream_id() == 0x01020304);
+    assert(restored.data() == "payload");
+
+    // 新接口：帧头与旧格式逐字节一致
+    const auto header = encode(frame::type::data, 0x01020304);
+    assert(std::string(header.data(), header.size()) == wire.substr(0, 5));
+
+    // 视图指向原缓冲区，不复制负载
+    frame_view view;
+    assert(decode(wire, view));
+    assert(view.type == frame::type::data);
+    assert(view.stream_id == 0x01020304);
+    assert(view.data == "payload");
+    assert(view.data.data() == wire.data() + 5);
+
+    // 空负载与过短输入
+    const auto empty = serialize(frame(frame::type::window, 7, {}));
+    assert(decode(empty, view) && view.data.empty() && view.type == frame::type::window);
+    assert(!decode(std::string_view(wire.data(), 4), view));
+
+    std::cout << "[Test] frame codec passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include <agent/ingress.hpp>
+#include <array>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+using ngx::agent::ingress;
+
+using namespace std::string_view_literals;
+
+/**
+ * @brief 一次解析的结果
+ */
+struct outcome
+{
+    bool accepted = false;
+    ingress::request result;
+    std::string reply; // 解析过程中写回本地客户端的字节
+};
+
+/**
+ * @brief 客户端在回环连接上发送给定字节后关闭写方向，服务端运行解析协程
+ * @param bytes 客户端发送的数据，截断的请求在读到结尾时结束
+ * @param socks 按 SOCKS5 还是 HTTP 代理请求解析
+ */
+outcome exchange(const std::string_view bytes, const bool socks)
+{
+    net::io_context ioc;
+    tcp::acceptor acceptor(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+    tcp::socket client(ioc);
+    client.connect(acceptor.local_endpoint());
+    tcp::socket server = acceptor.accept();
+    net::write(client, net::buffer(bytes));
+    client.shutdown(tcp::socket::shutdown_send);
+
+    outcome out;
+    net::co_spawn(ioc, [&]() -> net::awaitable<void>
+    {
+        out.accepted = socks ? co_await ingress::socks_request(server, out.result)
+                             : co_await ingress::proxy_request(server, out.result);
+    }, net::detached);
+    ioc.run();
+    server.close();
+
+    std::array<char, 256> buffer{};
+    boost::system::error_code ec;
+    while (true)
+    {
+        const auto n = client.read_some(net::buffer(buffer), ec);
+        if (ec)
+        {
+            break;
+        }
+        out.reply.append(buffer.data(), n);
+    }
+    return out;
+}
+
+/**
+ * @brief 按错误码构造 SOCKS5 应答（绑定地址为 0.0.0.0:0）
+ */
+std::string socks_answer(const char code)
+{
+    return std::string("\x05", 1) + code + std::string("\x00\x01\x00\x00\x00\x00\x00\x00", 8);
+}
+
+/**
+ * @brief 测试 SOCKS5 的 IPv4 与域名 CONNECT 请求
+ */
+void test_socks_connect()
+{
+    std::cout << "=== 开始 SOCKS5 请求测试 ===" << std::endl;
+    const auto ipv4 = exchange("\x05\x01\x00" "\x05\x01\x00\x01\x5d\xb8\xd8\x22\x01\xbb"sv, true);
+    assert(ipv4.accepted);
+    assert(ipv4.result.destination == "93.184.216.34:443");
+    assert(ipv4.result.connect && ipv4.result.first.empty());
+    assert(ipv4.reply == "\x05\x00"sv);
+
+    // 多种认证方式中只要包含无认证即可
+    const auto domain = exchange("\x05\x02\x02\x00" "\x05\x01\x00\x03\x0b" "example.com" "\x00\x50"sv, true);
+    assert(domain.accepted);
+    assert(domain.result.destination == "example.com:80");
+    assert(domain.reply == "\x05\x00"sv);
+
+    std::cout << "SOCKS5 请求测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试格式错误或不支持的 SOCKS5 请求被拒绝
+ */
+void test_socks_rejected()
+{
+    std::cout << "=== 开始 SOCKS5 拒绝测试 ===" << std::endl;
+
+    // 版本号错误：不回复
+    const auto version = exchange("\x04\x01\x00"sv, true);
+    assert(!version.accepted && version.reply.empty());
+
+    // 没有提供任何认证方式
+    const auto empty = exchange("\x05\x00"sv, true);
+    assert(!empty.accepted && empty.reply.empty());
+
+    // 不提供无认证方式：回复 0xFF
+    const auto method = exchange("\x05\x01\x02"sv, true);
+    assert(!method.accepted && method.reply == "\x05\xff"sv);
+
+    // 请求头版本号错误
+    const auto head = exchange("\x05\x01\x00" "\x04\x01\x00\x01\x7f\x00\x00\x01\x00\x50"sv, true);
+    assert(!head.accepted && head.reply == "\x05\x00"sv);
+
+    // BIND 命令：回复不支持的命令
+    const auto bind = exchange("\x05\x01\x00" "\x05\x02\x00\x01\x7f\x00\x00\x01\x00\x50"sv, true);
+    assert(!bind.accepted && bind.reply == std::string("\x05\x00", 2) + socks_answer('\x07'));
+
+    // IPv6 地址：回复不支持的地址类型
+    const auto ipv6 = exchange("\x05\x01\x00" "\x05\x01\x00\x04" "\x20\x01\x0d\xb8\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x01" "\x01\xbb"sv, true);
+    assert(!ipv6.accepted && ipv6.reply == std::string("\x05\x00", 2) + socks_answer('\x08'));
+
+    // 域名长度声明 32 字节，实际只有 5 字节
+    const auto truncated = exchange("\x05\x01\x00" "\x05\x01\x00\x03\x20" "short"sv, true);
+    assert(!truncated.accepted && truncated.result.destination.empty());
+
+    // 空域名
+    const auto blank = exchange("\x05\x01\x00" "\x05\x01\x00\x03\x00" "\x00\x50"sv, true);
+    assert(!blank.accepted);
+
+    // 缺少端口
+    const auto portless = exchange("\x05\x01\x00" "\x05\x01\x00\x01\x7f\x00\x00\x01"sv, true);
+    assert(!portless.accepted);
+
+    std::cout << "SOCKS5 拒绝测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试 HTTP CONNECT 与绝对 URI 请求
+ */
+void test_proxy_request()
+{
+    std::cout << "=== 开始 HTTP 代理请求测试 ===" << std::endl;
+    const auto tunnel = exchange("CONNECT example.com:443 HTTP/1.1\r\nHost: example.com:443\r\n\r\n", false);
+    assert(tunnel.accepted);
+    assert(tunnel.result.destination == "example.com:443");
+    assert(tunnel.result.connect && tunnel.result.first.empty());
+    assert(tunnel.reply.empty());
+
+    // 请求头之后已经到达的数据作为首包
+    const auto eager = exchange("CONNECT example.com:8443 HTTP/1.1\r\nHost: example.com:8443\r\n\r\n\x16\x03\x01"sv, false);
+    assert(eager.accepted);
+    assert(eager.result.destination == "example.com:8443");
+    assert(eager.result.first == "\x16\x03\x01"sv);
+
+    // 绝对 URI：原请求作为首包
+    const auto absolute = exchange("GET http://example.com:8080/index.html HTTP/1.1\r\nHost: example.com:8080\r\n\r\n", false);
+    assert(absolute.accepted);
+    assert(absolute.result.destination == "example.com:8080");
+    assert(!absolute.result.connect);
+    assert(absolute.result.first.starts_with("GET "));
+    assert(absolute.result.first.find("example.com:8080") != std::string::npos);
+    assert(absolute.result.first.ends_with("\r\n\r\n"));
+
+    const auto plain = exchange("GET http://example.com/ HTTP/1.1\r\nHost: example.com\r\n\r\n", false);
+    assert(plain.accepted && plain.result.destination == "example.com:80");
+
+    std::cout << "HTTP 代理请求测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试非代理请求与格式错误的 HTTP 请求被拒绝
+ */
+void test_proxy_rejected()
+{
+    std::cout << "=== 开始 HTTP 代理拒绝测试 ===" << std::endl;
+
+    // 源站形式的请求不是代理请求
+    assert(!exchange("GET /index.html HTTP/1.1\r\nHost: example.com\r\n\r\n", false).accepted);
+
+    // 不是 HTTP
+    assert(!exchange("NOT A REQUEST\r\n\r\n", false).accepted);
+
+    // 请求头没有结束连接就关闭了
+    assert(!exchange("CONNECT example.com:443 HTTP/1.1\r\nHost: exa", false).accepted);
+
+    // 没有主机
+    assert(!exchange("CONNECT :443 HTTP/1.1\r\nHost: example.com\r\n\r\n", false).accepted);
+
+    std::cout << "HTTP 代理拒绝测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "本地接入模块测试启动..." << std::endl;
+
+    try
+    {
+        test_socks_connect();
+        test_socks_rejected();
+        test_proxy_request();
+        test_proxy_rejected();
+
+        std::cout << "\n所有本地接入测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,599 @@
+#include <agent/multiplex.hpp>
+#include <abnormal.hpp>
+#include "certificate.hpp"
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/beast.hpp>
+#include <boost/endian/conversion.hpp>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+namespace beast = boost::beast;
+using tcp = net::ip::tcp;
+using ngx::agent::frame;
+using ngx::agent::multiplex;
+using ngx::agent::option;
+using obscura = ngx::agent::obscura<tcp>;
+
+namespace
+{
+    std::shared_ptr<ssl::context> server_context;
+    std::shared_ptr<ssl::context> client_context;
+
+    const auto loopback = net::ip::make_address("127.0.0.1");
+}
+
+/**
+ * @brief 协程之间的一次性通知
+ */
+struct event
+{
+    explicit event(const net::any_io_executor &executor)
+        : timer(executor, net::steady_timer::time_point::max())
+    {
+    }
+
+    void notify()
+    {
+        fired = true;
+        timer.cancel();
+    }
+
+    net::awaitable<void> wait()
+    {
+        boost::system::error_code ec;
+        while (!fired)
+        {
+            co_await timer.async_wait(net::redirect_error(net::use_awaitable, ec));
+        }
+    }
+
+    net::steady_timer timer;
+    bool fired = false;
+};
+
+/**
+ * @brief 等待一段时间
+ */
+net::awaitable<void> rest(const std::chrono::milliseconds duration)
+{
+    net::steady_timer timer(co_await net::this_coro::executor, duration);
+    co_await timer.async_wait(net::use_awaitable);
+}
+
+/**
+ * @brief 轮询直到条件成立，超过 5 秒视为失败
+ */
+net::awaitable<void> until(const std::function<bool()> condition)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            throw std::runtime_error("等待条件超时");
+        }
+        co_await rest(std::chrono::milliseconds(1));
+    }
+}
+
+/**
+ * @brief 一对已完成握手的 obscura 连接
+ */
+struct tunnel
+{
+    std::shared_ptr<obscura> server;
+    std::shared_ptr<obscura> client;
+};
+
+/**
+ * @brief 在回环上建立一对 obscura 连接
+ * @param tiny 是否把服务端发送缓冲与客户端接收缓冲压到最小，让服务端写协程很快被对端读取速度卡住
+ */
+net::awaitable<tunnel> establish(const bool tiny)
+{
+    const auto executor = co_await net::this_coro::executor;
+    tcp::acceptor acceptor(executor, tcp::endpoint(loopback, 0));
+
+    tcp::socket near(executor);
+    near.open(tcp::v4());
+    if (tiny)
+    {
+        near.set_option(net::socket_base::receive_buffer_size(4096));
+    }
+    co_await near.async_connect(acceptor.local_endpoint(), net::use_awaitable);
+    tcp::socket far = co_await acceptor.async_accept(net::use_awaitable);
+    if (tiny)
+    {
+        far.set_option(net::socket_base::send_buffer_size(4096));
+    }
+
+    tunnel result{std::make_shared<obscura>(std::move(far), server_context, ngx::agent::role::server),
+        std::make_shared<obscura>(std::move(near), client_context, ngx::agent::role::client)};
+
+    // 两端握手必须并发进行
+    event accepted(executor);
+    std::exception_ptr failure;
+    net::co_spawn(executor, result.server->handshake(), [&](const std::exception_ptr &error, const std::string &)
+    {
+        failure = error;
+        accepted.notify();
+    });
+    co_await result.client->handshake("127.0.0.1", "/mux");
+    co_await accepted.wait();
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+    co_return result;
+}
+
+/**
+ * @brief 启动多路复用会话，结束时记录异常并发出通知
+ */
+void launch(const std::shared_ptr<multiplex> &mux, event &finished, std::exception_ptr &failure)
+{
+    net::co_spawn(finished.timer.get_executor(), mux->run(), [&finished, &failure](const std::exception_ptr &error)
+    {
+        failure = error;
+        finished.notify();
+    });
+}
+
+/**
+ * @brief 上游：回显收到的数据，直到对端关闭
+ */
+net::awaitable<void> echo(tcp::acceptor acceptor)
+{
+    tcp::socket socket = co_await acceptor.async_accept(net::use_awaitable);
+    std::array<char, 4096> buffer{};
+    boost::system::error_code ec;
+    while (true)
+    {
+        const auto n = co_await socket.async_read_some(net::buffer(buffer), net::redirect_error(net::use_awaitable, ec));
+        if (ec)
+        {
+            break;
+        }
+        co_await net::async_write(socket, net::buffer(buffer.data(), n), net::redirect_error(net::use_awaitable, ec));
+    }
+}
+
+/**
+ * @brief 上游：连接建立后写出指定字节数，然后保持连接直到对端关闭
+ */
+net::awaitable<void> flood(tcp::acceptor acceptor, const std::size_t size)
+{
+    tcp::socket socket = co_await acceptor.async_accept(net::use_awaitable);
+    const std::string payload(size, 'x');
+    boost::system::error_code ec;
+    co_await net::async_write(socket, net::buffer(payload), net::redirect_error(net::use_awaitable, ec));
+
+    char byte = 0;
+    co_await socket.async_read_some(net::buffer(&byte, 1), net::redirect_error(net::use_awaitable, ec));
+}
+
+/**
+ * @brief 开启一个上游，返回它的 `host:port`
+ * @param serve 上游行为（`echo` 或 `flood`）
+ */
+template <typename Serve>
+std::string origin(const net::any_io_executor &executor, Serve serve)
+{
+    tcp::acceptor acceptor(executor, tcp::endpoint(loopback, 0));
+    const auto port = acceptor.local_endpoint().port();
+    net::co_spawn(executor, serve(std::move(acceptor)), net::detached);
+    return "127.0.0.1:" + std::to_string(port);
+}
+
+/**
+ * @brief 解码后的一帧，负载已复制
+ */
+struct received
+{
+    enum frame::type type = frame::type::keepalive;
+    std::uint32_t id = 0;
+    std::string data;
+};
+
+/**
+ * @brief 手工驱动的一端：读取一帧
+ */
+net::awaitable<received> next(obscura &proto)
+{
+    beast::flat_buffer buffer;
+    const auto n = co_await proto.async_read(buffer);
+    ngx::agent::frame_view view;
+    if (!ngx::agent::decode(std::string_view(static_cast<const char *>(buffer.data().data()), n), view))
+    {
+        throw std::runtime_error("帧格式错误");
+    }
+    co_return received{view.type, view.stream_id, std::string(view.data)};
+}
+
+/**
+ * @brief 手工驱动的一端：发送一帧
+ */
+net::awaitable<void> send(obscura &proto, const enum frame::type type, const std::uint32_t id, const std::string_view data = {})
+{
+    const auto head = ngx::agent::encode(type, id);
+    const std::array<net::const_buffer, 2> buffers{net::buffer(head), net::buffer(data)};
+    co_await proto.async_write(buffers);
+}
+
+/**
+ * @brief 窗口增量负载（4 字节大端）
+ */
+std::string credit(const std::uint32_t value)
+{
+    const std::uint32_t big = boost::endian::native_to_big(value);
+    std::string payload(sizeof(big), '\0');
+    std::memcpy(payload.data(), &big, sizeof(big));
+    return payload;
+}
+
+/**
+ * @brief 确认服务端没有待发的数据帧：静默一段时间后发送探测，下一帧必须就是探测的回显
+ */
+net::awaitable<void> expect_quiet(obscura &proto)
+{
+    co_await rest(std::chrono::milliseconds(100));
+    co_await send(proto, frame::type::keepalive, 0, "probe");
+    const auto reply = co_await next(proto);
+    assert(reply.type == frame::type::keepalive && reply.data == "probe");
+}
+
+/**
+ * @brief 运行一个测试场景，场景结束后停止事件循环
+ */
+void drive(net::awaitable<void> (*scenario)(net::io_context &))
+{
+    net::io_context ioc;
+    bool finished = false;
+    net::co_spawn(ioc, scenario(ioc), [&](const std::exception_ptr &error)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+        finished = true;
+        ioc.stop();
+    });
+    ioc.run();
+    assert(finished);
+}
+
+/**
+ * @brief 流的建立、双向数据与关闭：客户端与服务端都是 `multiplex`
+ */
+net::awaitable<void> stream_scenario(net::io_context &ioc)
+{
+    const auto executor = ioc.get_executor();
+    ngx::agent::source pool(ioc);
+    ngx::agent::distributor dist(pool, ioc);
+    const option::multiplex_option opt{};
+
+    const auto link = co_await establish(false);
+    const auto server = std::make_shared<multiplex>(link.server, dist, opt);
+    const auto client = std::make_shared<multiplex>(link.client, opt);
+    event server_done(executor), client_done(executor);
+    std::exception_ptr server_error, client_error;
+    launch(server, server_done, server_error);
+    launch(client, client_done, client_error);
+
+    // 客户端收到服务端通告的初始窗口后才可用
+    co_await until([&] { return client->available(); });
+
+    // 本地接入的连接
+    tcp::acceptor local(executor, tcp::endpoint(loopback, 0));
+    tcp::socket app(executor);
+    co_await app.async_connect(local.local_endpoint(), net::use_awaitable);
+    tcp::socket peer = co_await local.async_accept(net::use_awaitable);
+    ngx::agent::internal_ptr accepted(new tcp::socket(std::move(peer)), ngx::agent::deleter{});
+    net::co_spawn(executor, client->relay(std::move(accepted), origin(executor, echo), "hello "), net::detached);
+
+    // 首包先于本地数据到达上游
+    co_await net::async_write(app, net::buffer(std::string_view("world")), net::use_awaitable);
+    std::string reply(11, '\0');
+    co_await net::async_read(app, net::buffer(reply), net::use_awaitable);
+    assert(reply == "hello world");
+    assert(client->load() == 1 && server->load() == 1);
+
+    // 本地关闭后流在两端都被移除，本地连接随之关闭
+    app.shutdown(tcp::socket::shutdown_send);
+    co_await until([&] { return client->load() == 0 && server->load() == 0; });
+    char byte = 0;
+    boost::system::error_code ec;
+    co_await app.async_read_some(net::buffer(&byte, 1), net::redirect_error(net::use_awaitable, ec));
+    assert(ec == net::error::eof);
+
+    // 上游不可达时服务端以 `close` 结束该流
+    std::string unreachable;
+    {
+        tcp::acceptor closed(executor, tcp::endpoint(loopback, 0));
+        unreachable = "127.0.0.1:" + std::to_string(closed.local_endpoint().port());
+    }
+    tcp::socket second(executor);
+    co_await second.async_connect(local.local_endpoint(), net::use_awaitable);
+    peer = co_await local.async_accept(net::use_awaitable);
+    ngx::agent::internal_ptr other(new tcp::socket(std::move(peer)), ngx::agent::deleter{});
+    net::co_spawn(executor, client->relay(std::move(other), unreachable), net::detached);
+    ec.clear();
+    co_await second.async_read_some(net::buffer(&byte, 1), net::redirect_error(net::use_awaitable, ec));
+    assert(ec);
+    co_await until([&] { return client->load() == 0 && server->load() == 0; });
+
+    // 中止底层连接后两端的 `run` 都结束；对端读到的是截断的 TLS 流，可能以异常结束
+    link.client->abort();
+    co_await client_done.wait();
+    co_await server_done.wait();
+    assert(!client_error);
+    assert(!client->available());
+}
+
+/**
+ * @brief 窗口耗尽后服务端停止发送，收到 `window` 帧后按增量恢复
+ */
+net::awaitable<void> window_scenario(net::io_context &ioc)
+{
+    const auto executor = ioc.get_executor();
+    ngx::agent::source pool(ioc);
+    ngx::agent::distributor dist(pool, ioc);
+    option::multiplex_option opt{};
+    opt.window = 65536;
+
+    const auto link = co_await establish(false);
+    const auto server = std::make_shared<multiplex>(link.server, dist, opt);
+    event server_done(executor);
+    std::exception_ptr server_error;
+    launch(server, server_done, server_error);
+    auto &peer = *link.client;
+
+    // 会话开始时服务端在流 0 上通告初始窗口
+    const auto announce = co_await next(peer);
+    assert(announce.type == frame::type::window && announce.id == 0 && announce.data == credit(65536));
+
+    co_await send(peer, frame::type::connect, 1, origin(executor, [](tcp::acceptor acceptor)
+    {
+        return flood(std::move(acceptor), 1 << 20);
+    }));
+
+    // 恰好收到一个窗口的数据
+    std::size_t total = 0;
+    while (total < opt.window)
+    {
+        const auto item = co_await next(peer);
+        assert(item.type == frame::type::data && item.id == 1);
+        total += item.data.size();
+    }
+    assert(total == opt.window);
+    co_await expect_quiet(peer);
+
+    // 归还 16 KiB 信用后恰好再收到 16 KiB
+    co_await send(peer, frame::type::window, 1, credit(16384));
+    total = 0;
+    while (total < 16384)
+    {
+        const auto item = co_await next(peer);
+        assert(item.type == frame::type::data && item.id == 1);
+        total += item.data.size();
+    }
+    assert(total == 16384);
+    co_await expect_quiet(peer);
+
+    // 客户端关闭流后服务端移除它
+    co_await send(peer, frame::type::close, 1);
+    co_await until([&] { return server->load() == 0; });
+
+    peer.abort();
+    co_await server_done.wait();
+    assert(server->load() == 0);
+}
+
+/**
+ * @brief 数据帧在流之间轮转：大流排满队列后，小流的数据不必等大流发完
+ * @details 服务端发送缓冲很小，写协程很快被卡住，大流的一个窗口（256 KiB）几乎全部积压在队列里。
+ * 按先进先出发送时小流要排在整个窗口之后，轮转时只需等大流一两帧。
+ */
+net::awaitable<void> fairness_scenario(net::io_context &ioc)
+{
+    const auto executor = ioc.get_executor();
+    ngx::agent::source pool(ioc);
+    ngx::agent::distributor dist(pool, ioc);
+    const option::multiplex_option opt{};
+
+    const auto link = co_await establish(true);
+    const auto server = std::make_shared<multiplex>(link.server, dist, opt);
+    event server_done(executor);
+    std::exception_ptr server_error;
+    launch(server, server_done, server_error);
+    auto &peer = *link.client;
+
+    const auto announce = co_await next(peer);
+    assert(announce.type == frame::type::window && announce.id == 0);
+
+    // 大流开始后停止读取，让它的队列排满
+    co_await send(peer, frame::type::connect, 1, origin(executor, [](tcp::acceptor acceptor)
+    {
+        return flood(std::move(acceptor), 4 << 20);
+    }));
+    auto item = co_await next(peer);
+    assert(item.type == frame::type::data && item.id == 1);
+    std::size_t bulk = item.data.size();
+    co_await rest(std::chrono::milliseconds(100));
+
+    co_await send(peer, frame::type::connect, 3, origin(executor, [](tcp::acceptor acceptor)
+    {
+        return flood(std::move(acceptor), 1000);
+    }));
+    co_await rest(std::chrono::milliseconds(100));
+
+    while (true)
+    {
+        item = co_await next(peer);
+        assert(item.type == frame::type::data);
+        if (item.id == 3)
+        {
+            break;
+        }
+        bulk += item.data.size();
+    }
+    assert(item.data.size() == 1000);
+    assert(bulk <= opt.window / 2);
+
+    peer.abort();
+    co_await server_done.wait();
+    assert(server->load() == 0);
+}
+
+/**
+ * @brief 保活：对端回显时连接保持可用；对端不回显时客户端中止连接，`run` 以异常结束
+ */
+net::awaitable<void> keepalive_scenario(net::io_context &ioc)
+{
+    const auto executor = ioc.get_executor();
+    ngx::agent::source pool(ioc);
+    ngx::agent::distributor dist(pool, ioc);
+    const option::multiplex_option opt{};
+
+    {
+        const auto link = co_await establish(false);
+        const auto server = std::make_shared<multiplex>(link.server, dist, opt);
+        const auto client = std::make_shared<multiplex>(link.client, opt);
+        client->heartbeat(std::chrono::milliseconds(100));
+        event server_done(executor), client_done(executor);
+        std::exception_ptr server_error, client_error;
+        launch(server, server_done, server_error);
+        launch(client, client_done, client_error);
+
+        // 经过多个探测周期仍然可用
+        co_await until([&] { return client->available(); });
+        co_await rest(std::chrono::milliseconds(500));
+        assert(client->available() && !client_done.fired);
+
+        link.server->abort();
+        co_await client_done.wait();
+        co_await server_done.wait();
+        assert(!server_error);
+        assert(!client->available());
+    }
+
+    {
+        const auto link = co_await establish(false);
+        const auto client = std::make_shared<multiplex>(link.client, opt);
+        client->heartbeat(std::chrono::milliseconds(100));
+        event client_done(executor);
+        std::exception_ptr client_error;
+        launch(client, client_done, client_error);
+
+        // 手工驱动的服务端通告窗口，之后只读不回显
+        auto &peer = *link.server;
+        co_await send(peer, frame::type::window, 0, credit(65536));
+        co_await until([&] { return client->available(); });
+
+        std::size_t probes = 0;
+        try
+        {
+            while (true)
+            {
+                const auto probe = co_await next(peer);
+                assert(probe.type == frame::type::keepalive && probe.id == 0);
+                ++probes;
+            }
+        }
+        catch (const boost::system::system_error &)
+        {
+            // 客户端中止了连接
+        }
+        co_await client_done.wait();
+        assert(probes >= 1);
+        assert(client_error);
+        assert(!client->available());
+
+        bool timed_out = false;
+        try
+        {
+            std::rethrow_exception(client_error);
+        }
+        catch (const ngx::abnormal::protocol_error &)
+        {
+            timed_out = true;
+        }
+        assert(timed_out);
+    }
+}
+
+/**
+ * @brief 测试流的建立、数据与关闭
+ */
+void test_stream()
+{
+    std::cout << "=== 开始流生命周期测试 ===" << std::endl;
+    drive(stream_scenario);
+    std::cout << "流生命周期测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试窗口耗尽与恢复
+ */
+void test_window()
+{
+    std::cout << "=== 开始流量控制测试 ===" << std::endl;
+    drive(window_scenario);
+    std::cout << "流量控制测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试大流与小流之间的轮转公平性
+ */
+void test_fairness()
+{
+    std::cout << "=== 开始轮转公平性测试 ===" << std::endl;
+    drive(fairness_scenario);
+    std::cout << "轮转公平性测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试保活探测与中止
+ */
+void test_keepalive()
+{
+    std::cout << "=== 开始保活测试 ===" << std::endl;
+    drive(keepalive_scenario);
+    std::cout << "保活测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "多路复用模块测试启动..." << std::endl;
+
+    try
+    {
+        server_context = std::make_shared<ssl::context>(ssl::context::tlsv12);
+        issue(*server_context);
+        client_context = std::make_shared<ssl::context>(ssl::context::tlsv12);
+        client_context->set_verify_mode(ssl::verify_none);
+
+        test_stream();
+        test_window();
+        test_fairness();
+        test_keepalive();
+
+        std::cout << "\n所有多路复用测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
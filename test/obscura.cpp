@@ -1,4 +1,5 @@
 #include <agent/obscura.hpp>
+#include "certificate.hpp"
 #include <boost/asio.hpp>
 #include <boost/asio/ssl.hpp>
 #include <boost/beast.hpp>
@@ -124,6 +125,102 @@ net::awaitable<void> do_client(tcp::endpoint endpoint, std::shared_ptr<ssl::cont
     }
 }
 
+/**
+ * @brief 首包测试的服务端协程
+ * @param acceptor TCP 接收器
+ * @param ctx SSL 上下文
+ * @param take 是否取走随升级请求携带的首包；不取走时 101 响应不带确认，客户端应把首包作为第一条消息重发
+ * @return net::awaitable<void>
+ * @details 服务端依次收到首包与随后的普通消息，拼接后回显给客户端校验。
+ */
+net::awaitable<void> do_early_server(tcp::acceptor &acceptor, std::shared_ptr<ssl::context> ctx, bool take)
+{
+    try
+    {
+        auto socket = co_await acceptor.async_accept(net::use_awaitable);
+        auto agent = std::make_shared<ngx::agent::obscura<tcp>>(std::move(socket), ctx, ngx::agent::role::server);
+
+        co_await agent->accept_request();
+        std::string first = take ? agent->early() : std::string();
+        co_await agent->accept_upgrade();
+
+        beast::flat_buffer buffer;
+        if (!take)
+        {
+            co_await agent->async_read(buffer);
+            first = beast::buffers_to_string(buffer.data());
+            buffer.consume(buffer.size());
+        }
+        co_await agent->async_read(buffer);
+        const std::string next = beast::buffers_to_string(buffer.data());
+
+        co_await agent->async_write(first + "|" + next);
+        co_await agent->close();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "首包服务器发生异常: " << e.what() << std::endl;
+    }
+}
+
+/**
+ * @brief 首包测试的客户端协程
+ * @param endpoint 目标服务器端点
+ * @param ctx SSL 上下文
+ * @param early 随握手发送的首包
+ * @param passed 校验通过时置为 `true`
+ * @return net::awaitable<void>
+ * @details 无论服务端是否确认，服务端收到的首包都只有一份，且排在握手之后的普通消息之前。
+ */
+net::awaitable<void> do_early_client(tcp::endpoint endpoint, std::shared_ptr<ssl::context> ctx, std::string early, bool &passed)
+{
+    tcp::socket socket(co_await net::this_coro::executor);
+    co_await socket.async_connect(endpoint, net::use_awaitable);
+
+    auto agent = std::make_shared<ngx::agent::obscura<tcp>>(std::move(socket), ctx, ngx::agent::role::client);
+    co_await agent->handshake("127.0.0.1", "/secret", early);
+    co_await agent->async_write(std::string_view("after"));
+
+    beast::flat_buffer buffer;
+    co_await agent->async_read(buffer);
+    const std::string reply = beast::buffers_to_string(buffer.data());
+    if (reply != early + "|after")
+    {
+        throw std::runtime_error("首包校验失败: 收到 " + reply);
+    }
+    passed = true;
+
+    co_await agent->close();
+}
+
+/**
+ * @brief 运行一次首包测试
+ * @param take 服务端是否取走并确认首包
+ * @param early 首包
+ */
+void run_early(std::shared_ptr<ssl::context> server_ctx, std::shared_ptr<ssl::context> client_ctx, bool take, const std::string &early)
+{
+    net::io_context ioc;
+    tcp::acceptor acceptor(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+
+    bool passed = false;
+    net::co_spawn(ioc, do_early_server(acceptor, server_ctx, take), net::detached);
+    net::co_spawn(ioc, do_early_client(acceptor.local_endpoint(), client_ctx, early, passed),
+        [](const std::exception_ptr &error)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        });
+    ioc.run();
+
+    if (!passed)
+    {
+        throw std::runtime_error("首包测试未完成");
+    }
+}
+
 /**
  * @brief 测试入口函数
  * @return int 状态码
@@ -137,8 +234,7 @@ int main()
 
         // 初始化服务器 SSL 上下文
         auto server_ctx = std::make_shared<ssl::context>(ssl::context::tlsv12);
-        server_ctx->use_certificate_chain_file("C:\\Users\\C1373\\Desktop\\ForwardEngine\\cert.pem");
-        server_ctx->use_private_key_file("C:\\Users\\C1373\\Desktop\\ForwardEngine\\key.pem", ssl::context::pem);
+        issue(*server_ctx);
 
         // 初始化客户端 SSL 上下文，忽略证书验证（用于自签名证书测试）
         auto client_ctx = std::make_shared<ssl::context>(ssl::context::tlsv12);
@@ -164,6 +260,18 @@ int main()
         // 运行 I/O 事件循环
         ioc.run();
 
+        // 测试用例 3：服务端取走首包并在 101 响应中确认，客户端不再重发
+        std::cout << "运行测试用例 3: 首包确认测试..." << std::endl;
+        run_early(server_ctx, client_ctx, true, "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n");
+
+        // 测试用例 4：服务端没有确认首包，客户端把首包作为第一条消息重发
+        std::cout << "运行测试用例 4: 首包未确认重发测试..." << std::endl;
+        run_early(server_ctx, client_ctx, false, "GET / HTTP/1.1\r\nHost: example.com\r\n\r\n");
+
+        // 测试用例 5：超出上限的首包不随升级请求携带，握手后作为普通消息发送
+        std::cout << "运行测试用例 5: 超长首包测试..." << std::endl;
+        run_early(server_ctx, client_ctx, false, std::string(ngx::agent::obscura<tcp>::early_limit + 1, 'x'));
+
         std::cout << "\n所有 Obscura 协议测试已完成并通过！" << std::endl;
     }
     catch (const std::exception &e)
@@ -0,0 +1,160 @@
+#include <agent/offload.hpp>
+#include <cassert>
+#include <future>
+#include <iostream>
+#include <latch>
+#include <stdexcept>
+#include <thread>
+
+namespace net = boost::asio;
+using ngx::agent::offload;
+
+/**
+ * @brief 一次提交的结果
+ */
+struct outcome
+{
+    int value = 0;
+    bool rejected = false;
+    bool failed = false;
+    std::thread::id worker;  // 任务实际运行的线程
+    std::thread::id resumed; // 提交方恢复时所在的线程
+};
+
+/**
+ * @brief 在池线程上阻塞到闸门打开，模拟耗时的握手计算
+ */
+net::awaitable<int> blocked(std::shared_future<void> gate, const int value, std::thread::id &worker)
+{
+    worker = std::this_thread::get_id();
+    gate.wait();
+    if (value < 0)
+    {
+        throw std::runtime_error("握手失败");
+    }
+    co_return value;
+}
+
+/**
+ * @brief 经线程池执行任务并记录结果
+ */
+net::awaitable<void> submit(offload &pool, std::shared_future<void> gate, const int value, outcome &out)
+{
+    try
+    {
+        out.value = co_await pool.run(blocked(gate, value, out.worker));
+    }
+    catch (const ngx::abnormal::network_error &)
+    {
+        out.rejected = true;
+    }
+    catch (const std::runtime_error &)
+    {
+        out.failed = true;
+    }
+    out.resumed = std::this_thread::get_id();
+}
+
+/**
+ * @brief 测试排队数达到上限后立即拒绝，名额在任务结束（含失败）后归还
+ * @details 单线程池被第一个任务占住，第二个任务在队列中等待，第三个任务超出上限。
+ */
+void test_capacity()
+{
+    std::cout << "=== 开始排队上限测试 ===" << std::endl;
+    net::io_context ioc;
+    offload pool(1, 2);
+    std::promise<void> release;
+    const std::shared_future<void> gate = release.get_future().share();
+
+    outcome first;
+    outcome second;
+    outcome third;
+    net::co_spawn(ioc, submit(pool, gate, 1, first), net::detached);
+    net::co_spawn(ioc, submit(pool, gate, -1, second), net::detached);
+    net::co_spawn(ioc, submit(pool, gate, 3, third), net::detached);
+    net::post(ioc, [&]
+    {
+        // 三次提交都已开始：前两个占满名额，第三个已被拒绝
+        assert(pool.depth() == 2);
+        assert(third.rejected);
+        release.set_value();
+    });
+    ioc.run();
+
+    assert(first.value == 1 && !first.rejected && !first.failed);
+    assert(second.failed && !second.rejected);
+    assert(third.rejected && third.worker == std::thread::id());
+    assert(pool.depth() == 0);
+
+    // 任务在池线程上运行，完成后回到提交方的线程
+    const auto caller = std::this_thread::get_id();
+    assert(first.worker != caller && first.resumed == caller);
+    assert(second.resumed == caller);
+
+    // 名额归还后可以再次提交
+    outcome fourth;
+    ioc.restart();
+    net::co_spawn(ioc, submit(pool, gate, 4, fourth), net::detached);
+    ioc.run();
+    assert(fourth.value == 4 && pool.depth() == 0);
+
+    std::cout << "排队上限测试通过！" << std::endl;
+}
+
+/**
+ * @brief 等到全部任务都已开始后返回
+ */
+net::awaitable<int> rendezvous(std::latch &started, const int value)
+{
+    started.arrive_and_wait();
+    co_return value;
+}
+
+/**
+ * @brief 测试多线程池上的任务并行执行
+ * @details 每个任务都要等到全部任务开始后才能结束，串行执行时会永远等下去。
+ */
+void test_parallel()
+{
+    std::cout << "=== 开始并行执行测试 ===" << std::endl;
+    constexpr int count = 4;
+    net::io_context ioc;
+    offload pool(count, count);
+
+    std::latch started(count);
+    int total = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        net::co_spawn(ioc, pool.run(rendezvous(started, i)), [&total](const std::exception_ptr &error, const int value)
+        {
+            assert(!error);
+            total += value;
+        });
+    }
+    ioc.run();
+    assert(total == 0 + 1 + 2 + 3);
+    assert(pool.depth() == 0);
+
+    std::cout << "并行执行测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "握手卸载模块测试启动..." << std::endl;
+
+    try
+    {
+        test_capacity();
+        test_parallel();
+
+        std::cout << "\n所有握手卸载测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
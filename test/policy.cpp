@@ -0,0 +1,224 @@
+#include <rule/policy.hpp>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace net = boost::asio;
+using ngx::rule::action;
+using ngx::rule::address_key;
+using ngx::rule::interval_map;
+using ngx::rule::keyword_automaton;
+using ngx::rule::policy;
+using ngx::rule::suffix_table;
+using ngx::rule::npos;
+
+/**
+ * @brief 测试后缀表的精确与子域名两种匹配，忽略大小写
+ */
+void test_suffix_table()
+{
+    std::cout << "=== 开始后缀表测试 ===" << std::endl;
+    suffix_table table;
+    assert(table.insert("Example.com", 3, true));
+    assert(table.insert("exact.org", 1, false));
+    assert(table.insert("*.ads.net", 2, true));
+    assert(!table.insert("", 0, true));
+
+    assert(table.find("example.com") == 3);
+    assert(table.find("A.B.EXAMPLE.COM") == 3);
+    assert(table.find("notexample.com") == npos);
+    assert(table.find("exact.org") == 1);
+    assert(table.find("www.exact.org") == npos);
+    assert(table.find("x.ads.net.") == 2);
+    assert(table.find("com") == npos);
+
+    // 大量条目不影响已有条目
+    for (std::uint32_t i = 0; i < 10000; ++i)
+    {
+        assert(table.insert("host" + std::to_string(i) + ".bulk.io", 100 + i, true));
+    }
+    assert(table.size() == 10003);
+    assert(table.find("a.host9999.bulk.io") == 10099);
+    assert(table.find("example.com") == 3);
+
+    std::cout << "后缀表测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试关键字自动机在任意位置匹配，命中多个时取最小值
+ */
+void test_keyword_automaton()
+{
+    std::cout << "=== 开始关键字匹配测试 ===" << std::endl;
+    keyword_automaton automaton;
+    automaton.insert("ads", 5);
+    automaton.insert("track", 2);
+    automaton.insert("dsp", 7);
+    automaton.compile();
+
+    assert(automaton.find("cdn.ADS.example.com") == 5);
+    assert(automaton.find("tracker.io") == 2);
+    assert(automaton.find("adsp.io") == 5);
+    assert(automaton.find("x.dsp.io") == 7);
+    assert(automaton.find("example.com") == npos);
+
+    std::cout << "关键字匹配测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试区间表重叠区间取最小值，端点处精确
+ */
+void test_interval_map()
+{
+    std::cout << "=== 开始区间表测试 ===" << std::endl;
+    interval_map<std::uint16_t> ports;
+    ports.insert(8000, 9000, 4);
+    ports.insert(8080, 8080, 1);
+    ports.insert(65535, 65535, 9);
+    ports.compile();
+
+    assert(ports.find(7999) == npos);
+    assert(ports.find(8000) == 4);
+    assert(ports.find(8080) == 1);
+    assert(ports.find(8081) == 4);
+    assert(ports.find(9001) == npos);
+    assert(ports.find(65535) == 9);
+
+    interval_map<address_key> addresses;
+    address_key first, last;
+    assert(ngx::rule::parse_network("10.0.0.0/8", first, last));
+    addresses.insert(first, last, 6);
+    assert(ngx::rule::parse_network("10.1.0.0-10.1.255.255", first, last));
+    addresses.insert(first, last, 2);
+    assert(ngx::rule::parse_network("fc00::/7", first, last));
+    addresses.insert(first, last, 3);
+    assert(ngx::rule::parse_network("0.0.0.0/0", first, last));
+    addresses.insert(first, last, 8);
+    assert(!ngx::rule::parse_network("10.0.0.0/33", first, last));
+    assert(!ngx::rule::parse_network("bogus", first, last));
+    addresses.compile();
+
+    const auto find = [&addresses](const char *text)
+    {
+        return addresses.find(address_key::from(net::ip::make_address(text)));
+    };
+    assert(find("10.2.3.4") == 6);
+    assert(find("10.1.3.4") == 2);
+    assert(find("11.0.0.1") == 8);
+    assert(find("fd00::1") == 3);
+    assert(find("2001:db8::1") == npos);
+
+    std::cout << "区间表测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试规则集按顺序优先，域名规则可免解析，地址规则排在前面时要求解析
+ */
+void test_rule_order()
+{
+    std::cout << "=== 开始规则顺序测试 ===" << std::endl;
+    const std::string geoip = "policy_test_geoip.csv";
+    {
+        std::ofstream file(geoip);
+        file << "# start,end,region\n1.0.0.0,1.0.0.255,CN\n8.8.8.0,8.8.8.255,US\n";
+    }
+
+    policy rules;
+    rules.compile({
+                      "DOMAIN-SUFFIX,blocked.com,REJECT",
+                      "DOMAIN-KEYWORD,ads,REJECT",
+                      "DOMAIN,corp.internal,corp",
+                      "DST-PORT,25,REJECT",
+                      "IP-CIDR,192.168.0.0/16,DIRECT",
+                      "GEOIP,cn,DIRECT",
+                      "DOMAIN-SUFFIX,google.com,corp",
+                      "MATCH,corp",
+                  },
+                  {"corp"}, geoip);
+    std::remove(geoip.c_str());
+
+    auto v = rules.decide("www.blocked.com", 443);
+    assert(!v.resolve && v.kind == action::reject && v.rule == 0);
+    v = rules.decide("myads.net", 443);
+    assert(!v.resolve && v.kind == action::reject && v.rule == 1);
+    v = rules.decide("CORP.internal", 443);
+    assert(!v.resolve && v.kind == action::parent && v.parent == 0);
+    v = rules.decide("mail.example.com", 25);
+    assert(!v.resolve && v.kind == action::reject && v.rule == 3);
+
+    // google.com 排在地址规则之后，必须解析后才能确定
+    v = rules.decide("www.google.com", 443);
+    assert(v.resolve);
+    v = rules.decide("www.google.com", 443, net::ip::make_address("192.168.1.1"));
+    assert(v.kind == action::direct && v.rule == 4);
+    v = rules.decide("www.google.com", 443, net::ip::make_address("8.8.8.8"));
+    assert(v.kind == action::parent && v.rule == 6);
+    v = rules.decide("example.cn", 443, net::ip::make_address("1.0.0.7"));
+    assert(v.kind == action::direct && v.rule == 5);
+    v = rules.decide("example.org", 443, net::ip::make_address("9.9.9.9"));
+    assert(v.kind == action::parent && v.rule == 7);
+
+    std::cout << "规则顺序测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试无规则时直连，未知目标与格式错误的规则在编译时抛出
+ */
+void test_empty_and_invalid()
+{
+    std::cout << "=== 开始空规则与无效规则测试 ===" << std::endl;
+    policy rules;
+    assert(rules.empty());
+    const auto v = rules.decide("example.com", 443);
+    assert(!v.resolve && v.kind == action::direct && v.rule == npos);
+
+    bool thrown = false;
+    try
+    {
+        rules.compile({"DOMAIN,example.com,nowhere"}, {});
+    }
+    catch (const std::exception &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    thrown = false;
+    try
+    {
+        rules.compile({"DST-PORT,70000,REJECT"}, {});
+    }
+    catch (const std::exception &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << "空规则与无效规则测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "出站策略模块测试启动..." << std::endl;
+
+    try
+    {
+        test_suffix_table();
+        test_keyword_automaton();
+        test_interval_map();
+        test_rule_order();
+        test_empty_and_invalid();
+
+        std::cout << "\n所有出站策略测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,215 @@
+#include <agent/quota.hpp>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace net = boost::asio;
+using ngx::agent::option;
+using ngx::agent::quota;
+
+/**
+ * @brief 解析地址文本
+ */
+net::ip::address address(const char *text)
+{
+    return net::ip::make_address(text);
+}
+
+/**
+ * @brief 测试未配置任何限制时发放空凭证
+ */
+void test_disabled()
+{
+    std::cout << "=== 开始未启用配额测试 ===" << std::endl;
+    const option::quota_option opt{};
+    assert(!quota::enabled(opt));
+    quota table(opt);
+
+    auto granted = table.enter(address("192.0.2.1"));
+    assert(granted && !*granted);
+    assert(!granted->level().meter);
+
+    std::cout << "未启用配额测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试连接速率突发用完后拒绝，地址之间互不影响
+ */
+void test_connection_rate()
+{
+    std::cout << "=== 开始连接速率测试 ===" << std::endl;
+    option::quota_option opt{};
+    opt.rate = 1;
+    opt.burst = 3;
+    quota table(opt);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        assert(table.enter(address("192.0.2.1")));
+    }
+    assert(!table.enter(address("192.0.2.1")));
+
+    // IPv4 映射地址与 IPv4 是同一客户端
+    assert(!table.enter(address("::ffff:192.0.2.1")));
+    assert(table.enter(address("192.0.2.2")));
+    assert(table.enter(address("2001:db8::1")));
+
+    std::cout << "连接速率测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试并发会话数达到上限时拒绝，凭证析构后归还，移动后只归还一次
+ */
+void test_session_limit()
+{
+    std::cout << "=== 开始并发会话测试 ===" << std::endl;
+    option::quota_option opt{};
+    opt.sessions = 2;
+    quota table(opt);
+
+    auto first = table.enter(address("198.51.100.7"));
+    auto second = table.enter(address("198.51.100.7"));
+    assert(first && *first && second && *second);
+    assert(!table.enter(address("198.51.100.7")));
+
+    first.reset();
+    auto third = table.enter(address("198.51.100.7"));
+    assert(third && *third);
+
+    quota::pass moved = std::move(*third);
+    third.reset();
+    assert(!table.enter(address("198.51.100.7")));
+    moved = quota::pass{};
+    assert(table.enter(address("198.51.100.7")));
+
+    std::cout << "并发会话测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试带宽作为整形的客户端层级，桶深一秒，同一地址的会话共享
+ */
+void test_bandwidth_level()
+{
+    std::cout << "=== 开始客户端带宽测试 ===" << std::endl;
+    option::quota_option opt{};
+    opt.bandwidth = 1000000;
+    quota table(opt);
+
+    auto one = table.enter(address("203.0.113.9"));
+    auto two = table.enter(address("203.0.113.9"));
+    auto other = table.enter(address("203.0.113.10"));
+    const auto first = one->level();
+    assert(first.meter && first.limit && first.limit->bytes == 1000000);
+    assert(two->level().meter == first.meter);
+    assert(other->level().meter != first.meter);
+
+    // 固定同一时刻，结果与运行快慢无关
+    const auto time = ngx::agent::shaper::now();
+    assert(first.meter->allowance(*first.limit, time) == 1000000);
+    first.meter->charge(*first.limit, 600000, time);
+    assert(two->level().meter->allowance(*first.limit, time) == 400000);
+    assert(other->level().meter->allowance(*first.limit, time) == 1000000);
+
+    // 未限制带宽时没有客户端层级
+    option::quota_option plain{};
+    plain.sessions = 4;
+    quota unlimited(plain);
+    assert(!unlimited.enter(address("203.0.113.9"))->level().meter);
+
+    std::cout << "客户端带宽测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试内存有界：远超容量的客户端轮换进入，有存活会话的槽位不被淘汰
+ */
+void test_bounded_table()
+{
+    std::cout << "=== 开始槽位淘汰测试 ===" << std::endl;
+    option::quota_option opt{};
+    opt.sessions = 1;
+    opt.clients = 1024;
+    quota table(opt);
+    assert(table.capacity() == 1024);
+
+    std::vector<quota::pass> live;
+    for (std::uint32_t i = 0; i < 100000; ++i)
+    {
+        auto granted = table.enter(net::ip::address_v4(0x0a000000u + i));
+        assert(granted);
+        if (i < 256)
+        {
+            live.push_back(std::move(*granted));
+        }
+    }
+
+    for (std::uint32_t i = 0; i < 256; ++i)
+    {
+        assert(live[i]);
+        assert(!table.enter(net::ip::address_v4(0x0a000000u + i)));
+    }
+
+    std::cout << "槽位淘汰测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试多线程并发接入同一地址，并发会话数不超过上限
+ */
+void test_concurrent_enter()
+{
+    std::cout << "=== 开始并发接入测试 ===" << std::endl;
+    option::quota_option opt{};
+    opt.sessions = 64;
+    quota table(opt);
+
+    std::atomic<int> admitted{0};
+    std::vector<std::thread> threads;
+    std::vector<std::vector<quota::pass>> held(8);
+    for (int t = 0; t < 8; ++t)
+    {
+        threads.emplace_back([&, t]
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                if (auto granted = table.enter(net::ip::make_address("192.0.2.77")))
+                {
+                    admitted.fetch_add(1);
+                    held[t].push_back(std::move(*granted));
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    assert(admitted.load() == 64);
+
+    std::cout << "并发接入测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "客户端配额模块测试启动..." << std::endl;
+
+    try
+    {
+        test_disabled();
+        test_connection_rate();
+        test_session_limit();
+        test_bandwidth_level();
+        test_bounded_table();
+        test_concurrent_enter();
+
+        std::cout << "\n所有客户端配额测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
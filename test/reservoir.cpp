@@ -0,0 +1,144 @@
+#include <agent/reservoir.hpp>
+#include <boost/asio.hpp>
+#include <cassert>
+#include <iostream>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace net = boost::asio;
+using ngx::agent::reservoir;
+
+/**
+ * @brief 取出租约的两个半槽位的起始地址
+ */
+std::pair<const void *, const void *> halves(const reservoir::lease &item)
+{
+    return {net::buffer(item.left()).data(), net::buffer(item.right()).data()};
+}
+
+/**
+ * @brief 测试租约的两个半槽位大小正确且互不重叠
+ */
+void test_lease_layout()
+{
+    std::cout << "=== 开始槽位布局测试 ===" << std::endl;
+    net::io_context ioc;
+    reservoir pool(ioc, 4);
+    assert(pool.capacity() == 4);
+
+    std::vector<reservoir::lease> leases;
+    std::set<const void *> starts;
+    for (std::size_t i = 0; i < pool.capacity(); ++i)
+    {
+        auto item = pool.acquire();
+        assert(item);
+        assert(net::buffer(item.left()).size() == reservoir::slot_size / 2);
+        assert(net::buffer(item.right()).size() == reservoir::slot_size / 2);
+
+        const auto [left, right] = halves(item);
+        assert(static_cast<const std::byte *>(right) - static_cast<const std::byte *>(left)
+            == static_cast<std::ptrdiff_t>(reservoir::slot_size / 2));
+        assert(starts.insert(left).second);
+        assert(starts.insert(right).second);
+        leases.push_back(std::move(item));
+    }
+    assert(starts.size() == pool.capacity() * 2);
+
+    std::cout << "槽位布局测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试缓冲池耗尽时返回空租约，归还后可以再次租用
+ */
+void test_exhaustion_and_release()
+{
+    std::cout << "=== 开始耗尽与归还测试 ===" << std::endl;
+    net::io_context ioc;
+    reservoir pool(ioc, 2);
+
+    auto first = pool.acquire();
+    auto second = pool.acquire();
+    assert(first && second);
+
+    // 耗尽：调用方应退回自带缓冲区
+    const auto empty = pool.acquire();
+    assert(!empty);
+
+    // 归还后重新租到同一个槽位
+    const auto released = halves(first).first;
+    first = reservoir::lease{};
+    auto again = pool.acquire();
+    assert(again);
+    assert(halves(again).first == released);
+    assert(!pool.acquire());
+
+    std::cout << "耗尽与归还测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试租约移动后槽位只归还一次
+ */
+void test_lease_move()
+{
+    std::cout << "=== 开始租约移动测试 ===" << std::endl;
+    net::io_context ioc;
+    reservoir pool(ioc, 1);
+
+    {
+        auto origin = pool.acquire();
+        reservoir::lease moved(std::move(origin));
+        assert(!origin);
+        assert(moved);
+
+        reservoir::lease assigned;
+        assigned = std::move(moved);
+        assert(!moved);
+        assert(assigned);
+        assert(!pool.acquire());
+    }
+
+    // 只归还了一次：恰好能再租到一个
+    auto item = pool.acquire();
+    assert(item);
+    assert(!pool.acquire());
+
+    std::cout << "租约移动测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试零槽位的缓冲池不提供任何租约
+ */
+void test_empty_pool()
+{
+    std::cout << "=== 开始空缓冲池测试 ===" << std::endl;
+    net::io_context ioc;
+    reservoir pool(ioc, 0);
+    assert(pool.capacity() == 0);
+    assert(!pool.acquire());
+    assert(!pool.registered());
+
+    std::cout << "空缓冲池测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "隧道缓冲池模块测试启动..." << std::endl;
+
+    try
+    {
+        test_lease_layout();
+        test_exhaustion_and_release();
+        test_lease_move();
+        test_empty_pool();
+
+        std::cout << "\n所有隧道缓冲池测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <agent/router.hpp>
+#include <cassert>
+#include <iostream>
+#include <string>
+
+using ngx::agent::router;
+
+/**
+ * @brief 测试主机匹配：精确优先于通配，深的通配优先于浅的，`*` 兜底
+ */
+void test_host_match()
+{
+    std::cout << "=== 开始主机匹配测试 ===" << std::endl;
+    router table;
+    assert(table.empty());
+    assert(table.insert("example.com", "", 1));
+    assert(table.insert("*.example.com", "", 2));
+    assert(table.insert("*.api.example.com", "", 3));
+    assert(table.insert("www.example.com", "", 4));
+    assert(table.insert("*", "", 5));
+    assert(!table.empty());
+
+    assert(table.find("example.com", "/") == 1);
+    assert(table.find("a.example.com", "/") == 2);
+    assert(table.find("a.b.example.com", "/") == 2);
+    assert(table.find("v1.api.example.com", "/") == 3);
+    assert(table.find("api.example.com", "/") == 2);
+    assert(table.find("www.example.com", "/") == 4);
+    assert(table.find("other.org", "/") == 5);
+    assert(table.find("", "/") == router::npos);
+
+    std::cout << "主机匹配测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试主机名忽略大小写，端口与结尾的点被去掉
+ */
+void test_host_normalization()
+{
+    std::cout << "=== 开始主机名规范化测试 ===" << std::endl;
+    router table;
+    assert(table.insert("Example.COM", "", 7));
+    assert(table.insert("[::1]:8080", "", 8));
+
+    assert(table.find("EXAMPLE.com:8080", "/") == 7);
+    assert(table.find("example.com.", "/") == 7);
+    assert(table.find("::1", "/") == 8);
+    assert(table.find("[::1]:443", "/") == 8);
+    assert(table.find("example.org", "/") == router::npos);
+    assert(table.find("com", "/") == router::npos);
+
+    std::cout << "主机名规范化测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试无效主机被拒绝，路由表不变
+ */
+void test_invalid_host()
+{
+    std::cout << "=== 开始无效主机测试 ===" << std::endl;
+    router table;
+    assert(!table.insert("", "", 1));
+    assert(!table.insert("a..com", "", 1));
+    assert(!table.insert("*.*.com", "", 1));
+    assert(!table.insert("a.*.com", "", 1));
+    assert(table.empty());
+
+    std::cout << "无效主机测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试路径最长前缀匹配，边在插入时拆分；主机选定后路径不匹配即失败
+ */
+void test_path_prefix()
+{
+    std::cout << "=== 开始路径前缀测试 ===" << std::endl;
+    router table;
+    assert(table.insert("example.com", "/api", 1));
+    assert(table.insert("example.com", "/api/v2", 2));
+    assert(table.insert("example.com", "/app", 3));
+    assert(table.insert("example.com", "/", 4));
+    assert(table.insert("*.example.com", "/static", 5));
+
+    // 重复添加，以后者为准
+    assert(table.insert("example.com", "/api", 6));
+
+    assert(table.find("example.com", "/api/v1/users") == 6);
+    assert(table.find("example.com", "/api/v2/users") == 2);
+    assert(table.find("example.com", "/apps") == 3);
+    assert(table.find("example.com", "/ap") == 4);
+    assert(table.find("example.com", "/") == 4);
+    assert(table.find("example.com", "") == router::npos);
+    assert(table.find("cdn.example.com", "/static/a.css") == 5);
+    assert(table.find("cdn.example.com", "/index.html") == router::npos);
+
+    std::cout << "路径前缀测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试数百个虚拟主机全部可查，互不干扰
+ */
+void test_many_hosts()
+{
+    std::cout << "=== 开始多虚拟主机测试 ===" << std::endl;
+    router table;
+    for (std::uint32_t i = 0; i < 500; ++i)
+    {
+        const auto host = "site" + std::to_string(i) + ".example" + std::to_string(i % 7) + ".com";
+        assert(table.insert(host, "/", i));
+        assert(table.insert(host, "/api/", 1000 + i));
+    }
+    assert(table.insert("*.example3.com", "", 9999));
+
+    for (std::uint32_t i = 0; i < 500; ++i)
+    {
+        const auto host = "site" + std::to_string(i) + ".example" + std::to_string(i % 7) + ".com";
+        assert(table.find(host, "/index.html") == i);
+        assert(table.find(host, "/api/users") == 1000 + i);
+    }
+    assert(table.find("unknown.example3.com", "/") == 9999);
+    assert(table.find("Site123.example4.com:443", "/api/orders/42") == 1123);
+
+    std::cout << "多虚拟主机测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "反向代理路由表模块测试启动..." << std::endl;
+
+    try
+    {
+        test_host_match();
+        test_host_normalization();
+        test_invalid_host();
+        test_path_prefix();
+        test_many_hosts();
+
+        std::cout << "\n所有反向代理路由表测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include <agent/shaper.hpp>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <vector>
+
+using ngx::agent::option;
+using ngx::agent::shaper;
+
+/**
+ * @brief 测试单个桶：满桶授权一个桶深，扣除后按速率恢复
+ * @details 全部使用固定时刻，结果与运行快慢无关。
+ */
+void test_bucket()
+{
+    std::cout << "=== 开始令牌桶测试 ===" << std::endl;
+    const shaper::rate limit(1000000, std::chrono::milliseconds(100));
+    shaper::bucket meter;
+    const auto time = shaper::now();
+    assert(meter.allowance(limit, time) == 100000);
+    assert(meter.delay(limit, 4096, time) == 0);
+
+    meter.charge(limit, 100000, time);
+    assert(meter.allowance(limit, time) == 0);
+    assert(meter.delay(limit, 10000, time) == 10000000);
+    assert(meter.allowance(limit, time + 50000000) == 50000);
+
+    // 长时间空闲后不会超过桶深
+    assert(meter.allowance(limit, time + 10000000000) == 100000);
+
+    // 桶深不足 16 KiB 时抬高
+    const shaper::rate tiny(1000, std::chrono::milliseconds(100));
+    shaper::bucket small;
+    assert(small.allowance(tiny, time) == 16384);
+
+    std::cout << "令牌桶测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试默认构造的通道不限制
+ */
+void test_unlimited_lane()
+{
+    std::cout << "=== 开始不限制通道测试 ===" << std::endl;
+    const option::shaping_option opt{};
+    assert(!shaper::enabled(opt));
+    const shaper::lane lane;
+    assert(!lane);
+    assert(lane.grant(65536) == 65536);
+
+    std::cout << "不限制通道测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试层级：监听器由全部会话共享，会话级各自独立，客户端层级由外部提供
+ * @details 每次扣除都远超补充一个最小单元所需的令牌，断言不受测试运行快慢影响。
+ */
+void test_levels()
+{
+    std::cout << "=== 开始层级整形测试 ===" << std::endl;
+    option::shaping_option opt{};
+    opt.listener = 1000000;
+    opt.session = 20000;
+    opt.burst = std::chrono::milliseconds(100);
+    assert(shaper::enabled(opt));
+    shaper shaping(opt);
+
+    shaper::lane first(&shaping, {});
+    shaper::lane second(&shaping, {});
+    assert(first && second);
+
+    // 会话级桶深 2000 字节，不足 16 KiB 下限时取下限
+    assert(first.grant(65536) == 16384);
+    first.charge(16384);
+    assert(first.grant(65536) == 0);
+    assert(second.grant(65536) == 16384);
+
+    // 监听器被其他会话用完后，所有会话都要等待
+    for (int i = 0; i < 10; ++i)
+    {
+        shaper::lane other(&shaping, {});
+        other.charge(100000);
+    }
+    assert(second.grant(65536) == 0);
+
+    const shaper::rate client_limit(50000, std::chrono::seconds(1));
+    shaper::bucket client_meter;
+    shaper::lane limited(nullptr, shaper::level{&client_meter, &client_limit});
+    assert(limited);
+    assert(limited.grant(65536) == 50000);
+    limited.charge(100000);
+    assert(limited.grant(65536) == 0);
+
+    std::cout << "层级整形测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试全局层级由调用方持有：引用同一个 `budget` 的整形器共享限额，构造其他整形器不影响它
+ */
+void test_shared_global()
+{
+    std::cout << "=== 开始全局层级测试 ===" << std::endl;
+    shaper::budget global(50000, std::chrono::seconds(1));
+
+    option::shaping_option first_opt{};
+    first_opt.session = 1000000;
+    shaper first(first_opt, global.view());
+
+    option::shaping_option second_opt{};
+    second_opt.listener = 1000000;
+    shaper second(second_opt, global.view());
+
+    shaper::lane a(&first, {});
+    shaper::lane b(&second, {});
+    assert(a.grant(65536) == 50000);
+    assert(b.grant(65536) == 50000);
+
+    // 一个整形器上的会话用完全局限额后，另一个整形器上的会话也要等待
+    a.charge(100000);
+    assert(b.grant(65536) == 0);
+
+    // 不带全局层级的整形器既不受它限制，也不会重置它
+    shaper isolated(first_opt);
+    shaper::lane c(&isolated, {});
+    assert(c.grant(65536) == 65536);
+    assert(b.grant(65536) == 0);
+
+    std::cout << "全局层级测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试唤醒时刻对齐到刻度，大量等待中的会话集中在少数几个时刻
+ * @details 上下界都由测试前后实际读取的时钟推出，不依赖运行快慢。
+ */
+void test_wake_alignment()
+{
+    std::cout << "=== 开始唤醒对齐测试 ===" << std::endl;
+    option::shaping_option opt{};
+    opt.session = 1000000;
+    opt.burst = std::chrono::milliseconds(100);
+    opt.tick = std::chrono::milliseconds(10);
+    shaper shaping(opt);
+
+    constexpr std::size_t count = 1000;
+    std::vector<std::unique_ptr<shaper::lane>> lanes;
+    lanes.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        lanes.push_back(std::make_unique<shaper::lane>(&shaping, shaper::level{}));
+    }
+
+    // 扣空会话级桶：再攒一个最小单元（4096 字节）需要 4.096ms
+    const auto unit = std::chrono::microseconds(4096);
+    const auto tick = std::chrono::milliseconds(10);
+    const auto before = std::chrono::steady_clock::now();
+    for (auto &lane : lanes)
+    {
+        lane->charge(100000);
+        assert(lane->grant(16384) == 0);
+    }
+
+    std::set<std::chrono::steady_clock::time_point> moments;
+    for (auto &lane : lanes)
+    {
+        const auto wake = lane->wake(16384);
+        assert(wake.time_since_epoch() % tick == std::chrono::nanoseconds(0));
+        assert(wake >= before + unit);
+        moments.insert(wake);
+    }
+    const auto after = std::chrono::steady_clock::now();
+    assert(*moments.rbegin() < after + unit + tick);
+
+    // 全部落在 [before + unit, after + unit + tick) 内的刻度上
+    const auto span = (after - before) / tick;
+    assert(moments.size() <= static_cast<std::size_t>(span) + 2);
+
+    std::cout << "唤醒对齐测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试长期速率：四个会话轮流从同一个桶取令牌，虚拟时间推进一秒后总量等于速率加桶深
+ */
+void test_long_term_rate()
+{
+    std::cout << "=== 开始长期速率测试 ===" << std::endl;
+    const shaper::rate limit(2000000, std::chrono::milliseconds(50));
+    shaper::bucket shared;
+    const auto origin = shaper::now();
+
+    std::size_t total = 0;
+    for (std::int64_t step = 0; step < 1000; ++step)
+    {
+        const auto time = origin + step * 1000000;
+        for (int session = 0; session < 4; ++session)
+        {
+            const auto granted = std::min<std::size_t>(shared.allowance(limit, time), 16384);
+            shared.charge(limit, granted, time);
+            total += granted;
+        }
+    }
+
+    // 初始桶深 100000 字节，之后 999ms 每毫秒补充 2000 字节
+    assert(total == 100000 + 999 * 2000);
+
+    std::cout << "长期速率测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "带宽整形模块测试启动..." << std::endl;
+
+    try
+    {
+        test_bucket();
+        test_unlimited_lane();
+        test_levels();
+        test_shared_global();
+        test_wake_alignment();
+        test_long_term_rate();
+
+        std::cout << "\n所有带宽整形测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
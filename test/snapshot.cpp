@@ -0,0 +1,65 @@
+#include <agent/snapshot.hpp>
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using ngx::agent::snapshot;
+
+namespace
+{
+    /**
+     * @brief 快照内容：两个字段总是一起写入，读者看到不一致即说明读到了半成品
+     */
+    struct table
+    {
+        std::uint64_t version = 0;
+        std::uint64_t check = 0;
+    };
+}
+
+int main()
+{
+    std::cout << "[Test] snapshot: publish while readers load" << std::endl;
+
+    snapshot<table> current(std::make_shared<const table>());
+    assert(current.load().version == 0);
+
+    current.publish(std::make_shared<const table>(table{1, ~1ull}));
+    assert(current.load().version == 1);
+
+    // 两个实例互不串用同一线程的缓存
+    snapshot<table> other(std::make_shared<const table>(table{7, ~7ull}));
+    assert(other.load().version == 7);
+    assert(current.load().version == 1);
+
+    std::atomic<bool> done{false};
+    std::vector<std::jthread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&]
+        {
+            std::uint64_t last = 0;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                const auto &view = current.load();
+                assert(view.check == ~view.version);
+                assert(view.version >= last); // 同一线程看到的版本不回退
+                last = view.version;
+            }
+        });
+    }
+
+    for (std::uint64_t version = 2; version < 20000; ++version)
+    {
+        current.publish(std::make_shared<const table>(table{version, ~version}));
+    }
+    done = true;
+    readers.clear();
+
+    assert(current.load().version == 19999);
+    std::cout << "[Test] snapshot: passed" << std::endl;
+    return 0;
+}
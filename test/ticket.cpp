@@ -0,0 +1,139 @@
+#include <agent/ticket.hpp>
+#include "certificate.hpp"
+#include <boost/asio.hpp>
+#include <boost/asio/ssl.hpp>
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+namespace net = boost::asio;
+namespace ssl = boost::asio::ssl;
+using tcp = net::ip::tcp;
+using ngx::agent::keyring;
+using ngx::agent::resumption;
+
+namespace
+{
+    constexpr char host[] = "ticket.test";
+}
+
+/**
+ * @brief 在回环上完成一次 TLS 握手并交换一个字节
+ * @param client_max 客户端允许的最高版本
+ * @return 客户端与服务端是否都报告会话被恢复
+ * @details 服务端先写一个字节，客户端读到它时 TLS 1.3 握手后下发的票据也已处理完毕。
+ */
+bool connect_once(ssl::context &server_ctx, ssl::context &client_ctx, const int client_max)
+{
+    net::io_context ioc;
+    tcp::acceptor acceptor(ioc, tcp::endpoint(net::ip::make_address("127.0.0.1"), 0));
+
+    bool server_reused = false;
+    std::thread server([&]
+    {
+        ssl::stream<tcp::socket> stream(acceptor.accept(), server_ctx);
+        stream.handshake(ssl::stream_base::server);
+        server_reused = SSL_session_reused(stream.native_handle()) == 1;
+        char byte = 'x';
+        net::write(stream, net::buffer(&byte, 1));
+        net::read(stream, net::buffer(&byte, 1));
+    });
+
+    ssl::stream<tcp::socket> stream(ioc, client_ctx);
+    stream.next_layer().connect(acceptor.local_endpoint());
+    SSL_set_max_proto_version(stream.native_handle(), client_max);
+    SSL_set_tlsext_host_name(stream.native_handle(), host);
+    resumption::resume(stream.native_handle(), host);
+    stream.handshake(ssl::stream_base::client);
+    const bool client_reused = SSL_session_reused(stream.native_handle()) == 1;
+
+    char byte = 0;
+    net::read(stream, net::buffer(&byte, 1));
+    net::write(stream, net::buffer(&byte, 1));
+    server.join();
+
+    assert(client_reused == server_reused);
+    return client_reused;
+}
+
+/**
+ * @brief 测试密钥环：轮换后旧密钥仍可查到但不再是签发密钥，超出保留数量的密钥被丢弃
+ */
+void test_keyring()
+{
+    std::cout << "=== 开始票据密钥环测试 ===" << std::endl;
+    keyring ring(2);
+    const auto first = ring.current();
+
+    keyring::key found;
+    bool fresh = false;
+    assert(ring.find(first.name.data(), found, fresh) && fresh);
+    assert(found.cipher == first.cipher && found.mac == first.mac);
+
+    ring.rotate();
+    const auto second = ring.current();
+    assert(second.name != first.name);
+    assert(ring.find(first.name.data(), found, fresh) && !fresh);
+    assert(ring.find(second.name.data(), found, fresh) && fresh);
+
+    ring.rotate();
+    assert(!ring.find(first.name.data(), found, fresh));
+    assert(ring.find(second.name.data(), found, fresh) && !fresh);
+
+    std::cout << "票据密钥环测试通过！" << std::endl;
+}
+
+/**
+ * @brief 测试会话恢复：第二次握手恢复会话，轮换后旧密钥签发的票据仍可恢复，密钥退役后回到完整握手
+ * @param client_max 客户端允许的最高版本（TLS 1.2 与 TLS 1.3 的票据流程不同）
+ */
+void test_resumption(const int client_max)
+{
+    std::cout << "=== 开始会话恢复测试 (" << (client_max == TLS1_3_VERSION ? "TLS 1.3" : "TLS 1.2") << ") ===" << std::endl;
+    ssl::context server_ctx(ssl::context::tls_server);
+    ngx::agent::modernize(server_ctx);
+    issue(server_ctx);
+    keyring ring(2);
+    ring.install(server_ctx);
+
+    ssl::context client_ctx(ssl::context::tls_client);
+    client_ctx.set_verify_mode(ssl::verify_none);
+    resumption cache;
+    cache.install(client_ctx);
+
+    assert(!connect_once(server_ctx, client_ctx, client_max));
+    assert(connect_once(server_ctx, client_ctx, client_max));
+
+    // 缓存中的票据由上一个密钥签发，轮换一次后仍在保留期内
+    ring.rotate();
+    assert(connect_once(server_ctx, client_ctx, client_max));
+
+    // 上一次恢复已换发新密钥签发的票据，再轮换两次后该密钥退役
+    ring.rotate();
+    ring.rotate();
+    assert(!connect_once(server_ctx, client_ctx, client_max));
+    assert(connect_once(server_ctx, client_ctx, client_max));
+
+    std::cout << "会话恢复测试通过！" << std::endl;
+}
+
+int main()
+{
+    std::cout << "会话票据模块测试启动..." << std::endl;
+
+    try
+    {
+        test_keyring();
+        test_resumption(TLS1_3_VERSION);
+        test_resumption(TLS1_2_VERSION);
+
+        std::cout << "\n所有会话票据测试全部通过！" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "测试过程中捕获到异常: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
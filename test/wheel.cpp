@@ -0,0 +1,89 @@
+#include <agent/wheel.hpp>
+#include <boost/asio.hpp>
+#include <array>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+namespace net = boost::asio;
+using ngx::agent::wheel;
+
+int main()
+{
+    std::cout << "[Test] wheel: ordering, cascade, cancel and re-arm" << std::endl;
+
+    net::io_context ioc;
+    wheel timer(ioc, std::chrono::milliseconds(1));
+
+    // 覆盖近端槽位、第一层与第二层远端槽位（需要级联才能触发）
+    const std::array<std::uint64_t, 5> offsets{3, 40, 255, 300, 1500};
+    std::array<wheel::entry, 5> entries;
+    std::vector<std::size_t> fired;
+    std::vector<std::uint64_t> fired_at;
+
+    for (std::size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i].callback([&, i]()
+        {
+            fired.push_back(i);
+            fired_at.push_back(timer.now());
+        });
+        timer.arm(entries[i], timer.now() + offsets[i]);
+        assert(entries[i].armed());
+    }
+
+    // 撤销一项，它不应触发
+    timer.cancel(entries[1]);
+    assert(!entries[1].armed());
+
+    // 改期：把最早的一项推迟到最后
+    timer.arm(entries[0], timer.now() + 1600);
+
+    // 析构时自动撤销
+    {
+        wheel::entry scoped;
+        scoped.callback([]()
+        {
+            assert(false && "destroyed entry must not fire");
+        });
+        timer.arm(scoped, timer.now() + 10);
+    }
+
+    // 回调里再次布防
+    wheel::entry again;
+    int rounds = 0;
+    again.callback([&]()
+    {
+        if (++rounds < 3)
+        {
+            timer.arm(again, timer.now() + 5);
+        }
+    });
+    timer.arm(again, timer.now() + 5);
+
+    net::steady_timer stop(ioc, std::chrono::milliseconds(1800));
+    stop.async_wait([&](const boost::system::error_code &)
+    {
+        timer.stop();
+    });
+
+    timer.start();
+    ioc.run();
+
+    const std::vector<std::size_t> expected{2, 3, 4, 0};
+    assert(fired == expected);
+    for (std::size_t i = 0; i < fired.size(); ++i)
+    {   // 触发刻度不早于截止刻度
+        const auto deadline = fired[i] == 0 ? 1600 : offsets[fired[i]];
+        assert(fired_at[i] >= deadline);
+    }
+    assert(rounds == 3);
+    for (const auto &item : entries)
+    {
+        assert(!item.armed());
+    }
+
+    std::cout << "[Test] wheel passed" << std::endl;
+    return 0;
+}